@@ -0,0 +1,338 @@
+/*!
+ *  \file    bench_bus.c
+ *  \author  Tycho Jobsis
+ *  \date    04-04-2021
+ *  \version 0.1.0
+ *
+ *  \brief   Bus cost benchmark of the MPU6050 library
+ *
+ *  \details Runs the public functions of the library against the simulated MPU6050 with a 100kHz and a 400kHz bus.
+ *			 For every function the transactions, the bytes on the bus, the bus time and the host CPU time per call
+ *			 are printed as a table or as JSON. The bus time is modelled as 9 clocks per byte plus the start and stop
+ *			 condition. The CPU time includes the time of the simulation. Calls that do not return 0 are counted
+ *			 as failures, the benchmark exits with 1 if there are any. With MPU6050_STATS stats_snapshot_mpu6050
+ *			 is measured as well. read_async_mpu6050 is finished with sim_isr_async_mpu6050 in the same call.
+ *			 The calibration record is stored in bench_bus.cal in the working directory, it is removed afterwards.
+ *
+ *			 Left out on purpose: init_mpu6050, twi_isr_async_mpu6050 and the acq_xxx_mpu6050 functions are only
+ *			 compiled for the Xmega, acq_isr_mpu6050 does the same read as the read_async_mpu6050 case. The
+ *			 conversion functions (xxx_raw_to_xxx, motion_to_fixed_mpu6050) and the self tests do not use the bus.
+ *
+ *	\code{.sh}
+ 	gcc -O2 -std=gnu99 [-DMPU6050_STATS] -I.. -o bench_bus bench_bus.c ../mpu6050.c ../mpu6050_dmp.c ../mpu6050_sim.c ../mpu6050_store.c -lm
+ 	./bench_bus [--json]
+ 	\endcode
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "mpu6050.h"
+#include "mpu6050_dmp.h"
+#include "mpu6050_sim.h"
+#include "mpu6050_store.h"
+
+#define CAL_FILE	"bench_bus.cal"
+
+/*! \brief  One benchmarked function
+ *
+ *	prep is called before every call of run and is not measured, it can be 0.
+ */
+typedef struct {
+	const char *name;
+	uint16_t calls;
+	void (*prep)(mpu6050_dev_t *dev, uint16_t i);
+	uint8_t (*run)(mpu6050_dev_t *dev, uint16_t i);
+} bench_case_t;
+
+static mpu6050_sim_t sim;
+static const mpu6050_store_t store = { store_file_read_mpu6050, store_file_write_mpu6050, (void *) CAL_FILE };
+static uint8_t buff[MPU6050_FIFO_SIZE];
+static uint32_t stamps[MPU6050_FIFO_SIZE / 12];
+static uint8_t image[1024];
+
+static const uint8_t dmp_packet[MPU6050_DMP_PACKET_MAX] = {
+	0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
+static void prep_sleep(mpu6050_dev_t *dev, uint16_t i){ (void) i; sleep_mpu6050(dev); }
+static void prep_wake(mpu6050_dev_t *dev, uint16_t i){ (void) i; wake_up_mpu6050(dev); }
+static void prep_temp_off(mpu6050_dev_t *dev, uint16_t i){ (void) i; disable_temp_mpu6050(dev); }
+static void prep_temp_on(mpu6050_dev_t *dev, uint16_t i){ (void) i; enable_temp_mpu6050(dev); }
+static void prep_int_off(mpu6050_dev_t *dev, uint16_t i){ (void) i; int_disable_mpu6050(dev, DATA_RDY_INT_EN); }
+static void prep_int_on(mpu6050_dev_t *dev, uint16_t i){ (void) i; int_enable_mpu6050(dev, DATA_RDY_INT_EN); }
+static void prep_fifo(mpu6050_dev_t *dev, uint16_t i){
+	if(i == 0){
+		set_dlpf_mpu6050(dev, MPU6050_DLPF_44);
+		set_sample_rate_mpu6050(dev, 100);
+		fifo_enable_mpu6050(dev, MPU6050_FIFO_ACCEL_bm | MPU6050_FIFO_GYRO_bm);
+	}
+	fifo_reset_mpu6050(dev);	//!< Frames that were sampled during the previous drain
+	sim_step_mpu6050(&sim, 10 * sim_period_us_mpu6050(&sim));
+}
+static void prep_lp_on(mpu6050_dev_t *dev, uint16_t i){ (void) i; lp_accel_mode_mpu6050(dev, MPU6050_LP_WAKE_5HZ); }
+static void prep_lp_off(mpu6050_dev_t *dev, uint16_t i){ (void) i; lp_accel_exit_mpu6050(dev); }
+static void prep_stuck(mpu6050_dev_t *dev, uint16_t i){ (void) dev; (void) i; sim.stuck = 1; }
+static void prep_dmp_on(mpu6050_dev_t *dev, uint16_t i){ (void) i; dmp_enable_mpu6050(dev, MPU6050_DMP_QUAT_bm); }
+static void prep_store(mpu6050_dev_t *dev, uint16_t i){ (void) i; dev->store = &store; }
+static void prep_aux_on(mpu6050_dev_t *dev, uint16_t i){ (void) i; aux_master_enable_mpu6050(dev, MPU6050_AUX_CLK_400KHZ); }
+static void prep_aux_off(mpu6050_dev_t *dev, uint16_t i){ (void) i; aux_master_disable_mpu6050(dev); }
+static void prep_dmp(mpu6050_dev_t *dev, uint16_t i){
+	if(i == 0) dmp_enable_mpu6050(dev, MPU6050_DMP_QUAT_bm | MPU6050_DMP_ACCEL_bm | MPU6050_DMP_GYRO_bm);
+	sim_fifo_push_mpu6050(&sim, dmp_packet, sizeof(dmp_packet));
+}
+
+static uint8_t run_enable(mpu6050_dev_t *dev, uint16_t i){ (void) i; return enable_mpu6050(dev); }
+static uint8_t run_disable(mpu6050_dev_t *dev, uint16_t i){ (void) i; return disable_mpu6050(dev); }
+static uint8_t run_wake_up(mpu6050_dev_t *dev, uint16_t i){ (void) i; return wake_up_mpu6050(dev); }
+static uint8_t run_sleep(mpu6050_dev_t *dev, uint16_t i){ (void) i; return sleep_mpu6050(dev); }
+static uint8_t run_accel_x_raw(mpu6050_dev_t *dev, uint16_t i){ int16_t v; (void) i; return get_accel_x_raw_mpu6050(dev, &v); }
+static uint8_t run_gyro_x_raw(mpu6050_dev_t *dev, uint16_t i){ int16_t v; (void) i; return get_gyro_x_raw_mpu6050(dev, &v); }
+static uint8_t run_accel_x(mpu6050_dev_t *dev, uint16_t i){ float v; (void) i; return get_accel_x_mpu6050(dev, &v); }
+static uint8_t run_gyro_x(mpu6050_dev_t *dev, uint16_t i){ float v; (void) i; return get_gyro_x_mpu6050(dev, &v); }
+static uint8_t run_temp(mpu6050_dev_t *dev, uint16_t i){ float v; (void) i; return get_temp_mpu6050(dev, &v); }
+static uint8_t run_all_axes(mpu6050_dev_t *dev, uint16_t i){
+	float v;
+	uint8_t err;
+	(void) i;
+	err = get_accel_x_mpu6050(dev, &v); err |= get_accel_y_mpu6050(dev, &v); err |= get_accel_z_mpu6050(dev, &v);
+	err |= get_gyro_x_mpu6050(dev, &v); err |= get_gyro_y_mpu6050(dev, &v); err |= get_gyro_z_mpu6050(dev, &v);
+	return err | get_temp_mpu6050(dev, &v);
+}
+static uint8_t run_motion6(mpu6050_dev_t *dev, uint16_t i){ mpu6050_motion_t m; (void) i; return get_motion6_raw_mpu6050(dev, &m); }
+static uint8_t run_motion7(mpu6050_dev_t *dev, uint16_t i){ mpu6050_motion_t m; (void) i; return get_motion7_raw_mpu6050(dev, &m); }
+static uint8_t run_motion_fixed(mpu6050_dev_t *dev, uint16_t i){ mpu6050_motion_fixed_t m; (void) i; return get_motion_fixed_mpu6050(dev, &m); }
+static uint8_t run_int_enable(mpu6050_dev_t *dev, uint16_t i){ (void) i; return int_enable_mpu6050(dev, DATA_RDY_INT_EN); }
+static uint8_t run_int_disable(mpu6050_dev_t *dev, uint16_t i){ (void) i; return int_disable_mpu6050(dev, DATA_RDY_INT_EN); }
+static uint8_t run_what_happend(mpu6050_dev_t *dev, uint16_t i){
+	uint8_t ret = what_happend_mpu6050(dev);
+	(void) i;
+	return (ret == 1 || ret == 2) ? ret : 0;	//!< Higher values are interrupt flags
+}
+static uint8_t run_ext_sens(mpu6050_dev_t *dev, uint16_t i){ uint8_t v; (void) i; return ext_sens_value_mpu6050(dev, MPU_6050_EXT_SENS_DATA_00, &v); }
+static uint8_t run_ext_read(mpu6050_dev_t *dev, uint16_t i){ (void) i; return ext_sens_read_mpu6050(dev, 0, buff, 6); }
+static uint8_t run_motion_ext(mpu6050_dev_t *dev, uint16_t i){ mpu6050_motion_t m; (void) i; return get_motion_ext_raw_mpu6050(dev, &m, buff, 6); }
+static uint8_t run_temp_disable(mpu6050_dev_t *dev, uint16_t i){ (void) i; return disable_temp_mpu6050(dev); }
+static uint8_t run_temp_enable(mpu6050_dev_t *dev, uint16_t i){ (void) i; return enable_temp_mpu6050(dev); }
+static uint8_t run_reset(mpu6050_dev_t *dev, uint16_t i){ (void) i; return reset_mpu6050(dev); }
+static uint8_t run_resync(mpu6050_dev_t *dev, uint16_t i){ (void) i; return resync_mpu6050(dev); }
+static uint8_t run_reset_accel(mpu6050_dev_t *dev, uint16_t i){ (void) i; return reset_accel_mpu6050(dev); }
+static uint8_t run_clk_sel(mpu6050_dev_t *dev, uint16_t i){ return clk_sel_mpu6050(dev, i & 1); }
+static uint8_t run_dlpf(mpu6050_dev_t *dev, uint16_t i){ return set_dlpf_mpu6050(dev, (i & 1) ? MPU6050_DLPF_44 : MPU6050_DLPF_94); }
+static uint8_t run_sample_rate(mpu6050_dev_t *dev, uint16_t i){ return set_sample_rate_mpu6050(dev, (i & 1) ? 100 : 200); }
+static uint8_t run_get_sample_rate(mpu6050_dev_t *dev, uint16_t i){ uint16_t hz; (void) i; return get_sample_rate_mpu6050(dev, &hz); }
+static uint8_t run_data_ready(mpu6050_dev_t *dev, uint16_t i){ uint8_t r; (void) i; return data_ready_mpu6050(dev, &r); }
+static uint8_t run_accel_scale(mpu6050_dev_t *dev, uint16_t i){ return accel_set_scale_mpu6050(dev, (i & 1) ? MPU6050_ACCEL_SCL_4G : MPU6050_ACCEL_SCL_2G); }
+static uint8_t run_accel_get_scale(mpu6050_dev_t *dev, uint16_t i){ uint8_t s; (void) i; return accel_get_scale_mpu6050(dev, &s); }
+static uint8_t run_gyro_scale(mpu6050_dev_t *dev, uint16_t i){ return gyro_set_scale_mpu6050(dev, (i & 1) ? MPU6050_GYRO_SCL_500 : MPU6050_GYRO_SCL_250); }
+static uint8_t run_gyro_get_scale(mpu6050_dev_t *dev, uint16_t i){ uint8_t s; (void) i; return gyro_get_scale_mpu6050(dev, &s); }
+static uint8_t run_calibrate(mpu6050_dev_t *dev, uint16_t i){ (void) i; return calibrate_mpu6050(dev, MPU6050_CAL_SAMPLES); }
+static uint8_t run_hw_program(mpu6050_dev_t *dev, uint16_t i){ (void) i; return hw_offsets_program_mpu6050(dev); }
+static uint8_t run_hw_read(mpu6050_dev_t *dev, uint16_t i){ int16_t a[3], g[3]; (void) i; return hw_offsets_read_mpu6050(dev, a, g); }
+static uint8_t run_calibrate_gyro_x(mpu6050_dev_t *dev, uint16_t i){ (void) i; return calibrate_gyro_x_mpu6050(dev); }
+static uint8_t run_calibrate_accel_x(mpu6050_dev_t *dev, uint16_t i){ (void) i; return calibrate_accel_x_mpu6050(dev); }
+static uint8_t run_stdby_all(mpu6050_dev_t *dev, uint16_t i){ return stdby_all_mpu6050(dev, i & 1); }
+static uint8_t run_stdby_accel_x(mpu6050_dev_t *dev, uint16_t i){ return stdby_accel_x_mpu6050(dev, i & 1); }
+static uint8_t run_fifo_enable(mpu6050_dev_t *dev, uint16_t i){ return fifo_enable_mpu6050(dev, (i & 1) ? MPU6050_FIFO_ACCEL_bm : MPU6050_FIFO_GYRO_bm); }
+static uint8_t run_fifo_reset(mpu6050_dev_t *dev, uint16_t i){ (void) i; return fifo_reset_mpu6050(dev); }
+static uint8_t run_fifo_count(mpu6050_dev_t *dev, uint16_t i){ uint16_t c; (void) i; return fifo_count_mpu6050(dev, &c); }
+static uint8_t run_fifo_drain(mpu6050_dev_t *dev, uint16_t i){ uint16_t f; (void) i; return fifo_drain_mpu6050(dev, buff, 10, &f); }
+static uint8_t run_fifo_stamped(mpu6050_dev_t *dev, uint16_t i){ uint16_t f; (void) i; return fifo_drain_stamped_mpu6050(dev, buff, stamps, 10, &f); }
+static uint8_t run_lp_mode(mpu6050_dev_t *dev, uint16_t i){ (void) i; return lp_accel_mode_mpu6050(dev, MPU6050_LP_WAKE_5HZ); }
+static uint8_t run_lp_exit(mpu6050_dev_t *dev, uint16_t i){ (void) i; return lp_accel_exit_mpu6050(dev); }
+static uint8_t run_motion_set(mpu6050_dev_t *dev, uint16_t i){ return motion_set_mpu6050(dev, (i & 1) ? 100 : 200, 10); }
+static uint8_t run_motion_idle(mpu6050_dev_t *dev, uint16_t i){ return motion_idle_mpu6050(dev, (i & 1) ? 100 : 200, 10, MPU6050_LP_WAKE_5HZ); }
+static uint8_t run_motion_event(mpu6050_dev_t *dev, uint16_t i){ uint8_t s; (void) i; return motion_event_mpu6050(dev, &s); }
+static uint8_t run_aux_enable(mpu6050_dev_t *dev, uint16_t i){ (void) i; return aux_master_enable_mpu6050(dev, MPU6050_AUX_CLK_400KHZ); }
+static uint8_t run_aux_disable(mpu6050_dev_t *dev, uint16_t i){ (void) i; return aux_master_disable_mpu6050(dev); }
+static uint8_t run_aux_read(mpu6050_dev_t *dev, uint16_t i){ return aux_slave_read_mpu6050(dev, 0, 0x1E, 0x03, (i & 1) ? 6 : 4); }
+static uint8_t run_aux_write(mpu6050_dev_t *dev, uint16_t i){ return aux_slave_write_mpu6050(dev, 1, 0x1E, 0x02, i & 1); }
+static uint8_t run_aux_slave_off(mpu6050_dev_t *dev, uint16_t i){ (void) i; return aux_slave_disable_mpu6050(dev, 0); }
+static uint8_t run_aux_rate(mpu6050_dev_t *dev, uint16_t i){ return aux_set_rate_mpu6050(dev, 0x01, (i & 1) ? 4 : 2); }
+static uint8_t run_read_async(mpu6050_dev_t *dev, uint16_t i){
+	(void) i;
+	if(read_async_mpu6050(dev, MPU_6050_ACCEL_XOUT_H, buff, MPU6050_MOTION_BYTES, 0) != 0) return 1;
+	sim_isr_async_mpu6050(&sim);
+	return async_status_mpu6050(dev);
+}
+static uint8_t run_recover(mpu6050_dev_t *dev, uint16_t i){ (void) i; return recover_bus_mpu6050(dev); }
+static uint8_t run_int_status(mpu6050_dev_t *dev, uint16_t i){ uint8_t s; (void) i; return int_status_mpu6050(dev, &s); }
+static uint8_t run_hw_write(mpu6050_dev_t *dev, uint16_t i){ (void) i; return hw_offsets_write_mpu6050(dev); }
+static uint8_t run_dmp_disable(mpu6050_dev_t *dev, uint16_t i){ (void) i; return dmp_disable_mpu6050(dev); }
+static uint8_t run_reset_gyro(mpu6050_dev_t *dev, uint16_t i){ (void) i; return reset_gyro_mpu6050(dev); }
+static uint8_t run_reset_temp(mpu6050_dev_t *dev, uint16_t i){ (void) i; return reset_temp_mpu6050(dev); }
+static uint8_t run_stdby_gyro_x(mpu6050_dev_t *dev, uint16_t i){ return stdby_gyro_x_mpu6050(dev, i & 1); }
+static uint8_t run_stdby_gyro_y(mpu6050_dev_t *dev, uint16_t i){ return stdby_gyro_y_mpu6050(dev, i & 1); }
+static uint8_t run_stdby_gyro_z(mpu6050_dev_t *dev, uint16_t i){ return stdby_gyro_z_mpu6050(dev, i & 1); }
+static uint8_t run_calibrate_save(mpu6050_dev_t *dev, uint16_t i){
+	uint8_t err;
+	(void) i;
+	err = calibrate_mpu6050(dev, MPU6050_CAL_SAMPLES);
+	if(err != 0) return err;
+	return calib_save_mpu6050(dev);
+}
+static uint8_t run_calib_load(mpu6050_dev_t *dev, uint16_t i){ (void) i; return calib_load_mpu6050(dev); }
+#ifdef MPU6050_STATS
+static uint8_t run_stats(mpu6050_dev_t *dev, uint16_t i){ mpu6050_stats_t s; (void) i; stats_snapshot_mpu6050(dev, &s); return 0; }
+#endif
+static uint8_t run_dmp_load(mpu6050_dev_t *dev, uint16_t i){ (void) i; return dmp_load_mpu6050(dev, image, sizeof(image), 0x0400); }
+static uint8_t run_dmp_rate(mpu6050_dev_t *dev, uint16_t i){ return dmp_set_rate_mpu6050(dev, (i & 1) ? 100 : 50); }
+static uint8_t run_dmp_read(mpu6050_dev_t *dev, uint16_t i){ mpu6050_dmp_packet_t p; uint16_t c; (void) i; return dmp_read_mpu6050(dev, &p, 1, &c); }
+
+static const bench_case_t cases[] = {
+	{ "enable_mpu6050",				1,		0,				run_enable },
+	{ "disable_mpu6050",			1,		0,				run_disable },
+	{ "wake_up_mpu6050",			100,	prep_sleep,		run_wake_up },
+	{ "sleep_mpu6050",				100,	prep_wake,		run_sleep },
+	{ "get_accel_x_raw_mpu6050",	1000,	0,				run_accel_x_raw },
+	{ "get_gyro_x_raw_mpu6050",		1000,	0,				run_gyro_x_raw },
+	{ "get_accel_x_mpu6050",		1000,	0,				run_accel_x },
+	{ "get_gyro_x_mpu6050",			1000,	0,				run_gyro_x },
+	{ "get_temp_mpu6050",			1000,	0,				run_temp },
+	{ "get_x/y/z + temp (7 calls)",	1000,	0,				run_all_axes },
+	{ "get_motion6_raw_mpu6050",	1000,	0,				run_motion6 },
+	{ "get_motion7_raw_mpu6050",	1000,	0,				run_motion7 },
+	{ "get_motion_fixed_mpu6050",	1000,	0,				run_motion_fixed },
+	{ "int_enable_mpu6050",			100,	prep_int_off,	run_int_enable },
+	{ "int_disable_mpu6050",		100,	prep_int_on,	run_int_disable },
+	{ "what_happend_mpu6050",		1000,	0,				run_what_happend },
+	{ "ext_sens_value_mpu6050",		1000,	0,				run_ext_sens },
+	{ "ext_sens_read_mpu6050 (6)",	1000,	0,				run_ext_read },
+	{ "get_motion_ext_raw (6)",		1000,	0,				run_motion_ext },
+	{ "disable_temp_mpu6050",		100,	prep_temp_on,	run_temp_disable },
+	{ "enable_temp_mpu6050",		100,	prep_temp_off,	run_temp_enable },
+	{ "reset_mpu6050",				100,	0,				run_reset },
+	{ "resync_mpu6050",				100,	0,				run_resync },
+	{ "reset_accel_mpu6050",		100,	0,				run_reset_accel },
+	{ "clk_sel_mpu6050",			100,	0,				run_clk_sel },
+	{ "set_dlpf_mpu6050",			100,	0,				run_dlpf },
+	{ "set_sample_rate_mpu6050",	100,	0,				run_sample_rate },
+	{ "get_sample_rate_mpu6050",	1000,	0,				run_get_sample_rate },
+	{ "data_ready_mpu6050",			1000,	0,				run_data_ready },
+	{ "accel_set_scale_mpu6050",	100,	0,				run_accel_scale },
+	{ "accel_get_scale_mpu6050",	1000,	0,				run_accel_get_scale },
+	{ "gyro_set_scale_mpu6050",		100,	0,				run_gyro_scale },
+	{ "gyro_get_scale_mpu6050",		1000,	0,				run_gyro_get_scale },
+	{ "calibrate_mpu6050",			1,		0,				run_calibrate },
+	{ "hw_offsets_program_mpu6050",	10,		0,				run_hw_program },
+	{ "hw_offsets_read_mpu6050",	100,	0,				run_hw_read },
+	{ "calibrate_gyro_x_mpu6050",	1,		0,				run_calibrate_gyro_x },
+	{ "calibrate_accel_x_mpu6050",	1,		0,				run_calibrate_accel_x },
+	{ "stdby_all_mpu6050",			100,	0,				run_stdby_all },
+	{ "stdby_accel_x_mpu6050",		100,	0,				run_stdby_accel_x },
+	{ "fifo_enable_mpu6050",		100,	0,				run_fifo_enable },
+	{ "fifo_reset_mpu6050",			100,	0,				run_fifo_reset },
+	{ "fifo_count_mpu6050",			1000,	0,				run_fifo_count },
+	{ "fifo_drain_mpu6050 (10)",	100,	prep_fifo,		run_fifo_drain },
+	{ "fifo_drain_stamped (10)",	100,	prep_fifo,		run_fifo_stamped },
+	{ "lp_accel_mode_mpu6050",		100,	prep_lp_off,	run_lp_mode },
+	{ "lp_accel_exit_mpu6050",		100,	prep_lp_on,		run_lp_exit },
+	{ "motion_set_mpu6050",			100,	0,				run_motion_set },
+	{ "motion_idle_mpu6050",		100,	prep_lp_off,	run_motion_idle },
+	{ "motion_event_mpu6050",		1000,	0,				run_motion_event },
+	{ "aux_master_enable_mpu6050",	100,	prep_aux_off,	run_aux_enable },
+	{ "aux_master_disable_mpu6050",	100,	prep_aux_on,	run_aux_disable },
+	{ "aux_slave_read_mpu6050",		100,	prep_aux_on,	run_aux_read },
+	{ "aux_slave_write_mpu6050",	100,	prep_aux_on,	run_aux_write },
+	{ "aux_slave_disable_mpu6050",	100,	prep_aux_on,	run_aux_slave_off },
+	{ "aux_set_rate_mpu6050",		100,	prep_aux_on,	run_aux_rate },
+	{ "read_async_mpu6050 (14)",	1000,	0,				run_read_async },
+	{ "recover_bus_mpu6050",		100,	prep_stuck,		run_recover },
+	{ "int_status_mpu6050",			1000,	0,				run_int_status },
+	{ "hw_offsets_write_mpu6050",	100,	0,				run_hw_write },
+	{ "dmp_disable_mpu6050",		100,	prep_dmp_on,	run_dmp_disable },
+	{ "reset_gyro_mpu6050",			100,	0,				run_reset_gyro },
+	{ "reset_temp_mpu6050",			100,	0,				run_reset_temp },
+	{ "stdby_gyro_x_mpu6050",		100,	0,				run_stdby_gyro_x },
+	{ "stdby_gyro_y_mpu6050",		100,	0,				run_stdby_gyro_y },
+	{ "stdby_gyro_z_mpu6050",		100,	0,				run_stdby_gyro_z },
+	{ "calibrate + calib_save",		1,		prep_store,		run_calibrate_save },
+	{ "calib_load_mpu6050 (file)",	100,	prep_store,		run_calib_load },
+#ifdef MPU6050_STATS
+	{ "stats_snapshot_mpu6050",		1000,	0,				run_stats },
+#endif
+	{ "dmp_load_mpu6050 (1KB)",		1,		0,				run_dmp_load },
+	{ "dmp_set_rate_mpu6050",		100,	0,				run_dmp_rate },
+	{ "dmp_read_mpu6050 (1)",		100,	prep_dmp,		run_dmp_read },
+};
+
+/*! \brief  Returns the CPU time of the process in ns
+ */
+static uint64_t cpu_ns(void){
+	struct timespec ts;
+	
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+	
+	return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+int main(int argc, char **argv){
+	const uint32_t bus_hz[] = { 100000, 400000 };
+	uint8_t json = (argc > 1 && strcmp(argv[1], "--json") == 0);
+	uint8_t first = 1;
+	uint32_t failed = 0;
+	mpu6050_bus_t bus;
+	mpu6050_dev_t dev;
+	
+	for(uint16_t i = 0; i < sizeof(image); i++) image[i] = i * 7;
+	
+	if(json) printf("[\n");
+	else printf("%-30s %5s %6s %6s %10s %10s %12s %12s\n", "function", "kHz", "calls", "fails", "trans/call", "bytes/call", "bus us/call", "cpu ns/call");
+	
+	for(uint8_t b = 0; b < sizeof(bus_hz) / sizeof(bus_hz[0]); b++){
+		for(uint8_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++){
+			const bench_case_t *bc = &cases[c];
+			uint32_t transactions = 0, wire_bytes = 0, fails = 0;
+			uint64_t cpu = 0, start;
+			double calls, bus_us;
+			
+			sim_init_mpu6050(&sim, MPU6050_ADDRESS);
+			sim.accel[2] = 1.0f;
+			sim.accel_noise = 0.002f;
+			sim.gyro_noise = 0.05f;
+			sim.bus_hz = bus_hz[b];
+			sim_bus_mpu6050(&sim, &bus);
+			init_bus_mpu6050(&dev, &bus, MPU6050_ADDRESS);
+			if(bc->run != run_enable) enable_mpu6050(&dev);
+			
+			for(uint16_t i = 0; i < bc->calls; i++){
+				if(bc->prep != 0) bc->prep(&dev, i);
+				sim_clear_counters_mpu6050(&sim);
+				
+				start = cpu_ns();
+				if(bc->run(&dev, i) != 0) fails++;
+				cpu += cpu_ns() - start;
+				
+				transactions += sim.transactions;
+				wire_bytes += sim.wire_bytes;
+			}
+			
+			calls = bc->calls;
+			bus_us = ((double) wire_bytes * 9 + (double) transactions * 2) * 1e6 / bus_hz[b];
+			failed += fails;
+			
+			if(json){
+				printf("%s  {\"function\": \"%s\", \"bus_khz\": %u, \"calls\": %u, \"fails\": %u, \"transactions\": %.2f, \"bytes\": %.2f, \"bus_us\": %.1f, \"cpu_ns\": %.0f}",
+					   first ? "" : ",\n", bc->name, bus_hz[b] / 1000, bc->calls, fails, transactions / calls, wire_bytes / calls, bus_us / calls, cpu / calls);
+				first = 0;
+			}
+			else {
+				printf("%-30s %5u %6u %6u %10.2f %10.2f %12.1f %12.0f\n", bc->name, bus_hz[b] / 1000, bc->calls, fails,
+					   transactions / calls, wire_bytes / calls, bus_us / calls, cpu / calls);
+			}
+		}
+	}
+	
+	if(json) printf("\n]\n");
+	
+	remove(CAL_FILE);
+	
+	if(failed != 0){
+		fprintf(stderr, "%u calls failed\n", failed);
+		return 1;
+	}
+	
+	return 0;
+}
@@ -0,0 +1,138 @@
+/*!
+ *  \file    bench_filter.c
+ *  \author  Tycho Jobsis
+ *  \date    04-04-2021
+ *  \version 0.1.0
+ *
+ *  \brief   Host throughput benchmark of the filter stages of the MPU6050 library
+ *
+ *  \details Runs every stage and a complete chain over blocks of synthetic 1kHz motion frames with 7 channels
+ *			 and prints the input samples per second (frames times channels) of every stage. The noise column
+ *			 is the standard deviation of the output of a channel with a constant value and gaussian noise,
+ *			 the input noise is 64 LSB.
+ *
+ *	\code{.sh}
+ 	gcc -O2 -std=gnu99 -I.. -o bench_filter bench_filter.c ../mpu6050_filter.c -lm
+ 	./bench_filter [frames]
+ 	\endcode
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "mpu6050_filter.h"
+
+#define BLOCK		50		//!< Frames in one block, 50ms at 1kHz
+#define BLOCKS		256		//!< Amount of synthetic blocks, the blocks are used repeatedly
+#define FS			1000	//!< Sample rate of the synthetic frames
+#define NOISE		64.0	//!< Standard deviation of the input noise in LSB
+
+static int16_t frames[BLOCKS][BLOCK * MPU6050_FILTER_CHANNELS];
+static int16_t block[BLOCK * MPU6050_FILTER_CHANNELS];
+
+/*! \brief  Returns gaussian noise with a standard deviation of 1
+ */
+static double gauss(void){
+	double u = (rand() + 1.0) / (RAND_MAX + 2.0);
+	double v = (rand() + 1.0) / (RAND_MAX + 2.0);
+	
+	return sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * v);
+}
+
+/*! \brief  Fills the frames with 1G on z, a 5Hz rotation on the gyroscope x-axis and noise on all channels
+ */
+static void make_frames(void){
+	for(int b = 0; b < BLOCKS; b++){
+		for(int i = 0; i < BLOCK; i++){
+			int16_t *f = &frames[b][i * MPU6050_FILTER_CHANNELS];
+			double t = (double) (b * BLOCK + i) / FS;
+			
+			f[0] = (int16_t) lround(NOISE * gauss());
+			f[1] = (int16_t) lround(NOISE * gauss());
+			f[2] = (int16_t) lround(16384.0 + NOISE * gauss());
+			f[3] = (int16_t) lround(-2000.0 + NOISE * gauss());
+			f[4] = (int16_t) lround(4000.0 * sin(2.0 * M_PI * 5.0 * t) + NOISE * gauss());
+			f[5] = (int16_t) lround(NOISE * gauss());
+			f[6] = (int16_t) lround(NOISE * gauss());
+		}
+	}
+}
+
+/*! \brief  Returns a monotonic time in seconds
+ */
+static double now(void){
+	struct timespec ts;
+	
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*! \brief  Runs the stages over the frames and prints the throughput and the output noise
+ */
+static void bench(const char *name, const mpu6050_filter_stage_t *stages, uint8_t count, long total){
+	double start, sec, sum = 0.0, sum2 = 0.0;
+	long in = 0, out = 0;
+	uint16_t n;
+	
+	start = now();
+	for(long b = 0; in < total; b++){
+		memcpy(block, frames[b % BLOCKS], sizeof(block));
+		n = filter_run_mpu6050(stages, count, block, BLOCK);
+		in += BLOCK;
+		
+		for(uint16_t i = 0; i < n; i++){
+			double v = block[i * MPU6050_FILTER_CHANNELS + 5];
+			sum += v;
+			sum2 += v * v;
+		}
+		out += n;
+	}
+	sec = now() - start;
+	
+	printf("%-28s %8.1f %10.2f %8.2f\n", name, (double) in / out, in * MPU6050_FILTER_CHANNELS / sec / 1e6,
+		   sqrt(sum2 / out - (sum / out) * (sum / out)));
+}
+
+int main(int argc, char **argv){
+	long total = (argc > 1) ? atol(argv[1]) : 2000000L;
+	static mpu6050_filter_ma_t ma, avg;
+	static mpu6050_filter_biquad_t lp;
+	static mpu6050_filter_cic_t cic;
+	static mpu6050_filter_fir_t fir;
+	int32_t bq[5];
+	int16_t taps[MPU6050_FILTER_FIR_MAX];
+	
+	make_frames();
+	
+	filter_ma_init_mpu6050(&ma, MPU6050_FILTER_CHANNELS, 8, 1);
+	filter_ma_init_mpu6050(&avg, MPU6050_FILTER_CHANNELS, 10, 10);
+	filter_biquad_lowpass_mpu6050(bq, FS, 40);
+	filter_biquad_init_mpu6050(&lp, MPU6050_FILTER_CHANNELS, bq);
+	filter_cic_init_mpu6050(&cic, MPU6050_FILTER_CHANNELS, 3, 10);
+	filter_fir_lowpass_mpu6050(taps, 31, FS, 40);
+	filter_fir_init_mpu6050(&fir, MPU6050_FILTER_CHANNELS, taps, 31, 1);
+	
+	const mpu6050_filter_stage_t s_ma[] = { { MPU6050_FILTER_MA, &ma } };
+	const mpu6050_filter_stage_t s_avg[] = { { MPU6050_FILTER_MA, &avg } };
+	const mpu6050_filter_stage_t s_bq[] = { { MPU6050_FILTER_BIQUAD, &lp } };
+	const mpu6050_filter_stage_t s_cic[] = { { MPU6050_FILTER_CIC, &cic } };
+	const mpu6050_filter_stage_t s_fir[] = { { MPU6050_FILTER_FIR, &fir } };
+	const mpu6050_filter_stage_t s_chain[] = { { MPU6050_FILTER_BIQUAD, &lp }, { MPU6050_FILTER_CIC, &cic } };
+	
+	printf("frames per stage %ld, %d channels, input noise %.2f\n\n", total, MPU6050_FILTER_CHANNELS, NOISE);
+	printf("%-28s %8s %10s %8s\n", "stage", "decim", "Msample/s", "noise");
+	bench("moving average 8", s_ma, 1, total);
+	bench("block average 10 (1k->100)", s_avg, 1, total);
+	bench("biquad 40Hz", s_bq, 1, total);
+	bench("cic 3rd order (1k->100)", s_cic, 1, total);
+	bench("fir 31 taps 40Hz", s_fir, 1, total);
+	filter_fir_init_mpu6050(&fir, MPU6050_FILTER_CHANNELS, taps, 31, 10);
+	bench("fir 31 taps (1k->100)", s_fir, 1, total);
+	bench("biquad + cic (1k->100)", s_chain, 2, total);
+	
+	return 0;
+}
@@ -0,0 +1,95 @@
+/*!
+ *  \file    bench_fusion.c
+ *  \author  Tycho Jobsis
+ *  \date    04-04-2021
+ *  \version 0.1.0
+ *
+ *  \brief   Host benchmark of the fusion module of the MPU6050 library
+ *
+ *  \details Runs the fixed point and the float filter on the same synthetic frames and prints the
+ *			 updates per second of both and the largest difference between the two quaternions.
+ *
+ *	\code{.sh}
+ 	gcc -O2 -std=gnu99 -I.. -o bench_fusion bench_fusion.c ../mpu6050_fusion.c -lm
+ 	./bench_fusion [updates]
+ 	\endcode
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+#include "mpu6050_fusion.h"
+
+#define FRAMES		4096	//!< Amount of synthetic frames, the frames are used repeatedly
+#define DT_US		1000	//!< Time between two frames
+
+static int16_t accel[FRAMES][3];
+static int16_t gyro[FRAMES][3];
+
+/*! \brief  Fills the frames with a slow rotation around all axes in the +-2G and +-250 degrees per second range
+ */
+static void make_frames(void){
+	for(int i = 0; i < FRAMES; i++){
+		float t = i * DT_US * 1e-6f;
+		float roll = 0.5f * sinf(t * 1.3f);
+		float pitch = 0.3f * sinf(t * 0.7f);
+		
+		accel[i][0] = (int16_t) (-16384.0f * sinf(pitch) + (rand() % 65) - 32);
+		accel[i][1] = (int16_t) (16384.0f * cosf(pitch) * sinf(roll) + (rand() % 65) - 32);
+		accel[i][2] = (int16_t) (16384.0f * cosf(pitch) * cosf(roll) + (rand() % 65) - 32);
+		
+		gyro[i][0] = (int16_t) (0.65f * cosf(t * 1.3f) * 180.0f / (float) M_PI * 131.0f + (rand() % 9) - 4);
+		gyro[i][1] = (int16_t) (0.21f * cosf(t * 0.7f) * 180.0f / (float) M_PI * 131.0f + (rand() % 9) - 4);
+		gyro[i][2] = (int16_t) (20.0f * 131.0f + (rand() % 9) - 4);
+	}
+}
+
+/*! \brief  Returns a monotonic time in seconds
+ */
+static double now(void){
+	struct timespec ts;
+	
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv){
+	long updates = (argc > 1) ? atol(argv[1]) : 10000000L;
+	mpu6050_fusion_fixed_t fixed;
+	mpu6050_fusion_float_t flt;
+	double start, fixed_s, float_s, diff = 0.0;
+	
+	make_frames();
+	
+	fusion_init_fixed_mpu6050(&fixed, 0);
+	start = now();
+	for(long i = 0; i < updates; i++){
+		fusion_update_fixed_mpu6050(&fixed, accel[i % FRAMES], gyro[i % FRAMES], DT_US);
+	}
+	fixed_s = now() - start;
+	
+	fusion_init_float_mpu6050(&flt, 0);
+	start = now();
+	for(long i = 0; i < updates; i++){
+		fusion_update_float_mpu6050(&flt, accel[i % FRAMES], gyro[i % FRAMES], DT_US);
+	}
+	float_s = now() - start;
+	
+	for(int i = 0; i < 4; i++){
+		double d = fabs(fixed.q[i] / (double) (1L << 30) - flt.q[i]);
+		if(d > diff) diff = d;
+	}
+	
+	printf("updates          %ld\n", updates);
+	printf("fixed updates/s  %.0f\n", updates / fixed_s);
+	printf("float updates/s  %.0f\n", updates / float_s);
+	printf("max q difference %.6f\n", diff);
+	printf("fixed q          %+.6f %+.6f %+.6f %+.6f\n", fixed.q[0] / (double) (1L << 30), fixed.q[1] / (double) (1L << 30),
+		   fixed.q[2] / (double) (1L << 30), fixed.q[3] / (double) (1L << 30));
+	printf("float q          %+.6f %+.6f %+.6f %+.6f\n", flt.q[0], flt.q[1], flt.q[2], flt.q[3]);
+	
+	return 0;
+}
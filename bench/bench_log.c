@@ -0,0 +1,164 @@
+/*!
+ *  \file    bench_log.c
+ *  \author  Tycho Jobsis
+ *  \date    04-04-2021
+ *  \version 0.1.0
+ *
+ *  \brief   Compression and throughput benchmark of the log format of the MPU6050 library
+ *
+ *  \details Encodes a recording frame by frame like the Xmega would, decodes it in bulk and checks that
+ *			 the frames are the same. Prints the compression ratio against 12 bytes per frame and the
+ *			 frames per second of the encoder and the decoder. The recording is read from a file with
+ *			 FIFO frames (accel, gyro, 12 bytes big endian per frame), or made with the simulated MPU6050 at
+ *			 1kHz with the noise of the datasheet and a slow movement when no file is given.
+ *
+ *	\code{.sh}
+ 	gcc -O2 -std=gnu99 -I.. -o bench_log bench_log.c ../mpu6050_log.c ../mpu6050.c ../mpu6050_dmp.c ../mpu6050_sim.c ../mpu6050_store.c -lm
+ 	./bench_log [recording.bin]
+ 	\endcode
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "mpu6050_log.h"
+#include "mpu6050_sim.h"
+
+#define FRAMES		60000	//!< Maximum amount of frames, 60s at 1kHz
+#define BLOCK		512		//!< Size of the block buffer of the encoder
+#define RUNS		20		//!< The encoder and decoder run this many times over the recording
+
+static mpu6050_motion_t rec[FRAMES];
+static mpu6050_motion_t dec[FRAMES];
+static uint8_t out[FRAMES * 24];
+
+/*! \brief  Returns a monotonic time in seconds
+ */
+static double now(void){
+	struct timespec ts;
+	
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*! \brief  Reads a recording of 12 byte FIFO frames
+ */
+static uint32_t load(const char *name){
+	FILE *f = fopen(name, "rb");
+	uint8_t b[12];
+	uint32_t n = 0;
+	
+	if(f == 0) return 0;
+	
+	while(n < FRAMES && fread(b, 1, 12, f) == 12){
+		for(int i = 0; i < 3; i++){
+			rec[n].accel[i] = (int16_t) ((b[2 * i] << 8) | b[2 * i + 1]);
+			rec[n].gyro[i] = (int16_t) ((b[6 + 2 * i] << 8) | b[7 + 2 * i]);
+		}
+		rec[n].temp = 0;
+		rec[n].time_us = n * 1000;
+		n++;
+	}
+	
+	fclose(f);
+	
+	return n;
+}
+
+/*! \brief  Records frames from the simulated MPU6050 with the driver
+ */
+static uint32_t record(void){
+	mpu6050_sim_t sim;
+	mpu6050_bus_t bus;
+	mpu6050_dev_t mpu;
+	
+	sim_init_mpu6050(&sim, MPU6050_ADDRESS);
+	sim.bus_hz = 0;
+	sim.accel_noise = 0.004f;	//!< 400ug/sqrt(Hz) at 100Hz bandwidth
+	sim.gyro_noise = 0.05f;		//!< 0.005dps/sqrt(Hz) at 100Hz bandwidth
+	sim_bus_mpu6050(&sim, &bus);
+	init_bus_mpu6050(&mpu, &bus, MPU6050_ADDRESS);
+	
+	wake_up_mpu6050(&mpu);
+	set_dlpf_mpu6050(&mpu, MPU6050_DLPF_94);
+	set_sample_rate_mpu6050(&mpu, 1000);
+	
+	for(uint32_t n = 0; n < FRAMES; n++){
+		float t = n * 0.001f;
+		
+		sim.accel[0] = 0.2f * sinf(t * 1.7f);
+		sim.accel[1] = 0.1f * sinf(t * 0.9f);
+		sim.accel[2] = 1.0f;
+		sim.gyro[0] = 30.0f * cosf(t * 1.7f);
+		sim.gyro[1] = 10.0f * cosf(t * 0.9f);
+		sim.gyro[2] = 5.0f;
+		
+		sim_step_mpu6050(&sim, 1000);
+		get_motion6_raw_mpu6050(&mpu, &rec[n]);
+		rec[n].time_us = n * 1000;
+	}
+	
+	return FRAMES;
+}
+
+int main(int argc, char **argv){
+	mpu6050_sim_t sim;
+	mpu6050_bus_t bus;
+	mpu6050_dev_t mpu;
+	mpu6050_log_enc_t enc;
+	uint8_t block[BLOCK];
+	uint32_t frames, len = 0, decoded = 0, skipped = 0, errors = 0;
+	uint16_t n;
+	double start, enc_s, dec_s;
+	
+	frames = (argc > 1) ? load(argv[1]) : record();
+	if(frames == 0){
+		printf("no frames in %s\n", argv[1]);
+		return 1;
+	}
+	
+	sim_init_mpu6050(&sim, MPU6050_ADDRESS);
+	sim_bus_mpu6050(&sim, &bus);
+	init_bus_mpu6050(&mpu, &bus, MPU6050_ADDRESS);
+	
+	start = now();
+	for(int r = 0; r < RUNS; r++){
+		log_enc_init_mpu6050(&enc, &mpu, block, sizeof(block), MPU6050_LOG_MOTION6, 100, 1000);
+		len = 0;
+		for(uint32_t i = 0; i < frames; i++){
+			n = log_enc_put_mpu6050(&enc, &rec[i]);
+			if(n != 0){
+				memcpy(out + len, block, n);
+				len += n;
+			}
+		}
+		n = log_enc_flush_mpu6050(&enc);
+		memcpy(out + len, block, n);
+		len += n;
+	}
+	enc_s = now() - start;
+	
+	start = now();
+	for(int r = 0; r < RUNS; r++){
+		decoded = log_decode_mpu6050(out, len, dec, FRAMES, &skipped);
+	}
+	dec_s = now() - start;
+	
+	for(uint32_t i = 0; i < frames; i++){
+		if(memcmp(rec[i].accel, dec[i].accel, sizeof(rec[i].accel)) || memcmp(rec[i].gyro, dec[i].gyro, sizeof(rec[i].gyro))) errors++;
+	}
+	
+	printf("frames           %u (%s)\n", frames, (argc > 1) ? argv[1] : "simulated");
+	printf("raw bytes        %u (12 per frame)\n", frames * 12);
+	printf("log bytes        %u (%.2f per frame)\n", len, (double) len / frames);
+	printf("ratio            %.2f\n", frames * 12.0 / len);
+	printf("encode frames/s  %.0f\n", frames * RUNS / enc_s);
+	printf("decode frames/s  %.0f\n", frames * RUNS / dec_s);
+	printf("decoded          %u, %u skipped bytes, %u different frames\n", decoded, skipped, errors);
+	
+	return errors != 0 || decoded != frames;
+}
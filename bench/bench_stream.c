@@ -0,0 +1,149 @@
+/*!
+ *  \file    bench_stream.c
+ *  \author  Tycho Jobsis
+ *  \date    04-04-2021
+ *  \version 0.1.0
+ *
+ *  \brief   Throughput benchmark of the USART stream of the MPU6050 library
+ *
+ *  \details Streams 1kHz frames to the simulated USART at several baud rates, like the DMA channel of the Xmega
+ *			 would send them, and parses the received bytes. Prints the frames that were sent and dropped, the
+ *			 frames that were received with a valid CRC and the sequence errors, and the CPU cost of packing a frame.
+ *
+ *	\code{.sh}
+ 	gcc -O2 -std=gnu99 -I.. -o bench_stream bench_stream.c ../mpu6050_stream.c ../mpu6050_sim.c ../mpu6050.c ../mpu6050_dmp.c ../mpu6050_store.c -lm
+ 	./bench_stream
+ 	\endcode
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "mpu6050_stream.h"
+#include "mpu6050_sim.h"
+
+#define FRAMES		10000	//!< Frames per baud rate, 10s at 1kHz
+#define PERIOD_US	1000	//!< Time between two frames
+#define BUFF		240		//!< Size of one stream buffer, 10 frames
+#define RUNS		200		//!< Runs over the frames to measure the CPU cost
+
+static mpu6050_motion_t acc[FRAMES];
+static uint8_t out[FRAMES * MPU6050_STREAM_FRAME];
+
+/*! \brief  Returns a monotonic time in seconds
+ */
+static double now(void){
+	struct timespec ts;
+	
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*! \brief  Makes a frame that is different for every n
+ */
+static void make(mpu6050_motion_t *frame, uint32_t n){
+	for(int i = 0; i < 3; i++){
+		frame->accel[i] = (int16_t) (n * 7 + i);
+		frame->gyro[i] = (int16_t) (n * 13 - i);
+	}
+	frame->temp = (int16_t) n;
+	frame->time_us = n * PERIOD_US;
+}
+
+/*! \brief  Compares two frames, the padding of the struct is not compared
+ */
+static int same(const mpu6050_motion_t *a, const mpu6050_motion_t *b){
+	return memcmp(a->accel, b->accel, sizeof(a->accel)) == 0 && memcmp(a->gyro, b->gyro, sizeof(a->gyro)) == 0 &&
+		a->temp == b->temp && a->time_us == b->time_us;
+}
+
+/*! \brief  Sink that is always idle, to measure only the packing
+ */
+static uint8_t idle_start(void *ctx, const uint8_t *data, uint16_t len){
+	(void) ctx;
+	(void) data;
+	(void) len;
+	return 0;
+}
+
+static uint8_t idle_busy(void *ctx){
+	(void) ctx;
+	return 0;
+}
+
+/*! \brief  Streams FRAMES frames at a baud rate and checks the received frames
+ *
+ *	\return amount of frames that were received different than they were accepted
+ */
+static uint32_t run(uint32_t baud){
+	static uint8_t buff[2][BUFF];
+	mpu6050_sim_usart_t usart;
+	mpu6050_sink_t sink;
+	mpu6050_stream_t stream;
+	mpu6050_motion_t frame, rx;
+	uint32_t accepted = 0, received = 0, errors = 0, skipped = 0;
+	uint8_t seq;
+	
+	sim_usart_init_mpu6050(&usart, baud, out, sizeof(out));
+	sim_usart_sink_mpu6050(&usart, &sink);
+	stream_init_mpu6050(&stream, &sink, buff[0], buff[1], BUFF);
+	
+	for(uint32_t n = 0; n < FRAMES; n++){
+		make(&frame, n);
+		if(stream_put_mpu6050(&stream, &frame) == 0) acc[accepted++] = frame;
+		stream_poll_mpu6050(&stream);
+		sim_usart_step_mpu6050(&usart, PERIOD_US);
+	}
+	
+	while(stream.pos != 0 || usart.remaining != 0){	//!< Send what is left
+		stream_poll_mpu6050(&stream);
+		sim_usart_step_mpu6050(&usart, PERIOD_US);
+	}
+	
+	for(uint32_t i = 0; i < usart.len; ){
+		if(stream_parse_mpu6050(out + i, (usart.len - i > MPU6050_STREAM_FRAME) ? MPU6050_STREAM_FRAME : usart.len - i, &rx, &seq) == 0){
+			skipped++;
+			i++;
+			continue;
+		}
+		if(received >= accepted || seq != (received & 0xFF) || !same(&rx, &acc[received])) errors++;
+		received++;
+		i += MPU6050_STREAM_FRAME;
+	}
+	if(received != accepted) errors++;
+	
+	printf("%7u baud  %5u sent  %5u dropped  %5u received  %u skipped bytes  %u errors  %u transfers\n",
+		baud, stream.sent, stream.dropped, received, skipped, errors, usart.transfers);
+	
+	return errors;
+}
+
+int main(void){
+	static uint8_t buff[2][BUFF];
+	const uint32_t bauds[] = { 115200, 250000, 460800, 921600, 2000000 };
+	mpu6050_sink_t sink = { idle_start, idle_busy, 0 };
+	mpu6050_stream_t stream;
+	mpu6050_motion_t frame;
+	uint32_t errors = 0;
+	double start, s;
+	
+	for(uint32_t i = 0; i < sizeof(bauds) / sizeof(bauds[0]); i++) errors += run(bauds[i]);
+	
+	make(&frame, 1);
+	stream_init_mpu6050(&stream, &sink, buff[0], buff[1], BUFF);
+	start = now();
+	for(int r = 0; r < RUNS; r++){
+		for(uint32_t n = 0; n < FRAMES; n++){
+			frame.time_us = n;
+			stream_put_mpu6050(&stream, &frame);
+		}
+	}
+	s = now() - start;
+	
+	printf("pack frames/s    %.0f (%.1f ns per frame)\n", FRAMES * RUNS / s, s * 1e9 / (FRAMES * RUNS));
+	printf("bytes per frame  %u, %.0f baud needed at 1kHz\n", MPU6050_STREAM_FRAME, MPU6050_STREAM_FRAME * 10.0 * 1000000 / PERIOD_US);
+	
+	return errors != 0;
+}
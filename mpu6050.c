@@ -10,7 +10,7 @@
  *
  *	\note For the HvA-Xmegaboard you need to use TWIE!
  *
- *	\note This library <b>does not</b> support slave devices for the mpu6050! 
+ *	\note Slave devices are connected to the auxiliary I2C master of the MPU6050, see aux_master_enable_mpu6050.
  */
 
 /*!	\copyright
@@ -38,6 +38,8 @@
  *	SOFTWARE.
  */
 
+#include <string.h>
+
 #include "mpu6050.h"
 
 
@@ -47,7 +49,9 @@ typedef union {
 		uint8_t : 2;
 		uint8_t I2C_MST : 1;
 		uint8_t FIFO_OFLOW : 1;
-		uint8_t : 3;
+		uint8_t : 1;
+		uint8_t MOT : 1;
+		uint8_t : 1;
 	};
 	uint8_t int_reg;
 } MPU6050_INT_STATUS_TYPE;
@@ -64,6 +68,15 @@ typedef union {
 	uint8_t PWR_MGMT_1;
 } MPU6050_PWR_MGMT_1_TYPE;
 
+typedef union {
+	struct {
+		uint8_t DLPF_CFG : 3;
+		uint8_t EXT_SYNC_SET : 3;
+		uint8_t : 2;
+	};
+	uint8_t CONFIG;
+} MPU6050_CONFIG_TYPE;
+
 typedef union {
 	struct {
 		uint8_t STBY_ZG : 1;
@@ -99,11 +112,86 @@ typedef union {
 	uint8_t ACCEL_CONFIG;
 } MPU6050_ACCEL_CONFIG_TYPE;
 
-static uint8_t accel_state;
-static uint8_t gyro_state;
+/*! \brief  Writable configuration registers that have a copy in the device struct
+ *
+ *	The order matches the shadow array of mpu6050_dev_t.
+ */
+static const uint8_t shadow_regs[MPU6050_SHADOW_REGS] = {
+	MPU_6050_PWR_MGMT_1, MPU_6050_PWR_MGMT_2, MPU_6050_CONFIG, MPU_6050_GYRO_CONFIG,
+	MPU_6050_ACCEL_CONFIG, MPU_6050_INT_ENABLE, MPU_6050_FIFO_EN, MPU_6050_USER_CTRL,
+	MPU_6050_SMPLRT_DIV, MPU_6050_I2C_MST_CTRL, MPU_6050_I2C_MST_DELAY_CTRL, MPU_6050_I2C_SLV4_CTRL
+};
+
+#ifdef __AVR__
+/*
+ *	States of the asynchronous TWI transaction
+ */
+#define ASYNC_IDLE		0
+#define ASYNC_ADDR_W	1	//!< Waiting for the ACK on the write address
+#define ASYNC_REG		2	//!< Waiting for the ACK on the register pointer
+#define ASYNC_READ		3	//!< Receiving the register values
+#define ASYNC_BLOCKING	4	//!< A blocking transaction is using the TWI module
+
+#define ASYNC_MODULES	4	//!< The Xmega has at most 4 TWI modules
+
+/*! \brief  State of the asynchronous transaction of one TWI module
+ *
+ *	Every TWI module runs one transaction at a time, MPU6050s on different TWI modules do not wait for each other.
+ *	state is also set to ASYNC_BLOCKING during a blocking transaction, so an asynchronous transaction that is 
+ *	started from an interrupt can not start in the middle of it.
+ */
+typedef struct {
+	TWI_t *twi;				//!< TWI module of this state, 0 if the slot is not used
+	uint8_t addr;			//!< Address of the MPU6050 of the asynchronous transaction
+	uint8_t reg;
+	uint8_t *data;
+	uint16_t len;
+	uint16_t index;
+	mpu6050_done_t done;	//!< Called with arg when the asynchronous transaction is finished
+	void *arg;
+	volatile uint8_t state;
+} mpu6050_twi_async_t;
+
+static mpu6050_twi_async_t async[ASYNC_MODULES];
+#endif
 
 static float gyro_degrees_sec_mpu6050(int16_t raw, uint8_t range);
 static float accel_val_to_g_mpu6050(int16_t raw, uint8_t range);
+#ifdef __AVR__
+static uint8_t wait_twi_mpu6050(TWI_t *twi, uint8_t flag);
+static mpu6050_twi_async_t *async_slot_mpu6050(TWI_t *twi);
+static uint8_t twi_claim_mpu6050(mpu6050_twi_async_t *slot);
+static uint8_t twi_read_burst_mpu6050(TWI_t *twi, uint8_t addr, uint8_t reg, uint8_t *data, uint16_t len);
+static uint8_t twi_write_burst_mpu6050(TWI_t *twi, uint8_t addr, uint8_t reg, const uint8_t *data, uint16_t len);
+static uint8_t twi_bus_read_mpu6050(void *ctx, uint8_t addr, uint8_t reg, uint8_t *data, uint16_t len);
+static uint8_t twi_bus_write_mpu6050(void *ctx, uint8_t addr, uint8_t reg, const uint8_t *data, uint16_t len);
+static uint8_t twi_bus_read_async_mpu6050(void *ctx, uint8_t addr, uint8_t reg, uint8_t *data, uint16_t len, mpu6050_done_t done, void *arg);
+static PORT_t *twi_port_mpu6050(TWI_t *twi);
+static void twi_delay_mpu6050(uint16_t cycles);
+static uint8_t twi_bus_recover_mpu6050(void *ctx);
+static void twi_async_done_mpu6050(mpu6050_twi_async_t *slot, uint8_t status);
+static void acq_done_mpu6050(mpu6050_dev_t *dev, uint8_t status);
+#endif
+#ifdef MPU6050_STATS
+static void stats_count_mpu6050(mpu6050_dev_t *dev, uint8_t err, uint16_t len, uint32_t start);
+#endif
+static uint32_t clock_now_mpu6050(mpu6050_dev_t *dev);
+static void async_done_mpu6050(void *arg, uint8_t status);
+static uint8_t retry_safe_mpu6050(uint8_t reg, uint8_t write, uint8_t err);
+static uint8_t retry_wait_mpu6050(mpu6050_dev_t *dev, uint32_t start, uint16_t wait);
+static uint8_t transfer_mpu6050(mpu6050_dev_t *dev, uint8_t reg, uint8_t *data, const uint8_t *wdata, uint16_t len);
+static uint8_t read_reg_mpu6050(mpu6050_dev_t *dev, uint8_t reg, uint8_t *data);
+static uint8_t write_reg_mpu6050(mpu6050_dev_t *dev, uint8_t reg, uint8_t data);
+static uint8_t *shadow_mpu6050(mpu6050_dev_t *dev, uint8_t reg);
+static void shadow_defaults_mpu6050(mpu6050_dev_t *dev);
+static uint8_t update_reg_mpu6050(mpu6050_dev_t *dev, uint8_t reg, uint8_t data, uint8_t mask);
+static uint8_t read_16bit_mpu6050(mpu6050_dev_t *dev, uint8_t reg_h, int16_t *data);
+static void unpack_motion_mpu6050(const uint8_t *buff, mpu6050_motion_t *data);
+static int16_t round_div_mpu6050(int32_t num, int32_t den);
+static int16_t clamp16_mpu6050(int32_t value);
+static uint8_t cal_sample_mpu6050(mpu6050_dev_t *dev, mpu6050_motion_t *frame);
+static uint8_t *put16_mpu6050(uint8_t *buff, uint16_t value);
+static uint16_t get16_mpu6050(const uint8_t *buff);
 
 /*! \brief  Checks for errors 
  *
@@ -122,1300 +210,3412 @@ uint8_t check_err_mpu6050(uint8_t err){
 	return 0;
 }
 
-/*! \brief  Enables the MPU6050
+#ifdef __AVR__
+/*! \brief  Waits until the TWI master finished the current byte
+ *
+ *	\note	This function is for internal use
  *
  *  \param  *twi	pointer to the TWI module that is connected to the MPU6050
- *	\param	addr	address of the MPU6050
+ *	\param	flag	TWI_MASTER_WIF_bm or TWI_MASTER_RIF_bm
  *
- *  \return	0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2	
+ *  \return TWI_STATUS_OK if the byte was (n)acknowledged, NACK if the MPU6050 did not acknowledge,
+ *			DATA_NOT_RECEIVED if arbitration was lost or a bus error occurred and BUS_IN_USE if the byte
+ *			did not finish within MPU6050_TWI_WAIT_LOOPS polls, a STOP condition is requested then
  */
-uint8_t enable_mpu6050(TWI_t *twi, uint8_t addr){
-	uint8_t err; 
-	
-	for(uint8_t i = 0; i < 4; i++){
-		ACCELX_OFFSET_MPU6050[i] = 0;	
-		ACCELY_OFFSET_MPU6050[i] = 0;	
-		ACCELZ_OFFSET_MPU6050[i] = 0;	
-
-		GYROX_OFFSET_MPU6050[i] = 0;	
-		GYROY_OFFSET_MPU6050[i] = 0;	
-		GYROZ_OFFSET_MPU6050[i] = 0;
-	}	
-		
-	//err = wake_up_mpu6050(twi, addr);
-	err = write_8bit_register_TWI(twi, addr, 0, MPU_6050_PWR_MGMT_1);
-	if(check_err_mpu6050(err) != 0) return err;
-	//if(err != 0) return err;
-	
-	//err = enable_temp_mpu6050(twi, addr);
-	//if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
-	
-	err = stdby_all_mpu6050(twi, addr, OFF);
-	if(err != 0) return err;
-	
-	err = calibrate_accel_x_mpu6050(twi, addr);
-	err = calibrate_accel_y_mpu6050(twi, addr);
-	err = calibrate_accel_z_mpu6050(twi, addr);
-	
-	err = calibrate_gyro_x_mpu6050(twi, addr);
-	err = calibrate_gyro_y_mpu6050(twi, addr);
-	err = calibrate_gyro_z_mpu6050(twi, addr);
+static uint8_t wait_twi_mpu6050(TWI_t *twi, uint8_t flag){
+	uint8_t status;
+	uint16_t loops = 0;
+	
+	do{
+		if(loops++ == MPU6050_TWI_WAIT_LOOPS){
+			twi->MASTER.CTRLC = TWI_MASTER_CMD_STOP_gc;
+			return BUS_IN_USE;	//!< SCL is held low, the bus needs to be recovered
+		}
+		status = twi->MASTER.STATUS;
+	}while(!(status & (flag | TWI_MASTER_WIF_bm)));
 	
-	accel_set_scale_mpu6050(twi, addr, MPU6050_ACCEL_SCL_2G);
-	gyro_set_scale_mpu6050(twi, addr, MPU6050_GYRO_SCL_250);
+	if(status & (TWI_MASTER_ARBLOST_bm | TWI_MASTER_BUSERR_bm)) return DATA_NOT_RECEIVED;
+	if(status & TWI_MASTER_RXACK_bm){
+		twi->MASTER.CTRLC = TWI_MASTER_CMD_STOP_gc;
+		return NACK;
+	}
 	
-	return MPU6050_TWI_OK;	
+	return TWI_STATUS_OK;
 }
 
-/*! \brief  Disables the MPU6050
+/*! \brief  Reads consecutive registers of the MPU6050 in one I2C transaction
+ *
+ *	\note	This function is for internal use
+ *
+ *	The MPU6050 increments its register pointer after every byte, so one start condition
+ *	is enough to read a whole block of registers.
  *
  *  \param  *twi	pointer to the TWI module that is connected to the MPU6050
  *	\param	addr	address of the MPU6050
+ *	\param	reg		first register that needs to be read
+ *	\param	*data	pointer to store the register values
+ *	\param	len		amount of registers that need to be read
  *
- *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ *  \return status code of the TWI library
  */
-uint8_t disable_mpu6050(TWI_t *twi, uint8_t addr){
-	uint8_t old_reg, err;
+static uint8_t twi_read_burst_mpu6050(TWI_t *twi, uint8_t addr, uint8_t reg, uint8_t *data, uint16_t len){
+	uint8_t err;
 	
-	err = disable_temp_mpu6050(twi, addr);
-	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	if(len == 0) return TWI_STATUS_OK;
 	
-	old_reg = 1; //!< Makes the Gyroscope and the accelerometer inactive
-	err = write_8bit_register_TWI(twi, addr, old_reg, MPU_6050_PWR_MGMT_2);
-	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	twi->MASTER.ADDR = (addr << 1);	//!< Write the register pointer
+	err = wait_twi_mpu6050(twi, TWI_MASTER_WIF_bm);
+	if(err != TWI_STATUS_OK) return err;
 	
-	err = sleep_mpu6050(twi, addr);
-	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	twi->MASTER.DATA = reg;
+	err = wait_twi_mpu6050(twi, TWI_MASTER_WIF_bm);
+	if(err != TWI_STATUS_OK) return err;
 	
-	return 0;	
+	twi->MASTER.ADDR = (addr << 1) | 0x01;	//!< Repeated start to read
+	for(uint16_t i = 0; i < len; i++){
+		err = wait_twi_mpu6050(twi, TWI_MASTER_RIF_bm);
+		if(err == BUS_IN_USE) return DATA_NOT_RECEIVED;	//!< Bytes can already be read, the transaction may not be retried
+		if(err != TWI_STATUS_OK) return err;
+		
+		data[i] = twi->MASTER.DATA;
+		
+		if(i < len - 1) twi->MASTER.CTRLC = TWI_MASTER_CMD_RECVTRANS_gc;	//!< ACK and read the next byte
+		else twi->MASTER.CTRLC = TWI_MASTER_ACKACT_bm | TWI_MASTER_CMD_STOP_gc;	//!< NACK the last byte
+	}
+	
+	return TWI_STATUS_OK;
 }
 
-/*! \brief  Wakes the MPU6050 from sleep
+/*! \brief  Writes consecutive registers of the MPU6050 in one I2C transaction
+ *
+ *	\note	This function is for internal use
  *
  *  \param  *twi	pointer to the TWI module that is connected to the MPU6050
  *	\param	addr	address of the MPU6050
+ *	\param	reg		first register that needs to be written
+ *	\param	*data	pointer to the new register values
+ *	\param	len		amount of registers that need to be written
  *
- *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ *  \return status code of the TWI library
  */
-uint8_t wake_up_mpu6050(TWI_t *twi, uint8_t addr){
-	uint8_t err, old_reg;
+static uint8_t twi_write_burst_mpu6050(TWI_t *twi, uint8_t addr, uint8_t reg, const uint8_t *data, uint16_t len){
+	uint8_t err;
 	
-	err = read_8bit_register_TWI(twi, addr, &old_reg, MPU_6050_PWR_MGMT_1);
-	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
-	old_reg = (0 << 6); //!< Disables sleep
-	err = write_8bit_register_TWI(twi, addr, old_reg, MPU_6050_PWR_MGMT_1);
-	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	twi->MASTER.ADDR = (addr << 1);
+	err = wait_twi_mpu6050(twi, TWI_MASTER_WIF_bm);
+	if(err != TWI_STATUS_OK) return err;
 	
-	return 0;
+	twi->MASTER.DATA = reg;
+	err = wait_twi_mpu6050(twi, TWI_MASTER_WIF_bm);
+	if(err != TWI_STATUS_OK) return err;
+	
+	for(uint16_t i = 0; i < len; i++){
+		twi->MASTER.DATA = data[i];
+		err = wait_twi_mpu6050(twi, TWI_MASTER_WIF_bm);
+		if(err != TWI_STATUS_OK) return DATA_NOT_SEND;	//!< Also a time out, bytes can already be written
+	}
+	
+	twi->MASTER.CTRLC = TWI_MASTER_CMD_STOP_gc;
+	
+	return TWI_STATUS_OK;
 }
 
-/*! \brief  Lets the MPU6050 go to sleep
+/*! \brief  Get the asynchronous transaction state of a TWI module
  *
- *  \param  *twi	pointer to the TWI module that is connected to the MPU6050
- *	\param	addr	address of the MPU6050
+ *	\note	This function is for internal use
  *
- *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ *	A TWI module gets a free slot the first time it is used, init_mpu6050 does that outside of the interrupts.
+ *
+ *  \param  *twi	pointer to the TWI module
+ *
+ *  \return pointer to the state of the TWI module, 0 if there is no free slot
  */
-uint8_t sleep_mpu6050(TWI_t *twi, uint8_t addr){
-	uint8_t err, old_reg;
+static mpu6050_twi_async_t *async_slot_mpu6050(TWI_t *twi){
+	mpu6050_twi_async_t *free = 0;
 	
-	err = read_8bit_register_TWI(twi, addr, &old_reg, MPU_6050_PWR_MGMT_1);
-	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
-	old_reg = (1 << 6); //!< Enables sleep
-	err = write_8bit_register_TWI(twi, addr, old_reg, MPU_6050_PWR_MGMT_1);
-	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	for(uint8_t i = 0; i < ASYNC_MODULES; i++){
+		if(async[i].twi == twi) return &async[i];
+		if(async[i].twi == 0 && free == 0) free = &async[i];
+	}
 	
-	return 0;	
+	if(free != 0){
+		free->state = ASYNC_IDLE;
+		free->twi = twi;
+	}
+	
+	return free;
 }
 
-/*! \brief  Get x-axis accelerometer data without calibration
+/*! \brief  Claims a TWI module for a blocking transaction
  *
- *  \param  *twi	pointer to the TWI module that is connected to the MPU6050
- *	\param	addr	address of the MPU6050
- *	\param	data	pointer to store accelerometer x direction data
+ *	\note	This function is for internal use
  *
- *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ *	The check and the claim are done with interrupts disabled, so an asynchronous transaction that is started 
+ *	from an interrupt can not start between them. Set state back to ASYNC_IDLE after the transaction.
+ *
+ *  \param  *slot	pointer to the state of the TWI module that is connected to the MPU6050
+ *
+ *  \return TWI_STATUS_OK if the TWI module is claimed, BUS_IN_USE if it or the TWI/I2C bus is in use
  */
-uint8_t get_accel_x_raw_mpu6050(TWI_t *twi, uint8_t addr, int16_t *data){
-	uint8_t err, read;
-	data16_t accel_x;
-	accel_x.DATA = 0;
-	
-	err = read_8bit_register_TWI(twi, addr, &read, MPU_6050_ACCEL_XOUT_L);
-	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
-	accel_x.DATAL = read;
+static uint8_t twi_claim_mpu6050(mpu6050_twi_async_t *slot){
+	uint8_t sreg = SREG;
+	uint8_t err = TWI_STATUS_OK;
 	
-	err = read_8bit_register_TWI(twi, addr, &read, MPU_6050_ACCEL_XOUT_H);
-	if (check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
-	accel_x.DATAH = read;
+	if(slot == 0) return BUS_IN_USE;
 	
-	(*data) = accel_x.DATA;
+	cli();
+	if(slot->state != ASYNC_IDLE) err = BUS_IN_USE;
+	else if((slot->twi->MASTER.STATUS & TWI_MASTER_BUSSTATE_gm) == TWI_MASTER_BUSSTATE_BUSY_gc) err = BUS_IN_USE;
+	else slot->state = ASYNC_BLOCKING;
+	SREG = sreg;
 	
-	return 0;	
+	return err;
 }
 
-/*! \brief  Get y-axis accelerometer data without calibration
+/*! \brief  Reads registers of the MPU6050 through the TWI module
  *
- *  \param  *twi	pointer to the TWI module that is connected to the MPU6050
+ *	\note	This function is for internal use
+ *
+ *  \param  *ctx	pointer to the TWI module that is connected to the MPU6050
  *	\param	addr	address of the MPU6050
- *	\param	data	pointer to store accelerometer y direction data
+ *	\param	reg		first register that needs to be read
+ *	\param	*data	pointer to store the register values
+ *	\param	len		amount of registers that need to be read
  *
- *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ *  \return status code of the TWI library
  */
-uint8_t get_accel_y_raw_mpu6050(TWI_t *twi, uint8_t addr, int16_t *data){
-	uint8_t err, read;
-	data16_t accel_y;
-	
-	err = read_8bit_register_TWI(twi, addr, &read, MPU_6050_ACCEL_YOUT_L);
-	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
-	accel_y.DATAL = read;
+static uint8_t twi_bus_read_mpu6050(void *ctx, uint8_t addr, uint8_t reg, uint8_t *data, uint16_t len){
+	mpu6050_twi_async_t *slot = async_slot_mpu6050((TWI_t *) ctx);
+	uint8_t err = twi_claim_mpu6050(slot);
 	
-	err = read_8bit_register_TWI(twi, addr, &read, MPU_6050_ACCEL_YOUT_H);
-	if (check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
-	accel_y.DATAH = read;
+	if(err != TWI_STATUS_OK) return err;
 	
-	(*data) = accel_y.DATA;
+	err = twi_read_burst_mpu6050((TWI_t *) ctx, addr, reg, data, len);
+	slot->state = ASYNC_IDLE;
 	
-	return 0;	
+	return err;
 }
 
-/*! \brief  Get z-axis accelerometer data
+/*! \brief  Writes registers of the MPU6050 through the TWI module
  *
- *  \param  *twi	pointer to the TWI module that is connected to the MPU6050
+ *	\note	This function is for internal use
+ *
+ *  \param  *ctx	pointer to the TWI module that is connected to the MPU6050
  *	\param	addr	address of the MPU6050
- *	\param	data	pointer to store accelerometer z direction data
+ *	\param	reg		first register that needs to be written
+ *	\param	*data	pointer to the new register values
+ *	\param	len		amount of registers that need to be written
  *
- *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ *  \return status code of the TWI library
  */
-uint8_t get_accel_z_raw_mpu6050(TWI_t *twi, uint8_t addr, int16_t *data){
-	uint8_t err, read;
-	data16_t accel_z;
+static uint8_t twi_bus_write_mpu6050(void *ctx, uint8_t addr, uint8_t reg, const uint8_t *data, uint16_t len){
+	mpu6050_twi_async_t *slot = async_slot_mpu6050((TWI_t *) ctx);
+	uint8_t err = twi_claim_mpu6050(slot);
 	
-	err = read_8bit_register_TWI(twi, addr, &read, MPU_6050_ACCEL_ZOUT_L);
-	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
-	accel_z.DATAL = read;
-	
-	err = read_8bit_register_TWI(twi, addr, &read, MPU_6050_ACCEL_ZOUT_H);
-	if (check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
-	accel_z.DATAH = read;
+	if(err != TWI_STATUS_OK) return err;
 	
-	(*data) = accel_z.DATA;
+	err = twi_write_burst_mpu6050((TWI_t *) ctx, addr, reg, data, len);
+	slot->state = ASYNC_IDLE;
 	
-	return 0;	
+	return err;
 }
 
-/*! \brief  Get x-axis gyroscope data
+/*! \brief  Get the port of the SDA (pin 0) and SCL (pin 1) pins of a TWI module
  *
- *  \param  *twi	pointer to the TWI module that is connected to the MPU6050
- *	\param	addr	address of the MPU6050
- *	\param	data	pointer to store gyroscope x direction data
+ *	\note	This function is for internal use
  *
- *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ *  \param  *twi	pointer to the TWI module
+ *
+ *  \return pointer to the port, 0 if the TWI module is unknown
  */
-uint8_t get_gyro_x_raw_mpu6050(TWI_t *twi, uint8_t addr, int16_t *data){
-	uint8_t err, read;
-	data16_t gyro_x;
-	
-	err = read_8bit_register_TWI(twi, addr, &read, MPU_6050_GYRO_XOUT_L);
-	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
-	gyro_x.DATAL = read;
-	
-	err = read_8bit_register_TWI(twi, addr, &read, MPU_6050_GYRO_XOUT_H);
-	if (check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
-	gyro_x.DATAH = read;
+static PORT_t *twi_port_mpu6050(TWI_t *twi){
+#ifdef TWIC
+	if(twi == &TWIC) return &PORTC;
+#endif
+#ifdef TWID
+	if(twi == &TWID) return &PORTD;
+#endif
+#ifdef TWIE
+	if(twi == &TWIE) return &PORTE;
+#endif
+#ifdef TWIF
+	if(twi == &TWIF) return &PORTF;
+#endif
+	return 0;
+}
+
+/*! \brief  Waits at least a number of CPU cycles
+ *
+ *	\note	This function is for internal use
+ *
+ *  \param  cycles	minimum amount of CPU cycles
+ */
+static void twi_delay_mpu6050(uint16_t cycles){
+	for(volatile uint16_t i = 0; i < cycles; i++);	//!< Every iteration takes more than one cycle
+}
+
+/*! \brief  Frees a stuck I2C bus and reinitializes the TWI module
+ *
+ *	\note	This function is for internal use
+ *
+ *	A slave that was interrupted in the middle of a read can hold SDA low. The TWI module is disabled and SCL is 
+ *	clocked by hand until the slave releases SDA, at most 9 times, followed by a STOP condition. The pins are only 
+ *	driven low, the pull-up resistors make them high. The TWI module is enabled again with its previous settings 
+ *	and its bus state is forced to idle. SCL is clocked at the baud rate of the TWI module or slower.
+ *	The bus is not touched while an asynchronous transaction owns the TWI module.
+ *
+ *  \param  *ctx	pointer to the TWI module that is connected to the MPU6050
+ *
+ *  \return TWI_STATUS_OK if SDA is released, BUS_IN_USE otherwise
+ */
+static uint8_t twi_bus_recover_mpu6050(void *ctx){
+	TWI_t *twi = (TWI_t *) ctx;
+	mpu6050_twi_async_t *slot = async_slot_mpu6050(twi);
+	PORT_t *port = twi_port_mpu6050(twi);
+	uint8_t ctrla = twi->MASTER.CTRLA;
+	uint16_t half = twi->MASTER.BAUD + 5;	//!< Half an SCL period is BAUD + 5 CPU cycles
+	uint8_t err = TWI_STATUS_OK;
+	uint8_t sreg = SREG;
+	
+	if(slot == 0) return BUS_IN_USE;
+	
+	cli();
+	if(slot->state != ASYNC_IDLE) err = BUS_IN_USE;
+	else slot->state = ASYNC_BLOCKING;	//!< The bus state is not checked, it is busy when the bus is stuck
+	SREG = sreg;
+	if(err != TWI_STATUS_OK) return err;
+	
+	twi->MASTER.CTRLA = ctrla & ~TWI_MASTER_ENABLE_bm;	//!< The port controls the pins
+	
+	if(port != 0){
+		port->OUTCLR = PIN0_bm | PIN1_bm;
+		port->DIRCLR = PIN0_bm | PIN1_bm;
+		
+		for(uint8_t i = 0; i < 9 && !(port->IN & PIN0_bm); i++){
+			port->DIRSET = PIN1_bm;
+			twi_delay_mpu6050(half);
+			port->DIRCLR = PIN1_bm;
+			twi_delay_mpu6050(half);
+		}
+		
+		port->DIRSET = PIN1_bm;		//!< STOP: SDA goes high while SCL is high
+		twi_delay_mpu6050(half);
+		port->DIRSET = PIN0_bm;
+		twi_delay_mpu6050(half);
+		port->DIRCLR = PIN1_bm;
+		twi_delay_mpu6050(half);
+		port->DIRCLR = PIN0_bm;
+		twi_delay_mpu6050(half);
+		
+		if(!(port->IN & PIN0_bm)) err = BUS_IN_USE;
+	}
 	
-	(*data) = gyro_x.DATA;
+	twi->MASTER.CTRLA = ctrla;
+	twi->MASTER.STATUS = TWI_MASTER_BUSSTATE_IDLE_gc;
+	slot->state = ASYNC_IDLE;
 	
-	return 0;	
+	return err;
 }
+#endif
 
-/*! \brief  Get y-axis gyroscope data
+#ifdef MPU6050_STATS
+/*! \brief  Adds one transaction to the counters of the device
  *
- *  \param  *twi	pointer to the TWI module that is connected to the MPU6050
- *	\param	addr	address of the MPU6050
- *	\param	data	pointer to store gyroscope y direction data
+ *	\note	This function is for internal use
  *
- *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	err		status code of the TWI library of the transaction
+ *	\param	len		amount of registers of the transaction
+ *	\param	start	value of clock_us at the start of the transaction
  */
-uint8_t get_gyro_y_raw_mpu6050(TWI_t *twi, uint8_t addr, int16_t *data){
-	uint8_t err, read;
-	data16_t gyro_y;
+static void stats_count_mpu6050(mpu6050_dev_t *dev, uint8_t err, uint16_t len, uint32_t start){
+	mpu6050_stats_t *stats = &dev->stats;
+	uint32_t latency;
 	
-	err = read_8bit_register_TWI(twi, addr, &read, MPU_6050_GYRO_YOUT_L);
-	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
-	gyro_y.DATAL = read;
+	stats->transactions++;
+	stats->bytes += len;
 	
-	err = read_8bit_register_TWI(twi, addr, &read, MPU_6050_GYRO_YOUT_H);
-	if (check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
-	gyro_y.DATAH = read;
+	if(err == NACK) stats->nacks++;
+	else if(err == BUS_IN_USE) stats->bus_busy++;
+	else if(err == DATA_NOT_RECEIVED) stats->not_received++;
+	else if(err == DATA_NOT_SEND) stats->not_sent++;
 	
-	(*data) = gyro_y.DATA;
+	if(dev->clock_us == 0) return;
 	
-	return 0;	
+	latency = dev->clock_us() - start;
+	
+	if(latency < stats->latency_min) stats->latency_min = latency;
+	if(latency > stats->latency_max) stats->latency_max = latency;
+	stats->latency_sum += latency;
+	stats->timed++;
 }
 
-/*! \brief  Get z-axis gyroscope data
+/*! \brief  Copies the counters of the device
  *
- *  \param  *twi	pointer to the TWI module that is connected to the MPU6050
- *	\param	addr	address of the MPU6050
- *	\param	data	pointer to store gyroscope z direction data
+ *	The counters are only updated by the functions that wait for the transaction, not by the asynchronous 
+ *	functions and the interrupt driven acquisition.
  *
- *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	*stats	pointer to store the counters, latency_avg is calculated
  */
-uint8_t get_gyro_z_raw_mpu6050(TWI_t *twi, uint8_t addr, int16_t *data){
-	uint8_t err, read;
-	data16_t gyro_z;
+void stats_snapshot_mpu6050(mpu6050_dev_t *dev, mpu6050_stats_t *stats){
+	(*stats) = dev->stats;
 	
-	err = read_8bit_register_TWI(twi, addr, &read, MPU_6050_GYRO_ZOUT_L);
-	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
-	gyro_z.DATAL = read;
-	
-	err = read_8bit_register_TWI(twi, addr, &read, MPU_6050_GYRO_ZOUT_H);
-	if (check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
-	gyro_z.DATAH = read;
+	stats->latency_avg = (stats->timed != 0) ? stats->latency_sum / stats->timed : 0;
+	if(stats->timed == 0) stats->latency_min = 0;
+}
+
+/*! \brief  Sets the counters of the device to 0
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ */
+void stats_clear_mpu6050(mpu6050_dev_t *dev){
+	memset(&dev->stats, 0, sizeof(dev->stats));
+	dev->stats.latency_min = UINT32_MAX;
+}
+#endif
+
+/*! \brief  Checks if a failed transaction can be tried again
+ *
+ *	\note	This function is for internal use
+ *
+ *	Reading FIFO_R_W, MEM_R_W or INT_STATUS changes the MPU6050 and writing FIFO_R_W or MEM_R_W moves 
+ *	its pointer, so these transactions are only tried again if they failed before any data was transferred.
+ *
+ *  \param  reg		first register of the transaction
+ *	\param	write	1 for a write, 0 for a read
+ *	\param	err		status code of the TWI library of the failed transaction
+ *
+ *  \return 1 if the transaction can be tried again, 0 otherwise
+ */
+static uint8_t retry_safe_mpu6050(uint8_t reg, uint8_t write, uint8_t err){
+	if(err == BUS_IN_USE || err == NACK) return 1;	//!< The address or register pointer was not acknowledged
 	
-	(*data) = gyro_z.DATA;
+	if(reg == MPU_6050_FIFO_R_W || reg == MPU_6050_MEM_R_W) return 0;
+	if(!write && reg == MPU_6050_INT_STATUS) return 0;
 	
-	return 0;	
+	return 1;
 }
 
-/*! \brief  Get x-axis accelerometer data
+/*! \brief  Waits before the next try of a transaction
  *
- *  \param  *twi	pointer to the TWI module that is connected to the MPU6050
- *	\param	addr	address of the MPU6050
- *	\param	data	pointer to store accelerometer x direction data
+ *	\note	This function is for internal use
  *
- *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	start	value of clock_us at the start of the first try
+ *	\param	wait	time to wait in us
+ *
+ *  \return 1 if the transaction can be tried again, 0 if the next try would be after the deadline
  */
-uint8_t get_accel_x_mpu6050(TWI_t *twi, uint8_t addr, float *data){
-	uint8_t err;
-	int16_t raw;
+static uint8_t retry_wait_mpu6050(mpu6050_dev_t *dev, uint32_t start, uint16_t wait){
+	uint32_t now;
 	
-	err = get_accel_x_raw_mpu6050(twi, addr, &raw);
-	if(err != 0) return err;
-	
-	raw -= ACCELX_OFFSET_MPU6050[accel_state];
-	float ret = accel_val_to_g_mpu6050(raw, accel_state);
+	if(dev->clock_us == 0) return 1;
 	
+	now = dev->clock_us();
+	if(dev->retry.deadline_us != 0 && now - start + wait >= dev->retry.deadline_us) return 0;
 	
-	(*data) = ret;
+	while(dev->clock_us() - now < wait);
 	
-	return 0;
+	return 1;
 }
 
-/*! \brief  Get y-axis accelerometer data
+/*! \brief  Reads or writes consecutive registers of the MPU6050 with the retry policy of the device
  *
- *  \param  *twi	pointer to the TWI module that is connected to the MPU6050
- *	\param	addr	address of the MPU6050
- *	\param	data	pointer to store accelerometer y direction data
+ *	\note	This function is for internal use
  *
- *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	reg		first register
+ *	\param	*data	pointer to store the register values of a read, 0 for a write
+ *	\param	*wdata	pointer to the new register values of a write
+ *	\param	len		amount of registers
+ *
+ *  \return status code of the TWI library of the last try
  */
-uint8_t get_accel_y_mpu6050(TWI_t *twi, uint8_t addr, float *data){
-		uint8_t err;
-		int16_t raw;
-		
-		err = get_accel_y_raw_mpu6050(twi, addr, &raw);
-		if(err != 0) return err;
-		
-		raw -= ACCELY_OFFSET_MPU6050[accel_state];
-		float ret = accel_val_to_g_mpu6050(raw, accel_state);
+static uint8_t transfer_mpu6050(mpu6050_dev_t *dev, uint8_t reg, uint8_t *data, const uint8_t *wdata, uint16_t len){
+	uint32_t start = clock_now_mpu6050(dev);
+	uint16_t wait = dev->retry.backoff_us;
+	uint8_t err, failed = 0;
+#ifdef MPU6050_STATS
+	uint32_t begin;
+#endif
+	
+	while(1){
+#ifdef MPU6050_STATS
+		begin = clock_now_mpu6050(dev);
+#endif
+		if(data != 0) err = dev->bus.read(dev->bus.ctx, dev->addr, reg, data, len);
+		else err = dev->bus.write(dev->bus.ctx, dev->addr, reg, wdata, len);
+#ifdef MPU6050_STATS
+		stats_count_mpu6050(dev, err, len, begin);
+#endif
+		if(err == TWI_STATUS_OK) return err;
 		
+		failed++;
+		if(failed >= dev->retry.attempts) return err;
+		if(!retry_safe_mpu6050(reg, data == 0, err)) return err;
 		
-		(*data) = ret;
+		if(dev->retry.recover_after != 0 && !dev->recovering && (failed % dev->retry.recover_after) == 0){
+			recover_bus_mpu6050(dev);
+		}
 		
-		return 0;	
+		if(!retry_wait_mpu6050(dev, start, wait)) return err;
+		wait = (wait > dev->retry.backoff_max_us / 2) ? dev->retry.backoff_max_us : wait * 2;
+#ifdef MPU6050_STATS
+		dev->stats.retries++;
+#endif
+	}
 }
 
-/*! \brief  Get z-axis accelerometer data
+/*! \brief  Reads consecutive registers of the MPU6050 in one I2C transaction
  *
- *  \param  *twi	pointer to the TWI module that is connected to the MPU6050
- *	\param	addr	address of the MPU6050
- *	\param	data	pointer to store accelerometer z direction data
+ *	A failed transaction is tried again with the retry policy of the device struct.
  *
- *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	reg		first register that needs to be read
+ *	\param	*data	pointer to store the register values
+ *	\param	len		amount of registers that need to be read
+ *
+ *  \return status code of the TWI library, check it with check_err_mpu6050
  */
-uint8_t get_accel_z_mpu6050(TWI_t *twi, uint8_t addr, float *data){
-	uint8_t err;
-	int16_t raw;
-	
-	err = get_accel_z_raw_mpu6050(twi, addr, &raw);
-	if(err != 0) return err;
-	
-	raw -= ACCELY_OFFSET_MPU6050[accel_state];
-	float ret = accel_val_to_g_mpu6050(raw, accel_state);
-	
-	
-	(*data) = ret;
-	
-	return 0;	
+uint8_t read_burst_mpu6050(mpu6050_dev_t *dev, uint8_t reg, uint8_t *data, uint16_t len){
+	return transfer_mpu6050(dev, reg, data, 0, len);
 }
 
-/*! \brief  Get x-axis gyroscope data
+/*! \brief  Writes consecutive registers of the MPU6050 in one I2C transaction
  *
- *  \param  *twi	pointer to the TWI module that is connected to the MPU6050
- *	\param	addr	address of the MPU6050
- *	\param	data	pointer to store gyroscope x direction data
+ *	A failed transaction is tried again with the retry policy of the device struct.
  *
- *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ *	\note The copies of the configuration registers are not updated, use the configuration functions for those registers.
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	reg		first register that needs to be written
+ *	\param	*data	pointer to the new register values
+ *	\param	len		amount of registers that need to be written
+ *
+ *  \return status code of the TWI library, check it with check_err_mpu6050
  */
-uint8_t get_gyro_x_mpu6050(TWI_t *twi, uint8_t addr, float *data){
-	uint8_t err;
-	int16_t raw;
-	
-	err = get_gyro_x_raw_mpu6050(twi, addr, &raw);
-	if(err != 0) return err;
-	
-	raw -= GYROX_OFFSET_MPU6050[gyro_state];	
-	float ret = gyro_degrees_sec_mpu6050(raw, gyro_state);
-	
-	(*data) = ret;
-	
-	return 0;
+uint8_t write_burst_mpu6050(mpu6050_dev_t *dev, uint8_t reg, const uint8_t *data, uint16_t len){
+	return transfer_mpu6050(dev, reg, 0, data, len);
 }
 
-/*! \brief  Get y-axis gyroscope data
+/*! \brief  Frees a stuck bus and restores the configuration registers of the MPU6050
  *
- *  \param  *twi	pointer to the TWI module that is connected to the MPU6050
- *	\param	addr	address of the MPU6050
- *	\param	data	pointer to store gyroscope y direction data
+ *	Calls recover of the transport, on the Xmega this clocks SCL until SDA is released and reinitializes the 
+ *	TWI module. Then every configuration register that has a copy in the device struct is written with its copy,
+ *	so the configuration is back after the MPU6050 lost it, for example after a brown out of only the MPU6050.
+ *	The retry policy calls this function after recover_after failed tries, see mpu6050_retry_t.
+ *
+ *	\note The offset registers, the auxiliary I2C slaves and the Digital Motion Processor have no copy and are not restored.
+ *
+ *  \param  *dev	pointer to the MPU6050 device
  *
  *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
  */
-uint8_t get_gyro_y_mpu6050(TWI_t *twi, uint8_t addr, float *data){
-	uint8_t err;
-	int16_t raw;
+uint8_t recover_bus_mpu6050(mpu6050_dev_t *dev){
+	uint8_t err = TWI_STATUS_OK;
 	
-	err = get_gyro_y_raw_mpu6050(twi, addr, &raw);
-	if(err != 0) return err;
+#ifdef MPU6050_STATS
+	dev->stats.recoveries++;
+#endif
+	dev->recovering = 1;	//!< The writes below may be tried again but do not recover the bus again
 	
-	raw -= GYROY_OFFSET_MPU6050[gyro_state];
-	float ret = gyro_degrees_sec_mpu6050(raw, gyro_state);
+	if(dev->bus.recover != 0) err = dev->bus.recover(dev->bus.ctx);
 	
+	for(uint8_t i = 0; i < MPU6050_SHADOW_REGS && err == TWI_STATUS_OK; i++){	//!< PWR_MGMT_1 is first so the MPU6050 wakes up
+		err = write_reg_mpu6050(dev, shadow_regs[i], dev->shadow[i]);
+	}
 	
-	(*data) = ret;
+	dev->recovering = 0;
 	
-	return 0;	
+	return check_err_mpu6050(err);
 }
 
-/*! \brief  Get z-axis gyroscope data
+/*! \brief  Reads one register of the MPU6050
  *
- *  \param  *twi	pointer to the TWI module that is connected to the MPU6050
- *	\param	addr	address of the MPU6050
- *	\param	data	pointer to store gyroscope z direction data
+ *	\note	This function is for internal use
  *
- *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	reg		register that needs to be read
+ *	\param	*data	pointer to store the register value
+ *
+ *  \return status code of the TWI library
  */
-uint8_t get_gyro_z_mpu6050(TWI_t *twi, uint8_t addr, float *data){
-	uint8_t err;
-	int16_t raw;
-	
-	err = get_gyro_z_raw_mpu6050(twi, addr, &raw);
-	if(err != 0) return err;
-	
-	raw -= GYROZ_OFFSET_MPU6050[gyro_state];
-	float ret = gyro_degrees_sec_mpu6050(raw, gyro_state);
-	
-	
-	(*data) = ret;
-	
-	return 0;
+static uint8_t read_reg_mpu6050(mpu6050_dev_t *dev, uint8_t reg, uint8_t *data){
+	return read_burst_mpu6050(dev, reg, data, 1);
 }
 
-/*! \brief  Get the gyroscope scale/range
+/*! \brief  Writes one register of the MPU6050
  *
- *  \param  raw		value that is used to calculate degrees per second
- *	\param	range	value to specify in what range the raw value was read
+ *	\note	This function is for internal use
  *
- *  \return degrees per second if the input range is invalid the raw value will be returned
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	reg		register that needs to be written
+ *	\param	data	new value of the register
+ *
+ *  \return status code of the TWI library
  */
-static float gyro_degrees_sec_mpu6050(int16_t raw, uint8_t range){
-	float ret;
-	switch(range){
-		case 0:	//!< +-250 degrees per second Max measurement
-			//ret = ( (float) ( (  raw + 32768) * 500 ) / 65535 ) - 250;
-			ret = (float) raw / 131.072; 
-			break;
-			
-		case 1: //!< +-500 degrees per second Max measurement
-			//ret = ( (float) ( ( raw + 32768) * 1000 ) / 65535 ) - 500;
-			ret = (float) raw / 65.536;
-			break;
-			
-		case 2: //!< +-1000 degrees per second Max measurement
-			//ret = ( (float) ( ( raw + 32768) * 2000 )/ 65535 ) - 1000;
-			ret = (float) raw / 32.768;
-			break;
-			
-		case 3: //!< +-2000 degrees per second Max measurement
-			//ret = ( (float) ( ( raw + 32768) * 4000 )/ 65535 ) - 2000;
-			ret = (float) raw / 16.384;
-			break;
-			
-		default:
-			ret = (float) raw;
-			break;
+static uint8_t write_reg_mpu6050(mpu6050_dev_t *dev, uint8_t reg, uint8_t data){
+	return write_burst_mpu6050(dev, reg, &data, 1);
+}
+
+/*! \brief  Get the copy of a configuration register
+ *
+ *	\note	This function is for internal use
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	reg		register of which the copy is needed
+ *
+ *  \return pointer to the copy in the device struct, 0 if the register has no copy
+ */
+static uint8_t *shadow_mpu6050(mpu6050_dev_t *dev, uint8_t reg){
+	for(uint8_t i = 0; i < MPU6050_SHADOW_REGS; i++){
+		if(shadow_regs[i] == reg) return &dev->shadow[i];
 	}
 	
-	return ret;
+	return 0;
 }
 
-/*! \brief  Get the gyroscope scale/range
+/*! \brief  Reads the clock of the device
  *
- *  \param  raw		value that is used to calculate G-force
- *	\param	range	value to specify in what range the raw value was read
+ *	\note	This function is for internal use
  *
- *  \return G-force if the input range is invalid the raw value will be returned
+ *  \param  *dev	pointer to the MPU6050 device
+ *
+ *  \return value of clock_us, 0 if the device has no clock
  */
-static float accel_val_to_g_mpu6050(int16_t raw, uint8_t range){
-	float ret;
-	switch(range){
-		case 0: //!< +-2G Max measurement
-			// ret = ( (float)  ( raw + 32768) * 4 ) /  65535 ) - 2;
-			ret = (float) raw / 16384;
-			break;
-			
-		case 1: //!< +-4G Max measurement
-			//ret = ( (float) ( ( raw + 32768) * 8 ) /  65535 ) - 4;
-			ret = (float) raw / 8192;
-			break;
-			
-		case 2: //!< +-8G Max measurement
-			//ret = ( (float) ( ( raw + 32768) * 16 ) / 65535 ) - 8;
-			ret = (float) raw / 4096;
-			break;
-			
-		case 3: //!< +-16G Max measurement
-			//ret = ( (float) ( ( raw + 32768) * 32 ) / 65535 ) - 16;
-			ret = (float) raw / 2048;
-			break;
-			
-		default: 
-			ret = (float) raw;
-			break;
+static uint32_t clock_now_mpu6050(mpu6050_dev_t *dev){
+	if(dev->clock_us == 0) return 0;
+	return dev->clock_us();
+}
+
+/*! \brief  Sets the copies of the configuration registers to their power up values
+ *
+ *	\note	This function is for internal use
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ */
+static void shadow_defaults_mpu6050(mpu6050_dev_t *dev){
+	for(uint8_t i = 0; i < MPU6050_SHADOW_REGS; i++){
+		dev->shadow[i] = 0;
 	}
 	
-	return ret;
+	(*shadow_mpu6050(dev, MPU_6050_PWR_MGMT_1)) = (1 << 6);	//!< The MPU6050 starts in sleep mode
 }
 
-/*! \brief  Get calibration data Gyro x axis
+/*! \brief  Changes bits of a configuration register without reading it
  *
- *  \param  *twi	pointer to the TWI module that is connected to the MPU6050
- *	\param	addr	address of the MPU6050
+ *	\note	This function is for internal use
+ *
+ *	The new value is computed from the copy in the device struct and is only written if it differs from that copy.
  *
- *  \return 0 if successful 1 if unsuccessful full
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	reg		register that needs to be changed, needs to be one of shadow_regs
+ *	\param	data	new value of the bits that are selected by mask
+ *	\param	mask	bits that need to be changed
+ *
+ *  \return status code of the TWI library
  */
-uint8_t calibrate_gyro_x_mpu6050(TWI_t *twi, uint8_t addr){
-	uint8_t range[] = { MPU6050_GYRO_SCL_250, MPU6050_GYRO_SCL_500, MPU6050_GYRO_SCL_1000, MPU6050_GYRO_SCL_2000};
-	uint8_t err;
-	int32_t sum;
-	int16_t value;
+static uint8_t update_reg_mpu6050(mpu6050_dev_t *dev, uint8_t reg, uint8_t data, uint8_t mask){
+	uint8_t err, value;
+	uint8_t *shadow = shadow_mpu6050(dev, reg);
 	
-	for(uint8_t i = 0; i < 4; i++){
-		sum = 0;	
-		err = gyro_set_scale_mpu6050(twi, addr, range[i]); //  Selecting the range
-		//if(check_err_mpu6050(err) != 0) return 1;
-		
-		for(uint16_t j = 0; j < 700; j++){	//  Loop to get average offset
-			
-			err = get_gyro_x_raw_mpu6050(twi, addr, &value);
-			//if(check_err_mpu6050(err) != 0) return 1;
-			
-			sum += value;
-		}
-		
-		ACCELX_OFFSET_MPU6050[i] = (float) sum / 700;
-	}
+	value = ((*shadow) & ~mask) | (data & mask);
+	if(value == (*shadow)) return TWI_STATUS_OK;
 	
-	err = gyro_set_scale_mpu6050(twi, addr, MPU6050_GYRO_SCL_250);
-	if(check_err_mpu6050(err) != 0) return 1;
+	err = write_reg_mpu6050(dev, reg, value);
+	if(err != TWI_STATUS_OK) return err;
 	
-	return 0;
+	(*shadow) = value;
+	
+	return TWI_STATUS_OK;
 }
 
-/*! \brief  Get calibration data Gyro y axis
+/*! \brief  Reads the configuration registers into their copies in the device struct
  *
- *  \param  *twi	pointer to the TWI module that is connected to the MPU6050
- *	\param	addr	address of the MPU6050
+ *	The library keeps a copy of the writable configuration registers so it does not need to read them before
+ *	changing them. Call this function when the registers could have been changed without the library, 
+ *	for example after a power cycle of only the MPU6050.
+ *
+ *  \param  *dev	pointer to the MPU6050 device
  *
- *  \return 0 if successful 1 if unsuccessful full
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
  */
-uint8_t calibrate_gyro_y_mpu6050(TWI_t *twi, uint8_t addr){
-	uint8_t range[] = { MPU6050_GYRO_SCL_250, MPU6050_GYRO_SCL_500, MPU6050_GYRO_SCL_1000, MPU6050_GYRO_SCL_2000};
+uint8_t resync_mpu6050(mpu6050_dev_t *dev){
 	uint8_t err;
-	int32_t sum;
-	int16_t value;
+	MPU6050_ACCEL_CONFIG_TYPE ACCEL;
+	MPU6050_GYRO_CONFIG_TYPE GYRO;
 	
-	for(uint8_t i = 0; i < 4; i++){
-		sum = 0;
-		err = gyro_set_scale_mpu6050(twi, addr, range[i]); //!<  Selecting the range
-		//if(check_err_mpu6050(err) != 0) return 1;
-		
-		for(uint16_t j = 0; j < 700; j++){	//!<  Loop to get average offset
-			
-			err = get_gyro_y_raw_mpu6050(twi, addr, &value);
-			//if(check_err_mpu6050(err) != 0) return 1;
-			
-			sum += value;
-		}
-		
-		ACCELX_OFFSET_MPU6050[i] = (float) sum / 700;
+	for(uint8_t i = 0; i < MPU6050_SHADOW_REGS; i++){
+		err = read_reg_mpu6050(dev, shadow_regs[i], &dev->shadow[i]);
+		if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
 	}
 	
-	err = gyro_set_scale_mpu6050(twi, addr, MPU6050_GYRO_SCL_250);
-	if(check_err_mpu6050(err) != 0) return 1;
+	ACCEL.ACCEL_CONFIG = (*shadow_mpu6050(dev, MPU_6050_ACCEL_CONFIG));
+	GYRO.GYRO_CONFIG = (*shadow_mpu6050(dev, MPU_6050_GYRO_CONFIG));
+	dev->accel_state = ACCEL.AFS_SEL;
+	dev->gyro_state = GYRO.FS_SEL;
 	
-	return 0;	
+	return 0;
 }
 
-/*! \brief  Get calibration data Gyro z axis
+/*! \brief  Reads a 16 bit sensor value in one I2C transaction
  *
- *  \param  *twi	pointer to the TWI module that is connected to the MPU6050
- *	\param	addr	address of the MPU6050
+ *	\note	This function is for internal use
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	reg_h	register that holds the high byte of the value
+ *	\param	*data	pointer to store the value
  *
- *  \return 0 if successful 1 if unsuccessful full
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
  */
-uint8_t calibrate_gyro_z_mpu6050(TWI_t *twi, uint8_t addr){
-	uint8_t range[] = { MPU6050_GYRO_SCL_250, MPU6050_GYRO_SCL_500, MPU6050_GYRO_SCL_1000, MPU6050_GYRO_SCL_2000};
-	uint8_t err;
-	int32_t sum;
-	int16_t value;
+static uint8_t read_16bit_mpu6050(mpu6050_dev_t *dev, uint8_t reg_h, int16_t *data){
+	uint8_t err, buff[2];
+	data16_t value;
 	
-	for(uint8_t i = 0; i < 4; i++){
-		sum = 0;
-		err = gyro_set_scale_mpu6050(twi, addr, range[i]); //!<  Selecting the range
-		//if(check_err_mpu6050(err) != 0) return 1;
-		
-		for(uint16_t j = 0; j < 700; j++){	//!<  Loop to get average offset
-			
-			err = get_gyro_z_raw_mpu6050(twi, addr, &value);
-			//if(check_err_mpu6050(err) != 0) return 1;
-			
-			sum += value;
-		}
-		
-		ACCELX_OFFSET_MPU6050[i] = (float) sum / 700;
-	}
+	err = read_burst_mpu6050(dev, reg_h, buff, 2);
+	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
 	
-	err = gyro_set_scale_mpu6050(twi, addr, MPU6050_GYRO_SCL_250);
-	if(check_err_mpu6050(err) != 0) return 1;
+	value.DATAH = buff[0];
+	value.DATAL = buff[1];
+	(*data) = value.DATA;
 	
-	return 0;	
+	return 0;
 }
 
-/*! \brief  Get calibration data accelerometer x axis
+/*! \brief  Converts the big endian output registers to a motion frame
  *
- *  \param  *twi	pointer to the TWI module that is connected to the MPU6050
- *	\param	addr	address of the MPU6050
+ *	\note	This function is for internal use
  *
- *  \return 0 if successful 1 if unsuccessful full
+ *  \param  *buff	MPU6050_MOTION_BYTES bytes read starting at MPU_6050_ACCEL_XOUT_H
+ *	\param	*data	pointer to store the motion frame
  */
-uint8_t calibrate_accel_x_mpu6050(TWI_t *twi, uint8_t addr){
-	uint8_t range[] = { MPU6050_ACCEL_SCL_2G, MPU6050_ACCEL_SCL_4G, MPU6050_ACCEL_SCL_8G, MPU6050_ACCEL_SCL_16G};
-	uint8_t err;
-	int32_t sum;
-	int16_t value;
-	
-	for(uint8_t i = 0; i < 4; i++){
-		sum = 0;
-		err = accel_set_scale_mpu6050(twi, addr, range[i]); //!<  Selecting the range
-		//if(check_err_mpu6050(err) != 0) return 1;
-		
-		for(uint16_t j = 0; j < 700; j++){	//!<  Loop to get average offset
-			
-			err = get_accel_x_raw_mpu6050(twi, addr, &value);
-			//if(check_err_mpu6050(err) != 0) return 1;
-			
-			sum += value;
-		}
-		
-		ACCELX_OFFSET_MPU6050[i] = (float) sum / 700;
+static void unpack_motion_mpu6050(const uint8_t *buff, mpu6050_motion_t *data){
+	for(uint8_t i = 0; i < 3; i++){
+		data->accel[i] = (int16_t) ( (buff[2 * i] << 8) | buff[2 * i + 1] );
+		data->gyro[i] = (int16_t) ( (buff[8 + 2 * i] << 8) | buff[9 + 2 * i] );
 	}
-	
-	err = accel_set_scale_mpu6050(twi, addr, MPU6050_GYRO_SCL_250);
-	if(check_err_mpu6050(err) != 0) return 1;
-	
-	return 0;	
+	data->temp = (int16_t) ( (buff[6] << 8) | buff[7] );
 }
 
-/*! \brief  Get calibration data accelerometer y axis
+#ifdef __AVR__
+/*! \brief  Initializes the device struct of an MPU6050 that is connected to a TWI module of the Xmega
  *
+ *	Every MPU6050 needs its own device struct, this function does not communicate with the MPU6050.
+ *
+ *  \param  *dev	pointer to the MPU6050 device
  *  \param  *twi	pointer to the TWI module that is connected to the MPU6050
  *	\param	addr	address of the MPU6050
- *
- *  \return 0 if successful 1 if unsuccessful full
  */
-uint8_t calibrate_accel_y_mpu6050(TWI_t *twi, uint8_t addr){
-	uint8_t range[] = { MPU6050_ACCEL_SCL_2G, MPU6050_ACCEL_SCL_4G, MPU6050_ACCEL_SCL_8G, MPU6050_ACCEL_SCL_16G};
-	uint8_t err;
-	int32_t sum;
-	int16_t value;
-	
-	for(uint8_t i = 0; i < 4; i++){
-		sum = 0;
-		err = accel_set_scale_mpu6050(twi, addr, range[i]); //!<  Selecting the range
-		//if(check_err_mpu6050(err) != 0) return 1;
-		
-		for(uint16_t j = 0; j < 700; j++){	//!<  Loop to get average offset
-			
-			err = get_accel_y_raw_mpu6050(twi, addr, &value);
-			//if(check_err_mpu6050(err) != 0) return 1;
-			
-			sum += value;
-		}
-		
-		ACCELX_OFFSET_MPU6050[i] = (float) sum / 700;
-	}
+void init_mpu6050(mpu6050_dev_t *dev, TWI_t *twi, uint8_t addr){
+	const mpu6050_bus_t bus = { twi_bus_read_mpu6050, twi_bus_write_mpu6050, twi, twi_bus_recover_mpu6050, twi_bus_read_async_mpu6050 };
 	
-	err = accel_set_scale_mpu6050(twi, addr, MPU6050_GYRO_SCL_250);
-	if(check_err_mpu6050(err) != 0) return 1;
-	
-	return 0;	
+	init_bus_mpu6050(dev, &bus, addr);
+	dev->twi = twi;
+	async_slot_mpu6050(twi);	//!< Takes the slot of the TWI module outside of the interrupts
 }
+#endif
 
-/*! \brief  Get calibration data accelerometer z axis
+/*! \brief  Initializes the device struct of an MPU6050 that is connected to another transport
  *
- *  \param  *twi	pointer to the TWI module that is connected to the MPU6050
+ *	Every MPU6050 needs its own device struct, this function does not communicate with the MPU6050.
+ *	The bus is copied into the device struct. read_async_mpu6050 needs a transport with read_async,
+ *	the interrupt driven acquisition is only available for an MPU6050 that is initialized with init_mpu6050.
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *  \param  *bus	pointer to the transport that is connected to the MPU6050
  *	\param	addr	address of the MPU6050
+ */
+void init_bus_mpu6050(mpu6050_dev_t *dev, const mpu6050_bus_t *bus, uint8_t addr){
+	memset(dev, 0, sizeof(*dev));
+	
+	dev->bus = *bus;
+	dev->addr = addr;
+	dev->fifo_watermark = 1;
+	dev->hw_offsets = 1;
+	dev->retry.attempts = MPU6050_RETRY_ATTEMPTS;
+	dev->retry.recover_after = MPU6050_RETRY_RECOVER;
+	dev->retry.backoff_us = MPU6050_RETRY_BACKOFF_US;
+	dev->retry.backoff_max_us = MPU6050_RETRY_BACKOFF_MAX_US;
+	dev->retry.deadline_us = MPU6050_RETRY_DEADLINE_US;
+	
+	shadow_defaults_mpu6050(dev);
+#ifdef MPU6050_STATS
+	stats_clear_mpu6050(dev);
+#endif
+}
+
+/*! \brief  Enables the MPU6050
+ *
+ *	\note The device struct needs to be initialized with init_mpu6050 first.
+ *
+ *	If store of the device struct is set and holds a valid calibration record of this MPU6050 the
+ *	calibration is loaded from it, otherwise the MPU6050 is calibrated and the record is saved.
+ *	If hw_offsets of the device struct is set the offsets are programmed into the MPU6050 before the record is saved.
+ *	A record with programmed offset registers is written to the MPU6050 as it is, so the offsets are not applied 
+ *	again when the Xmega restarts without a power cycle of the MPU6050.
+ *
+ *  \param  *dev	pointer to the MPU6050 device
  *
- *  \return 0 if successful 1 if unsuccessful full
+ *  \return	0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2	
  */
-uint8_t calibrate_accel_z_mpu6050(TWI_t *twi, uint8_t addr){
-	uint8_t range[] = { MPU6050_ACCEL_SCL_2G, MPU6050_ACCEL_SCL_4G, MPU6050_ACCEL_SCL_8G, MPU6050_ACCEL_SCL_16G};
-	uint8_t err;
-	int32_t sum;
-	int16_t value;
+uint8_t enable_mpu6050(mpu6050_dev_t *dev){
+	uint8_t err; 
 	
-	for(uint8_t i = 0; i < 4; i++){
-		sum = 0;
-		err = accel_set_scale_mpu6050(twi, addr, range[i]); //!<  Selecting the range
-		//if(check_err_mpu6050(err) != 0) return 1;
+	for(uint8_t i = 0; i < 3; i++){
+		for(uint8_t j = 0; j < 4; j++){
+			dev->accel_offset[i][j] = 0;
+			dev->gyro_offset[i][j] = 0;
+		}
+	}
+	dev->hw_valid = 0;
 		
-		for(uint16_t j = 0; j < 700; j++){	//!<  Loop to get average offset
-			
-			err = get_accel_z_raw_mpu6050(twi, addr, &value);
-			//if(check_err_mpu6050(err) != 0) return 1;
-			
-			sum += value;
+	err = resync_mpu6050(dev);
+	if(err != 0) return err;
+	
+	err = update_reg_mpu6050(dev, MPU_6050_PWR_MGMT_1, 0, 0xFF);
+	if(check_err_mpu6050(err) != 0) return err;
+	
+	//err = enable_temp_mpu6050(dev);
+	//if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	
+	err = stdby_all_mpu6050(dev, OFF);
+	if(err != 0) return err;
+	
+	if(dev->store == 0 || calib_load_mpu6050(dev) != 0){
+		err = calibrate_mpu6050(dev, MPU6050_CAL_SAMPLES);
+		if(err != 0) return err;
+		
+		if(dev->hw_offsets){
+			err = hw_offsets_program_mpu6050(dev);
+			if(err != 0) return err;
 		}
 		
-		ACCELX_OFFSET_MPU6050[i] = (float) ( sum / 700 ) - 1;
+		if(dev->store != 0) calib_save_mpu6050(dev);
+	}
+	else if(dev->hw_valid){
+		err = hw_offsets_write_mpu6050(dev);	//!< Absolute values, the registers can already hold them
+		if(err != 0) return err;
+	}
+	else if(dev->hw_offsets){
+		err = hw_offsets_program_mpu6050(dev);	//!< The record was measured with the factory values
+		if(err != 0) return err;
+		
+		calib_save_mpu6050(dev);
 	}
 	
-	err = accel_set_scale_mpu6050(twi, addr, MPU6050_GYRO_SCL_250);
-	if(check_err_mpu6050(err) != 0) return 1;
+	accel_set_scale_mpu6050(dev, MPU6050_ACCEL_SCL_2G);
+	gyro_set_scale_mpu6050(dev, MPU6050_GYRO_SCL_250);
 	
-	return 0;	
+	return MPU6050_TWI_OK;	
 }
 
-/*! \brief  Get temperature
+/*! \brief  Disables the MPU6050
  *
- *  \param  *twi	pointer to the TWI module that is connected to the MPU6050
- *	\param	addr	address of the MPU6050
- *	\param	data	pointer to store temperature data
+ *  \param  *dev	pointer to the MPU6050 device
  *
  *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
  */
-uint8_t get_temp_mpu6050(TWI_t *twi, uint8_t addr, float *data){
-	uint8_t err, read;
-	TEMP16_t temp;
-	float ret;
+uint8_t disable_mpu6050(mpu6050_dev_t *dev){
+	uint8_t err;
 	
-	err = read_8bit_register_TWI(twi, addr, &read, MPU_6050_TEMP_OUT_L);
+	err = disable_temp_mpu6050(dev);
 	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
-	temp.DATAL = read;
-	
-	err = read_8bit_register_TWI(twi, addr, &read, MPU_6050_TEMP_OUT_H);
-	if (check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
-	temp.DATAH = (read << 0);
-	
-	ret = temp.TEMP;
 	
-	ret = (ret  / 340) + 36.53;
+	err = update_reg_mpu6050(dev, MPU_6050_PWR_MGMT_2, 0x3F, 0x3F);	//!< Makes the Gyroscope and the accelerometer inactive
+	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
 	
-	(*data) = ret;
+	err = sleep_mpu6050(dev);
+	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
 	
 	return 0;	
 }
 
-/*! \brief  Enables interrupts from the MPU6050
+/*! \brief  Wakes the MPU6050 from sleep
  *
- *  \param  *twi	pointer to the TWI module that is connected to the MPU6050
- *	\param	addr	address of the MPU6050
- *	\param	interupt	byte to select what interrupt will be enabled
+ *  \param  *dev	pointer to the MPU6050 device
  *
  *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
  */
-uint8_t int_enable_mpu6050(TWI_t *twi, uint8_t addr, uint8_t interupt){
-	uint8_t reg_old, err;
-	
-	err = read_8bit_register_TWI(twi, addr, &reg_old, MPU_6050_INT_ENABLE);
-	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
-	
-	reg_old = (1 << interupt);
+uint8_t wake_up_mpu6050(mpu6050_dev_t *dev){
+	uint8_t err;
 	
-	err = write_8bit_register_TWI(twi, addr, reg_old, MPU_6050_INT_ENABLE);
+	err = update_reg_mpu6050(dev, MPU_6050_PWR_MGMT_1, (0 << 6), (1 << 6)); //!< Disables sleep
 	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
 	
 	return 0;
 }
 
-/*! \brief  Disables interrupts from the MPU6050
+/*! \brief  Lets the MPU6050 go to sleep
  *
- *  \param  *twi	pointer to the TWI module that is connected to the MPU6050
- *	\param	addr	address of the MPU6050
- *	\param	interupt	byte to select what interrupt will be disabled
+ *  \param  *dev	pointer to the MPU6050 device
  *
  *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
  */
-uint8_t int_disable_mpu6050(TWI_t *twi, uint8_t addr, uint8_t interupt){
-	uint8_t reg_old, err;
-	
-	err = read_8bit_register_TWI(twi, addr, &reg_old, MPU_6050_INT_ENABLE);
-	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
-	
-	reg_old = (0 << interupt);
+uint8_t sleep_mpu6050(mpu6050_dev_t *dev){
+	uint8_t err;
 	
-	err = write_8bit_register_TWI(twi, addr, reg_old, MPU_6050_INT_ENABLE);
+	err = update_reg_mpu6050(dev, MPU_6050_PWR_MGMT_1, (1 << 6), (1 << 6)); //!< Enables sleep
 	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
 	
 	return 0;	
 }
 
-/*! \brief  checks what caused the interrupt from the MPU6050
+/*! \brief  Puts the MPU6050 in the low power accelerometer mode
  *
- *  \param  *twi	pointer to the TWI module that is connected to the MPU6050
- *	\param	addr	address of the MPU6050
+ *	The gyroscopes are put in standby and the temperature sensor is disabled. The MPU6050 sleeps and
+ *	wakes up at rate to take one accelerometer sample. The internal oscillator is selected because 
+ *	the gyroscopes can not be used as clock. The data ready interrupt follows the wake up rate, 
+ *	read the samples with get_accel_raw_mpu6050. The interrupt driven acquisition only reads the 
+ *	accelerometer in this mode.
  *
- *  \return returns 1 if TWI/I2C bus is in use returns 2 if something went wrong. 
- *			returns 3 if FIFO_OVF_INT is 1
- *			returns 4 if I2C_MST_INT is 1
- *			returns 5 if DATA_RDY_INT is 1
- *			returns 7 if FIFO_OVF_INT is 1 and I2C_MST_INT is 1
- *			returns 8 if FIFO_OVF_INT is 1 and DATA_RDY_INT is 1
- *			returns 9 if I2C_MST_INT is 1 and DATA_RDY_INT is 1
- *			returns 12 if FIFO_OVF_INT is 1 and I2C_MST_INT is 1 and DATA_RDY_INT is 1
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	rate	wake up rate, one of MPU6050_LP_WAKE_x
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
  */
-uint8_t what_happend_mpu6050(TWI_t *twi, uint8_t addr){
-	uint8_t err, ret = 0;
-	MPU6050_INT_STATUS_TYPE int_status;
+uint8_t lp_accel_mode_mpu6050(mpu6050_dev_t *dev, uint8_t rate){
+	uint8_t err;
+	MPU6050_PWR_MGMT_1_TYPE PWR_MGMT_1;
+	MPU6050_PWR_MGMT_2_TYPE PWR_MGMT_2;
 	
-	err = read_8bit_register_TWI(twi, addr, &int_status.int_reg, MPU_6050_INT_STATUS);
+	PWR_MGMT_2.PWR_MGMT_2 = 0;
+	PWR_MGMT_2.LP_WAKE_CTRL = rate;
+	PWR_MGMT_2.STBY_XG = 1;
+	PWR_MGMT_2.STBY_YG = 1;
+	PWR_MGMT_2.STBY_ZG = 1;
+	
+	err = update_reg_mpu6050(dev, MPU_6050_PWR_MGMT_2, PWR_MGMT_2.PWR_MGMT_2, 0xFF);
 	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
 	
-	if(int_status.FIFO_OFLOW == 1) ret += 3;
-	if(int_status.I2C_MST == 1) ret += 4;
-	if(int_status.DATA_RDY == 1) ret += 5;
+	PWR_MGMT_1.PWR_MGMT_1 = 0;
+	PWR_MGMT_1.CYCLE = 1;
+	PWR_MGMT_1.TEMP_DIS = 1;
+	PWR_MGMT_1.CLKSEL = MPU6050_CLK_8MHZ;
 	
-	return ret;
+	err = update_reg_mpu6050(dev, MPU_6050_PWR_MGMT_1, PWR_MGMT_1.PWR_MGMT_1, 0x6F);	//!< Keeps DEVICE_RESET 0
+	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	
+	return 0;
 }
 
-/*! \brief  Read external sensor value from the MPU6050
+/*! \brief  Ends the low power accelerometer mode
  *
- *	\warning External sensors for the MPU6050 are not supported by this library!
+ *	Cycle mode is disabled, the gyroscopes and the temperature sensor are enabled again.
+ *	The clock source stays the internal oscillator.
  *
- *  \param  *twi	pointer to the TWI module that is connected to the MPU6050
- *	\param	addr	address of the MPU6050
- *	\param	reg		byte to select which external sensor register needs to be read
- *	\param	*data	pointer to store the external sensor value
+ *  \param  *dev	pointer to the MPU6050 device
  *
  *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
  */
-uint8_t ext_sens_value_mpu6050(TWI_t *twi, uint8_t addr, uint8_t reg, uint8_t *data){
-		uint8_t err, sensor_value;
-		
-		err = read_8bit_register_TWI(twi, addr, &sensor_value, reg);
-		if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
-				
+uint8_t lp_accel_exit_mpu6050(mpu6050_dev_t *dev){
+	uint8_t err;
+	
+	err = update_reg_mpu6050(dev, MPU_6050_PWR_MGMT_1, 0, (1 << 5) | (1 << 3));	//!< CYCLE and TEMP_DIS
+	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	
+	err = update_reg_mpu6050(dev, MPU_6050_PWR_MGMT_2, 0, 0xFF);
+	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	
+	return 0;
+}
+
+/*! \brief  Get x-axis accelerometer data without calibration
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	data	pointer to store accelerometer x direction data
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ */
+uint8_t get_accel_x_raw_mpu6050(mpu6050_dev_t *dev, int16_t *data){
+	return read_16bit_mpu6050(dev, MPU_6050_ACCEL_XOUT_H, data);
+}
+
+/*! \brief  Get y-axis accelerometer data without calibration
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	data	pointer to store accelerometer y direction data
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ */
+uint8_t get_accel_y_raw_mpu6050(mpu6050_dev_t *dev, int16_t *data){
+	return read_16bit_mpu6050(dev, MPU_6050_ACCEL_YOUT_H, data);
+}
+
+/*! \brief  Get z-axis accelerometer data
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	data	pointer to store accelerometer z direction data
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ */
+uint8_t get_accel_z_raw_mpu6050(mpu6050_dev_t *dev, int16_t *data){
+	return read_16bit_mpu6050(dev, MPU_6050_ACCEL_ZOUT_H, data);
+}
+
+/*! \brief  Get x-axis gyroscope data
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	data	pointer to store gyroscope x direction data
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ */
+uint8_t get_gyro_x_raw_mpu6050(mpu6050_dev_t *dev, int16_t *data){
+	return read_16bit_mpu6050(dev, MPU_6050_GYRO_XOUT_H, data);
+}
+
+/*! \brief  Get y-axis gyroscope data
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	data	pointer to store gyroscope y direction data
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ */
+uint8_t get_gyro_y_raw_mpu6050(mpu6050_dev_t *dev, int16_t *data){
+	return read_16bit_mpu6050(dev, MPU_6050_GYRO_YOUT_H, data);
+}
+
+/*! \brief  Get z-axis gyroscope data
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	data	pointer to store gyroscope z direction data
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ */
+uint8_t get_gyro_z_raw_mpu6050(mpu6050_dev_t *dev, int16_t *data){
+	return read_16bit_mpu6050(dev, MPU_6050_GYRO_ZOUT_H, data);
+}
+
+/*! \brief  Get accelerometer and gyroscope data of all axes without calibration
+ *
+ *	All registers from MPU_6050_ACCEL_XOUT_H up to MPU_6050_GYRO_ZOUT_L are read in one burst,
+ *	so all axes belong to the same sample. The temp field of data is set to 0.
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	*data	pointer to store the motion frame
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ */
+uint8_t get_motion6_raw_mpu6050(mpu6050_dev_t *dev, mpu6050_motion_t *data){
+	uint8_t err;
+	
+	err = get_motion7_raw_mpu6050(dev, data);
+	if(err != 0) return err;
+	
+	data->temp = 0;
+	
+	return 0;
+}
+
+/*! \brief  Get motion data and external sensor data without calibration
+ *
+ *	MPU_6050_EXT_SENS_DATA_00 directly follows MPU_6050_GYRO_ZOUT_L, so the motion frame and the first
+ *	len external sensor data registers are read in one burst and belong to the same sample.
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	*data	pointer to store the motion frame
+ *	\param	*ext	pointer to store len bytes of external sensor data
+ *	\param	len		amount of external sensor data registers, at most MPU6050_EXT_SENS_BYTES
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ */
+uint8_t get_motion_ext_raw_mpu6050(mpu6050_dev_t *dev, mpu6050_motion_t *data, uint8_t *ext, uint8_t len){
+	uint8_t err, buff[MPU6050_MOTION_BYTES + MPU6050_EXT_SENS_BYTES];
+	uint32_t stamp = clock_now_mpu6050(dev);
+	
+	if(len > MPU6050_EXT_SENS_BYTES) len = MPU6050_EXT_SENS_BYTES;
+	
+	err = read_burst_mpu6050(dev, MPU_6050_ACCEL_XOUT_H, buff, MPU6050_MOTION_BYTES + len);
+	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	
+	unpack_motion_mpu6050(buff, data);
+	data->time_us = stamp;
+	for(uint8_t i = 0; i < len; i++) ext[i] = buff[MPU6050_MOTION_BYTES + i];
+	
+	return 0;
+}
+
+/*! \brief  Get accelerometer, temperature and gyroscope data without calibration
+ *
+ *	All registers from MPU_6050_ACCEL_XOUT_H up to MPU_6050_GYRO_ZOUT_L are read in one burst,
+ *	so all values belong to the same sample. The time stamp is the time at the start of the read, 
+ *	the sample can be up to one sample period older. Use the interrupt driven acquisition or the FIFO
+ *	for time stamps that do not depend on when the sample is read.
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	*data	pointer to store the motion frame
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ */
+uint8_t get_motion7_raw_mpu6050(mpu6050_dev_t *dev, mpu6050_motion_t *data){
+	uint8_t err, buff[MPU6050_MOTION_BYTES];
+	uint32_t stamp = clock_now_mpu6050(dev);
+	
+	err = read_burst_mpu6050(dev, MPU_6050_ACCEL_XOUT_H, buff, MPU6050_MOTION_BYTES);
+	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	
+	unpack_motion_mpu6050(buff, data);
+	data->time_us = stamp;
+	
+	return 0;
+}
+
+/*! \brief  Get accelerometer data of all axes without calibration
+ *
+ *	Only the registers from MPU_6050_ACCEL_XOUT_H up to MPU_6050_ACCEL_ZOUT_L are read in one burst,
+ *	use this function in the low power accelerometer mode.
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	*data	pointer to store the x, y and z accelerometer values
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ */
+uint8_t get_accel_raw_mpu6050(mpu6050_dev_t *dev, int16_t *data){
+	uint8_t err, buff[MPU6050_ACCEL_BYTES];
+	
+	err = read_burst_mpu6050(dev, MPU_6050_ACCEL_XOUT_H, buff, MPU6050_ACCEL_BYTES);
+	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	
+	for(uint8_t i = 0; i < 3; i++){
+		data[i] = (int16_t) ( (buff[2 * i] << 8) | buff[2 * i + 1] );
+	}
+	
+	return 0;
+}
+
+/*! \brief  Get x-axis accelerometer data
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	data	pointer to store accelerometer x direction data
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ */
+uint8_t get_accel_x_mpu6050(mpu6050_dev_t *dev, float *data){
+	uint8_t err;
+	int16_t raw;
+	
+	err = get_accel_x_raw_mpu6050(dev, &raw);
+	if(err != 0) return err;
+	
+	raw -= dev->accel_offset[0][dev->accel_state];
+	float ret = accel_val_to_g_mpu6050(raw, dev->accel_state);
+	
+	
+	(*data) = ret;
+	
+	return 0;
+}
+
+/*! \brief  Get y-axis accelerometer data
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	data	pointer to store accelerometer y direction data
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ */
+uint8_t get_accel_y_mpu6050(mpu6050_dev_t *dev, float *data){
+		uint8_t err;
+		int16_t raw;
+		
+		err = get_accel_y_raw_mpu6050(dev, &raw);
+		if(err != 0) return err;
+		
+		raw -= dev->accel_offset[1][dev->accel_state];
+		float ret = accel_val_to_g_mpu6050(raw, dev->accel_state);
+		
+		
+		(*data) = ret;
+		
+		return 0;	
+}
+
+/*! \brief  Get z-axis accelerometer data
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	data	pointer to store accelerometer z direction data
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ */
+uint8_t get_accel_z_mpu6050(mpu6050_dev_t *dev, float *data){
+	uint8_t err;
+	int16_t raw;
+	
+	err = get_accel_z_raw_mpu6050(dev, &raw);
+	if(err != 0) return err;
+	
+	raw -= dev->accel_offset[2][dev->accel_state];
+	float ret = accel_val_to_g_mpu6050(raw, dev->accel_state);
+	
+	
+	(*data) = ret;
+	
+	return 0;	
+}
+
+/*! \brief  Get x-axis gyroscope data
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	data	pointer to store gyroscope x direction data
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ */
+uint8_t get_gyro_x_mpu6050(mpu6050_dev_t *dev, float *data){
+	uint8_t err;
+	int16_t raw;
+	
+	err = get_gyro_x_raw_mpu6050(dev, &raw);
+	if(err != 0) return err;
+	
+	raw -= dev->gyro_offset[0][dev->gyro_state];	
+	float ret = gyro_degrees_sec_mpu6050(raw, dev->gyro_state);
+	
+	(*data) = ret;
+	
+	return 0;
+}
+
+/*! \brief  Get y-axis gyroscope data
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	data	pointer to store gyroscope y direction data
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ */
+uint8_t get_gyro_y_mpu6050(mpu6050_dev_t *dev, float *data){
+	uint8_t err;
+	int16_t raw;
+	
+	err = get_gyro_y_raw_mpu6050(dev, &raw);
+	if(err != 0) return err;
+	
+	raw -= dev->gyro_offset[1][dev->gyro_state];
+	float ret = gyro_degrees_sec_mpu6050(raw, dev->gyro_state);
+	
+	
+	(*data) = ret;
+	
+	return 0;	
+}
+
+/*! \brief  Get z-axis gyroscope data
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	data	pointer to store gyroscope z direction data
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ */
+uint8_t get_gyro_z_mpu6050(mpu6050_dev_t *dev, float *data){
+	uint8_t err;
+	int16_t raw;
+	
+	err = get_gyro_z_raw_mpu6050(dev, &raw);
+	if(err != 0) return err;
+	
+	raw -= dev->gyro_offset[2][dev->gyro_state];
+	float ret = gyro_degrees_sec_mpu6050(raw, dev->gyro_state);
+	
+	
+	(*data) = ret;
+	
+	return 0;
+}
+
+/*! \brief  Get the gyroscope scale/range
+ *
+ *  \param  raw		value that is used to calculate degrees per second
+ *	\param	range	value to specify in what range the raw value was read
+ *
+ *  \return degrees per second if the input range is invalid the raw value will be returned
+ */
+static float gyro_degrees_sec_mpu6050(int16_t raw, uint8_t range){
+	static const float dps_per_lsb[4] = {
+		1 / 131.072,	//!< +-250 degrees per second Max measurement
+		1 / 65.536,		//!< +-500 degrees per second Max measurement
+		1 / 32.768,		//!< +-1000 degrees per second Max measurement
+		1 / 16.384		//!< +-2000 degrees per second Max measurement
+	};
+	
+	if(range > MPU6050_GYRO_SCL_2000) return (float) raw;
+	
+	return (float) raw * dps_per_lsb[range];
+}
+
+/*! \brief  Get the gyroscope scale/range
+ *
+ *  \param  raw		value that is used to calculate G-force
+ *	\param	range	value to specify in what range the raw value was read
+ *
+ *  \return G-force if the input range is invalid the raw value will be returned
+ */
+static float accel_val_to_g_mpu6050(int16_t raw, uint8_t range){
+	static const float g_per_lsb[4] = {
+		1.0 / 16384,	//!< +-2G Max measurement
+		1.0 / 8192,		//!< +-4G Max measurement
+		1.0 / 4096,		//!< +-8G Max measurement
+		1.0 / 2048		//!< +-16G Max measurement
+	};
+	
+	if(range > MPU6050_ACCEL_SCL_16G) return (float) raw;
+	
+	return (float) raw * g_per_lsb[range];
+}
+
+/*! \brief  Converts a raw accelerometer value to milli-g without floating point math
+ *
+ *	One LSB is 1000 / (16384 >> range) milli-g, so the conversion is a multiplication and a shift.
+ *
+ *  \param  raw		value that is used to calculate milli-g
+ *	\param	range	value to specify in what range the raw value was read
+ *
+ *  \return milli-g if the input range is invalid the raw value will be returned
+ */
+int32_t accel_raw_to_mg_mpu6050(int16_t raw, uint8_t range){
+	if(range > MPU6050_ACCEL_SCL_16G) return raw;
+	
+	return ( (int32_t) raw * 1000 ) >> (14 - range);
+}
+
+/*! \brief  Converts a raw gyroscope value to milli-degrees per second without floating point math
+ *
+ *	One LSB is 1000 / (131.072 >> range) = (15625 << range) / 2048 milli-degrees per second,
+ *	so the conversion is a multiplication and a shift.
+ *
+ *  \param  raw		value that is used to calculate milli-degrees per second
+ *	\param	range	value to specify in what range the raw value was read
+ *
+ *  \return milli-degrees per second if the input range is invalid the raw value will be returned
+ */
+int32_t gyro_raw_to_mdps_mpu6050(int16_t raw, uint8_t range){
+	if(range > MPU6050_GYRO_SCL_2000) return raw;
+	
+	return ( (int32_t) raw * 15625 ) >> (11 - range);
+}
+
+/*! \brief  Converts a raw temperature value to milli-degrees Celsius without floating point math
+ *
+ *  \param  raw		value that is used to calculate milli-degrees Celsius
+ *
+ *  \return milli-degrees Celsius
+ */
+int32_t temp_raw_to_mdegc_mpu6050(int16_t raw){
+	return ( ( (int32_t) raw * 3012 ) >> 10 ) + 36530;	//!< raw / 340 + 36.53 degrees
+}
+
+/*! \brief  Limits a value to the range of an int16_t
+ *
+ *	\note	This function is for internal use
+ *
+ *  \param  value	value that is limited
+ *
+ *  \return value limited to -32768 up to 32767
+ */
+static int16_t clamp16_mpu6050(int32_t value){
+	if(value > 32767) return 32767;
+	if(value < -32768) return -32768;
+	return (int16_t) value;
+}
+
+/*! \brief  Converts a raw motion frame to milli-g, milli-degrees per second and milli-degrees Celsius
+ *
+ *	The offsets of the selected scale/range are subtracted before the conversion, a saturated sample stays saturated.
+ *
+ *  \param  *dev	pointer to the MPU6050 device that measured the frame
+ *	\param	*raw	pointer to the raw motion frame
+ *	\param	*data	pointer to store the converted values
+ */
+void motion_to_fixed_mpu6050(mpu6050_dev_t *dev, const mpu6050_motion_t *raw, mpu6050_motion_fixed_t *data){
+	for(uint8_t i = 0; i < 3; i++){
+		data->accel[i] = accel_raw_to_mg_mpu6050(clamp16_mpu6050((int32_t) raw->accel[i] - dev->accel_offset[i][dev->accel_state]), dev->accel_state);
+		data->gyro[i] = gyro_raw_to_mdps_mpu6050(clamp16_mpu6050((int32_t) raw->gyro[i] - dev->gyro_offset[i][dev->gyro_state]), dev->gyro_state);
+	}
+	data->temp = temp_raw_to_mdegc_mpu6050(raw->temp);
+	data->time_us = raw->time_us;
+}
+
+/*! \brief  Get accelerometer, temperature and gyroscope data of all axes in fixed point
+ *
+ *	All values are read in one burst and converted without floating point math.
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	*data	pointer to store milli-g, milli-degrees Celsius and milli-degrees per second
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ */
+uint8_t get_motion_fixed_mpu6050(mpu6050_dev_t *dev, mpu6050_motion_fixed_t *data){
+	uint8_t err;
+	mpu6050_motion_t raw;
+	
+	err = get_motion7_raw_mpu6050(dev, &raw);
+	if(err != 0) return err;
+	
+	motion_to_fixed_mpu6050(dev, &raw, data);
+	
+	return 0;
+}
+
+/*! \brief  Divides and rounds to the nearest integer
+ *
+ *	\note	This function is for internal use
+ *
+ *  \param  num		numerator
+ *	\param	den		denominator, needs to be positive
+ *
+ *  \return num / den rounded to the nearest integer
+ */
+static int16_t round_div_mpu6050(int32_t num, int32_t den){
+	if(num < 0) return (num - den / 2) / den;
+	return (num + den / 2) / den;
+}
+
+/*! \brief  Waits for a new sample of the MPU6050 and reads it
+ *
+ *	\note	This function is for internal use
+ *
+ *	With clock_us of the device struct one sample period is waited, otherwise the DATA_RDY flag is polled.
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	*frame	pointer to store the sample
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2, also 2 if there is no new sample
+ */
+static uint8_t cal_sample_mpu6050(mpu6050_dev_t *dev, mpu6050_motion_t *frame){
+	uint8_t err, ready = 0;
+	uint32_t start, period;
+	
+	if(dev->clock_us != 0){
+		period = get_sample_period_mpu6050(dev);
+		start = dev->clock_us();
+		while(dev->clock_us() - start < period);
+	}
+	else {
+		for(uint16_t i = 0; !ready; i++){
+			if(i == MPU6050_CAL_READY_POLLS) return check_err_mpu6050(DATA_NOT_RECEIVED);	//!< The MPU6050 does not sample
+			
+			err = data_ready_mpu6050(dev, &ready);
+			if(err != 0) return err;
+		}
+	}
+	
+	return get_motion7_raw_mpu6050(dev, frame);
+}
+
+/*! \brief  Get calibration data of all axes and all ranges in one pass
+ *
+ *	Every sample reads all axes in one burst. The samples are only taken in the most sensitive range,
+ *	the offsets of the other ranges are derived from it by dividing by 2, 4 and 8. Sampling stops early
+ *	when the standard error of the mean of every axis is below MPU6050_CAL_TOLERANCE LSB.
+ *	Every sample is a new one, with clock_us of the device struct one sample period is waited between the
+ *	samples, otherwise the DATA_RDY interrupt is enabled during the calibration and its flag is polled.
+ *	The first sample after the range change is not used.
+ *
+ *	\note The MPU6050 needs to lie still with the z-axis pointing up.
+ *	\note Without clock_us the interrupt flags of the MPU6050 are cleared.
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	samples	maximum amount of samples, at least MPU6050_CAL_MIN_SAMPLES are taken
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ */
+uint8_t calibrate_mpu6050(mpu6050_dev_t *dev, uint16_t samples){
+	uint8_t err, restore, accel_scale, gyro_scale, int_enable;
+	int32_t sum[6];
+	int64_t sum_sq[6];
+	int64_t spread, limit;
+	uint16_t n;
+	uint8_t axis;
+	mpu6050_motion_t frame;
+	
+	accel_scale = dev->accel_state;
+	gyro_scale = dev->gyro_state;
+	int_enable = *shadow_mpu6050(dev, MPU_6050_INT_ENABLE);
+	if(samples < MPU6050_CAL_MIN_SAMPLES) samples = MPU6050_CAL_MIN_SAMPLES;
+	
+	err = accel_set_scale_mpu6050(dev, MPU6050_ACCEL_SCL_2G);
+	if(err != 0) return err;
+	err = gyro_set_scale_mpu6050(dev, MPU6050_GYRO_SCL_250);
+	if(err != 0) return err;
+	
+	for(uint8_t i = 0; i < 6; i++){
+		sum[i] = 0;
+		sum_sq[i] = 0;
+	}
+	
+	if(dev->clock_us == 0){
+		err = update_reg_mpu6050(dev, MPU_6050_INT_ENABLE, (1 << DATA_RDY_INT_EN), (1 << DATA_RDY_INT_EN));
+		if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	}
+	
+	err = cal_sample_mpu6050(dev, &frame);	//!< Can be sampled before the range change
+	
+	for(n = 0; err == 0 && n < samples; ){
+		err = cal_sample_mpu6050(dev, &frame);
+		if(err != 0) break;
+		
+		for(uint8_t i = 0; i < 3; i++){
+			sum[i] += frame.accel[i];
+			sum_sq[i] += (int32_t) frame.accel[i] * frame.accel[i];
+			sum[i + 3] += frame.gyro[i];
+			sum_sq[i + 3] += (int32_t) frame.gyro[i] * frame.gyro[i];
+		}
+		n++;
+		
+		if(n < MPU6050_CAL_MIN_SAMPLES || (n % MPU6050_CAL_MIN_SAMPLES) != 0) continue;
+		
+		//  variance / n < tolerance^2  <=>  n * sum_sq - sum^2 < tolerance^2 * n^3
+		limit = (int64_t) MPU6050_CAL_TOLERANCE * MPU6050_CAL_TOLERANCE * n * n * n;
+		for(axis = 0; axis < 6; axis++){
+			spread = n * sum_sq[axis] - (int64_t) sum[axis] * sum[axis];
+			if(spread >= limit) break;
+		}
+		if(axis == 6) break;	//!< All axes converged
+	}
+	
+	if(dev->clock_us == 0){
+		restore = update_reg_mpu6050(dev, MPU_6050_INT_ENABLE, int_enable, (1 << DATA_RDY_INT_EN));
+		if(err == 0) err = check_err_mpu6050(restore);
+	}
+	if(err != 0) return err;
+	
+	sum[2] -= (int32_t) MPU6050_ACCEL_1G_RAW * n;	//!< The z-axis measures gravity
+	dev->cal_temp = frame.temp;
+	
+	for(uint8_t r = 0; r < 4; r++){
+		for(uint8_t i = 0; i < 3; i++){
+			dev->accel_offset[i][r] = round_div_mpu6050(sum[i], (int32_t) n << r);
+			dev->gyro_offset[i][r] = round_div_mpu6050(sum[i + 3], (int32_t) n << r);
+		}
+	}
+	
+	err = accel_set_scale_mpu6050(dev, accel_scale);
+	if(err != 0) return err;
+	err = gyro_set_scale_mpu6050(dev, gyro_scale);
+	if(err != 0) return err;
+	
+	return 0;
+}
+
+/*! \brief  Writes a 16 bit value little endian
+ *
+ *	\note	This function is for internal use
+ */
+static uint8_t *put16_mpu6050(uint8_t *buff, uint16_t value){
+	buff[0] = value & 0xFF;
+	buff[1] = value >> 8;
+	return buff + 2;
+}
+
+/*! \brief  Reads a 16 bit little endian value
+ *
+ *	\note	This function is for internal use
+ */
+static uint16_t get16_mpu6050(const uint8_t *buff){
+	return ( (uint16_t) buff[1] << 8 ) | buff[0];
+}
+
+/*! \brief  Stores the calibration of the MPU6050 in a record of MPU6050_CALIB_BYTES bytes
+ *
+ *	Layout (little endian): magic (2), version (1), address (1), raw temperature (2), hw_valid (1), reserved (1),
+ *	accelerometer offsets x, y, z for range 0-3 (24), gyroscope offsets x, y, z for range 0-3 (24),
+ *	accelerometer offset registers x, y, z (6), gyroscope offset registers x, y, z (6), CRC-16 (2).
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	*buff	pointer to store the record
+ */
+void calib_serialize_mpu6050(mpu6050_dev_t *dev, uint8_t *buff){
+	uint8_t *pos = buff;
+	
+	pos = put16_mpu6050(pos, MPU6050_CALIB_MAGIC);
+	*pos++ = MPU6050_CALIB_VERSION;
+	*pos++ = dev->addr;
+	pos = put16_mpu6050(pos, dev->cal_temp);
+	*pos++ = dev->hw_valid;
+	*pos++ = 0;
+	
+	for(uint8_t i = 0; i < 3; i++){
+		for(uint8_t r = 0; r < 4; r++){
+			pos = put16_mpu6050(pos, dev->accel_offset[i][r]);
+		}
+	}
+	for(uint8_t i = 0; i < 3; i++){
+		for(uint8_t r = 0; r < 4; r++){
+			pos = put16_mpu6050(pos, dev->gyro_offset[i][r]);
+		}
+	}
+	for(uint8_t i = 0; i < 3; i++) pos = put16_mpu6050(pos, dev->hw_accel[i]);
+	for(uint8_t i = 0; i < 3; i++) pos = put16_mpu6050(pos, dev->hw_gyro[i]);
+	
+	put16_mpu6050(pos, crc16_mpu6050(buff, MPU6050_CALIB_BYTES - 2));
+}
+
+/*! \brief  Loads the calibration of the MPU6050 from a record made by calib_serialize_mpu6050
+ *
+ *	The device struct is only changed if the record is valid.
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	*buff	pointer to the record
+ *
+ *  \return 0 if succeeded, MPU6050_CALIB_INVALID if the record is damaged, of another version or of another address
+ */
+uint8_t calib_deserialize_mpu6050(mpu6050_dev_t *dev, const uint8_t *buff){
+	const uint8_t *pos = buff + 8;
+	
+	if(get16_mpu6050(buff) != MPU6050_CALIB_MAGIC) return MPU6050_CALIB_INVALID;
+	if(buff[2] != MPU6050_CALIB_VERSION) return MPU6050_CALIB_INVALID;
+	if(buff[3] != dev->addr) return MPU6050_CALIB_INVALID;
+	if(get16_mpu6050(buff + MPU6050_CALIB_BYTES - 2) != crc16_mpu6050(buff, MPU6050_CALIB_BYTES - 2)) return MPU6050_CALIB_INVALID;
+	
+	dev->cal_temp = get16_mpu6050(buff + 4);
+	dev->hw_valid = buff[6];
+	
+	for(uint8_t i = 0; i < 3; i++){
+		for(uint8_t r = 0; r < 4; r++, pos += 2){
+			dev->accel_offset[i][r] = get16_mpu6050(pos);
+		}
+	}
+	for(uint8_t i = 0; i < 3; i++){
+		for(uint8_t r = 0; r < 4; r++, pos += 2){
+			dev->gyro_offset[i][r] = get16_mpu6050(pos);
+		}
+	}
+	for(uint8_t i = 0; i < 3; i++, pos += 2) dev->hw_accel[i] = get16_mpu6050(pos);
+	for(uint8_t i = 0; i < 3; i++, pos += 2) dev->hw_gyro[i] = get16_mpu6050(pos);
+	
+	return 0;
+}
+
+/*! \brief  Saves the calibration of the MPU6050 with the storage backend of the device struct
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *
+ *  \return 0 if succeeded, MPU6050_CALIB_INVALID if there is no backend or the backend failed
+ */
+uint8_t calib_save_mpu6050(mpu6050_dev_t *dev){
+	uint8_t buff[MPU6050_CALIB_BYTES];
+	
+	if(dev->store == 0) return MPU6050_CALIB_INVALID;
+	
+	calib_serialize_mpu6050(dev, buff);
+	
+	if(dev->store->write(dev->store->ctx, 0, buff, MPU6050_CALIB_BYTES) != 0) return MPU6050_CALIB_INVALID;
+	
+	return 0;
+}
+
+/*! \brief  Loads the calibration of the MPU6050 with the storage backend of the device struct
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *
+ *  \return 0 if succeeded, MPU6050_CALIB_INVALID if there is no backend, the backend failed or
+ *			there is no valid record of this MPU6050
+ */
+uint8_t calib_load_mpu6050(mpu6050_dev_t *dev){
+	uint8_t buff[MPU6050_CALIB_BYTES];
+	
+	if(dev->store == 0) return MPU6050_CALIB_INVALID;
+	
+	if(dev->store->read(dev->store->ctx, 0, buff, MPU6050_CALIB_BYTES) != 0) return MPU6050_CALIB_INVALID;
+	
+	return calib_deserialize_mpu6050(dev, buff);
+}
+
+/*! \brief  Moves the offsets of the device struct into the offset registers of the MPU6050
+ *
+ *	The MPU6050 subtracts the offsets itself, so raw burst and FIFO data are already corrected.
+ *	The offset registers are adjusted by the measured offsets and the offsets in the device struct are set to 0.
+ *	The new register values are kept in hw_accel and hw_gyro of the device struct, so they are part of the calibration record.
+ *	The accelerometer offset registers use the +-16G range and the gyroscope offset registers the +-1000 degrees 
+ *	per second range. Bit 0 of the accelerometer offset registers is reserved and is not changed.
+ *
+ *	\note The offsets in the device struct need to be measured with the current content of the offset registers,
+ *		  after a power cycle these are the factory values.
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ */
+uint8_t hw_offsets_program_mpu6050(mpu6050_dev_t *dev){
+	uint8_t err;
+	int16_t accel[3], gyro[3];
+	
+	err = hw_offsets_read_mpu6050(dev, accel, gyro);
+	if(err != 0) return err;
+	
+	for(uint8_t i = 0; i < 3; i++){
+		dev->hw_accel[i] = accel[i] - (round_div_mpu6050(dev->accel_offset[i][MPU6050_ACCEL_SCL_2G], 8) & ~1);	//!< 8 LSB at +-2G is 1 LSB at +-16G
+		dev->hw_gyro[i] = gyro[i] - round_div_mpu6050(dev->gyro_offset[i][MPU6050_GYRO_SCL_250], 4);	//!< 4 LSB at +-250 is 1 LSB at +-1000
+	}
+	
+	err = hw_offsets_write_mpu6050(dev);
+	if(err != 0) return err;
+	
+	for(uint8_t i = 0; i < 3; i++){
+		for(uint8_t r = 0; r < 4; r++){
+			dev->accel_offset[i][r] = 0;
+			dev->gyro_offset[i][r] = 0;
+		}
+	}
+	
+	return 0;
+}
+
+/*! \brief  Writes hw_accel and hw_gyro of the device struct into the offset registers of the MPU6050
+ *
+ *	The values are written as they are, enable_mpu6050 uses this for a calibration record with programmed offset registers.
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ */
+uint8_t hw_offsets_write_mpu6050(mpu6050_dev_t *dev){
+	uint8_t err, buff[6];
+	
+	for(uint8_t i = 0; i < 3; i++){
+		buff[2 * i] = (uint16_t) dev->hw_accel[i] >> 8;
+		buff[2 * i + 1] = dev->hw_accel[i] & 0xFF;
+	}
+	
+	err = write_burst_mpu6050(dev, MPU_6050_XA_OFFS_H, buff, 6);
+	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	
+	for(uint8_t i = 0; i < 3; i++){
+		buff[2 * i] = (uint16_t) dev->hw_gyro[i] >> 8;
+		buff[2 * i + 1] = dev->hw_gyro[i] & 0xFF;
+	}
+	
+	err = write_burst_mpu6050(dev, MPU_6050_XG_OFFS_USRH, buff, 6);
+	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	
+	dev->hw_valid = 1;
+	
+	return 0;
+}
+
+/*! \brief  Reads the offset registers of the MPU6050
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	*accel	pointer to store the x, y and z accelerometer offset registers (+-16G range, bit 0 reserved)
+ *	\param	*gyro	pointer to store the x, y and z gyroscope offset registers (+-1000 degrees per second range)
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ */
+uint8_t hw_offsets_read_mpu6050(mpu6050_dev_t *dev, int16_t *accel, int16_t *gyro){
+	uint8_t err, buff[6];
+	
+	err = read_burst_mpu6050(dev, MPU_6050_XA_OFFS_H, buff, 6);
+	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	
+	for(uint8_t i = 0; i < 3; i++){
+		accel[i] = (int16_t) ( (buff[2 * i] << 8) | buff[2 * i + 1] );
+	}
+	
+	err = read_burst_mpu6050(dev, MPU_6050_XG_OFFS_USRH, buff, 6);
+	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	
+	for(uint8_t i = 0; i < 3; i++){
+		gyro[i] = (int16_t) ( (buff[2 * i] << 8) | buff[2 * i + 1] );
+	}
+	
+	return 0;
+}
+
+/*! \brief  Get calibration data Gyro x axis
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *
+ *  \return 0 if successful otherwise the error code of the failed transaction, see check_err_mpu6050
+ */
+uint8_t calibrate_gyro_x_mpu6050(mpu6050_dev_t *dev){
+	uint8_t range[] = { MPU6050_GYRO_SCL_250, MPU6050_GYRO_SCL_500, MPU6050_GYRO_SCL_1000, MPU6050_GYRO_SCL_2000};
+	uint8_t err;
+	int32_t sum;
+	int16_t value = 0;
+	
+	for(uint8_t i = 0; i < 4; i++){
+		sum = 0;	
+		err = gyro_set_scale_mpu6050(dev, range[i]); //  Selecting the range
+		if(err != 0) return err;
+		
+		for(uint16_t j = 0; j < 700; j++){	//  Loop to get average offset
+			
+			err = get_gyro_x_raw_mpu6050(dev, &value);
+			if(err != 0) return err;
+			
+			sum += value;
+		}
+		
+		dev->gyro_offset[0][i] = sum / 700;
+	}
+	
+	err = gyro_set_scale_mpu6050(dev, MPU6050_GYRO_SCL_250);
+	if(err != 0) return err;
+	
+	return 0;
+}
+
+/*! \brief  Get calibration data Gyro y axis
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *
+ *  \return 0 if successful otherwise the error code of the failed transaction, see check_err_mpu6050
+ */
+uint8_t calibrate_gyro_y_mpu6050(mpu6050_dev_t *dev){
+	uint8_t range[] = { MPU6050_GYRO_SCL_250, MPU6050_GYRO_SCL_500, MPU6050_GYRO_SCL_1000, MPU6050_GYRO_SCL_2000};
+	uint8_t err;
+	int32_t sum;
+	int16_t value = 0;
+	
+	for(uint8_t i = 0; i < 4; i++){
+		sum = 0;
+		err = gyro_set_scale_mpu6050(dev, range[i]); //!<  Selecting the range
+		if(err != 0) return err;
+		
+		for(uint16_t j = 0; j < 700; j++){	//!<  Loop to get average offset
+			
+			err = get_gyro_y_raw_mpu6050(dev, &value);
+			if(err != 0) return err;
+			
+			sum += value;
+		}
+		
+		dev->gyro_offset[1][i] = sum / 700;
+	}
+	
+	err = gyro_set_scale_mpu6050(dev, MPU6050_GYRO_SCL_250);
+	if(err != 0) return err;
+	
+	return 0;	
+}
+
+/*! \brief  Get calibration data Gyro z axis
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *
+ *  \return 0 if successful otherwise the error code of the failed transaction, see check_err_mpu6050
+ */
+uint8_t calibrate_gyro_z_mpu6050(mpu6050_dev_t *dev){
+	uint8_t range[] = { MPU6050_GYRO_SCL_250, MPU6050_GYRO_SCL_500, MPU6050_GYRO_SCL_1000, MPU6050_GYRO_SCL_2000};
+	uint8_t err;
+	int32_t sum;
+	int16_t value = 0;
+	
+	for(uint8_t i = 0; i < 4; i++){
+		sum = 0;
+		err = gyro_set_scale_mpu6050(dev, range[i]); //!<  Selecting the range
+		if(err != 0) return err;
+		
+		for(uint16_t j = 0; j < 700; j++){	//!<  Loop to get average offset
+			
+			err = get_gyro_z_raw_mpu6050(dev, &value);
+			if(err != 0) return err;
+			
+			sum += value;
+		}
+		
+		dev->gyro_offset[2][i] = sum / 700;
+	}
+	
+	err = gyro_set_scale_mpu6050(dev, MPU6050_GYRO_SCL_250);
+	if(err != 0) return err;
+	
+	return 0;	
+}
+
+/*! \brief  Get calibration data accelerometer x axis
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *
+ *  \return 0 if successful otherwise the error code of the failed transaction, see check_err_mpu6050
+ */
+uint8_t calibrate_accel_x_mpu6050(mpu6050_dev_t *dev){
+	uint8_t range[] = { MPU6050_ACCEL_SCL_2G, MPU6050_ACCEL_SCL_4G, MPU6050_ACCEL_SCL_8G, MPU6050_ACCEL_SCL_16G};
+	uint8_t err;
+	int32_t sum;
+	int16_t value = 0;
+	
+	for(uint8_t i = 0; i < 4; i++){
+		sum = 0;
+		err = accel_set_scale_mpu6050(dev, range[i]); //!<  Selecting the range
+		if(err != 0) return err;
+		
+		for(uint16_t j = 0; j < 700; j++){	//!<  Loop to get average offset
+			
+			err = get_accel_x_raw_mpu6050(dev, &value);
+			if(err != 0) return err;
+			
+			sum += value;
+		}
+		
+		dev->accel_offset[0][i] = sum / 700;
+	}
+	
+	err = accel_set_scale_mpu6050(dev, MPU6050_ACCEL_SCL_2G);
+	if(err != 0) return err;
+	
+	return 0;	
+}
+
+/*! \brief  Get calibration data accelerometer y axis
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *
+ *  \return 0 if successful otherwise the error code of the failed transaction, see check_err_mpu6050
+ */
+uint8_t calibrate_accel_y_mpu6050(mpu6050_dev_t *dev){
+	uint8_t range[] = { MPU6050_ACCEL_SCL_2G, MPU6050_ACCEL_SCL_4G, MPU6050_ACCEL_SCL_8G, MPU6050_ACCEL_SCL_16G};
+	uint8_t err;
+	int32_t sum;
+	int16_t value = 0;
+	
+	for(uint8_t i = 0; i < 4; i++){
+		sum = 0;
+		err = accel_set_scale_mpu6050(dev, range[i]); //!<  Selecting the range
+		if(err != 0) return err;
+		
+		for(uint16_t j = 0; j < 700; j++){	//!<  Loop to get average offset
+			
+			err = get_accel_y_raw_mpu6050(dev, &value);
+			if(err != 0) return err;
+			
+			sum += value;
+		}
+		
+		dev->accel_offset[1][i] = sum / 700;
+	}
+	
+	err = accel_set_scale_mpu6050(dev, MPU6050_ACCEL_SCL_2G);
+	if(err != 0) return err;
+	
+	return 0;	
+}
+
+/*! \brief  Get calibration data accelerometer z axis
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *
+ *  \return 0 if successful otherwise the error code of the failed transaction, see check_err_mpu6050
+ */
+uint8_t calibrate_accel_z_mpu6050(mpu6050_dev_t *dev){
+	uint8_t range[] = { MPU6050_ACCEL_SCL_2G, MPU6050_ACCEL_SCL_4G, MPU6050_ACCEL_SCL_8G, MPU6050_ACCEL_SCL_16G};
+	uint8_t err;
+	int32_t sum;
+	int16_t value = 0;
+	
+	for(uint8_t i = 0; i < 4; i++){
+		sum = 0;
+		err = accel_set_scale_mpu6050(dev, range[i]); //!<  Selecting the range
+		if(err != 0) return err;
+		
+		for(uint16_t j = 0; j < 700; j++){	//!<  Loop to get average offset
+			
+			err = get_accel_z_raw_mpu6050(dev, &value);
+			if(err != 0) return err;
+			
+			sum += value;
+		}
+		
+		dev->accel_offset[2][i] = ( sum / 700 ) - (MPU6050_ACCEL_1G_RAW >> i);	//!< The z-axis measures gravity
+	}
+	
+	err = accel_set_scale_mpu6050(dev, MPU6050_ACCEL_SCL_2G);
+	if(err != 0) return err;
+	
+	return 0;	
+}
+
+/*! \brief  Get temperature
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	data	pointer to store temperature data
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ */
+uint8_t get_temp_mpu6050(mpu6050_dev_t *dev, float *data){
+	uint8_t err;
+	TEMP16_t temp;
+	float ret;
+	
+	err = read_16bit_mpu6050(dev, MPU_6050_TEMP_OUT_H, &temp.TEMP);
+	if(err != 0) return err;
+	
+	ret = temp.TEMP;
+	
+	ret = (ret  / 340) + 36.53;
+	
+	(*data) = ret;
+	
+	return 0;	
+}
+
+/*! \brief  Enables interrupts from the MPU6050
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	interupt	byte to select what interrupt will be enabled
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ */
+uint8_t int_enable_mpu6050(mpu6050_dev_t *dev, uint8_t interupt){
+	uint8_t err;
+	
+	err = update_reg_mpu6050(dev, MPU_6050_INT_ENABLE, (1 << interupt), (1 << interupt));
+	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	
+	return 0;
+}
+
+/*! \brief  Disables interrupts from the MPU6050
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	interupt	byte to select what interrupt will be disabled
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ */
+uint8_t int_disable_mpu6050(mpu6050_dev_t *dev, uint8_t interupt){
+	uint8_t err;
+	
+	err = update_reg_mpu6050(dev, MPU_6050_INT_ENABLE, (0 << interupt), (1 << interupt));
+	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	
+	return 0;	
+}
+
+/*! \brief  checks what caused the interrupt from the MPU6050
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *
+ *  \return returns 1 if TWI/I2C bus is in use returns 2 if something went wrong. 
+ *			returns 3 if FIFO_OVF_INT is 1
+ *			returns 4 if I2C_MST_INT is 1
+ *			returns 5 if DATA_RDY_INT is 1
+ *			returns 7 if FIFO_OVF_INT is 1 and I2C_MST_INT is 1
+ *			returns 8 if FIFO_OVF_INT is 1 and DATA_RDY_INT is 1
+ *			returns 9 if I2C_MST_INT is 1 and DATA_RDY_INT is 1
+ *			returns 12 if FIFO_OVF_INT is 1 and I2C_MST_INT is 1 and DATA_RDY_INT is 1
+ *
+ *	\note The motion interrupt is not decoded, use int_status_mpu6050 for it.
+ */
+uint8_t what_happend_mpu6050(mpu6050_dev_t *dev){
+	uint8_t err, ret = 0;
+	MPU6050_INT_STATUS_TYPE int_status;
+	
+	err = read_reg_mpu6050(dev, MPU_6050_INT_STATUS, &int_status.int_reg);
+	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	
+	if(int_status.FIFO_OFLOW == 1) ret += 3;
+	if(int_status.I2C_MST == 1) ret += 4;
+	if(int_status.DATA_RDY == 1) ret += 5;
+	
+	return ret;
+}
+
+/*! \brief  Reads the interrupt status of the MPU6050
+ *
+ *	\note Reading the interrupt status clears all interrupt flags of the MPU6050.
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	*status	pointer to store the MPU6050_INT_xxx_bm bits of the interrupts that happened
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ */
+uint8_t int_status_mpu6050(mpu6050_dev_t *dev, uint8_t *status){
+	uint8_t err;
+	
+	err = read_reg_mpu6050(dev, MPU_6050_INT_STATUS, status);
+	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	
+	return 0;
+}
+
+/*! \brief  Configures the motion detection
+ *
+ *	Motion is detected when the high pass filtered acceleration of one of the axes is above the threshold
+ *	for the duration. The high pass filter of the accelerometer is set to 5Hz, so gravity is not seen as motion.
+ *	Enable the interrupt with int_enable_mpu6050(dev, MPU_6050_MOT_INT_EN).
+ *
+ *  \param  *dev			pointer to the MPU6050 device
+ *	\param	threshold_mg	threshold in mg, rounded down to a multiple of 2mg, at most 510mg
+ *	\param	duration_ms		amount of samples above the threshold in ms
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ */
+uint8_t motion_set_mpu6050(mpu6050_dev_t *dev, uint16_t threshold_mg, uint8_t duration_ms){
+	uint8_t err, buff[2];
+	
+	if(threshold_mg > 510) threshold_mg = 510;
+	
+	buff[0] = threshold_mg / 2;	//!< MPU_6050_MOT_THR
+	buff[1] = duration_ms;		//!< MPU_6050_MOT_DUR
+	
+	err = write_burst_mpu6050(dev, MPU_6050_MOT_THR, buff, 2);
+	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	
+	err = update_reg_mpu6050(dev, MPU_6050_ACCEL_CONFIG, MPU6050_HPF_5HZ, 0x07);
+	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	
+	return 0;
+}
+
+/*! \brief  Lets the MPU6050 wait for motion in the low power accelerometer mode
+ *
+ *	The motion detection is configured, the data ready interrupt is disabled and the motion interrupt
+ *	enabled, so the INT pin only changes when motion is detected. While the MPU6050 is still there is 
+ *	no I2C communication. Call motion_event_mpu6050 when the INT pin changes.
+ *
+ *  \param  *dev			pointer to the MPU6050 device
+ *	\param	threshold_mg	threshold in mg, rounded down to a multiple of 2mg, at most 510mg
+ *	\param	duration_ms		amount of samples above the threshold in ms
+ *	\param	rate			wake up rate, one of MPU6050_LP_WAKE_x
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ */
+uint8_t motion_idle_mpu6050(mpu6050_dev_t *dev, uint16_t threshold_mg, uint8_t duration_ms, uint8_t rate){
+	uint8_t err;
+	
+	err = motion_set_mpu6050(dev, threshold_mg, duration_ms);
+	if(err != 0) return err;
+	
+	err = update_reg_mpu6050(dev, MPU_6050_INT_ENABLE, (1 << MPU_6050_MOT_INT_EN), (1 << MPU_6050_MOT_INT_EN) | (1 << DATA_RDY_INT_EN));
+	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	
+	return lp_accel_mode_mpu6050(dev, rate);
+}
+
+/*! \brief  Handles the INT pin while the MPU6050 waits for motion
+ *
+ *	When motion is detected the low power accelerometer mode is ended, the motion interrupt is 
+ *	disabled and the data ready interrupt is enabled, so the MPU6050 samples at the full sample rate
+ *	and polling or the interrupt driven acquisition can start. Call motion_idle_mpu6050 to wait again.
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	*status	pointer to store the MPU6050_INT_xxx_bm bits of the interrupts that happened
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ */
+uint8_t motion_event_mpu6050(mpu6050_dev_t *dev, uint8_t *status){
+	uint8_t err;
+	
+	err = int_status_mpu6050(dev, status);
+	if(err != 0) return err;
+	
+	if(!((*status) & MPU6050_INT_MOT_bm)) return 0;
+	
+	err = lp_accel_exit_mpu6050(dev);
+	if(err != 0) return err;
+	
+	err = update_reg_mpu6050(dev, MPU_6050_INT_ENABLE, (1 << DATA_RDY_INT_EN), (1 << MPU_6050_MOT_INT_EN) | (1 << DATA_RDY_INT_EN));
+	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	
+	return 0;
+}
+
+/*! \brief  Enables the auxiliary I2C master of the MPU6050
+ *
+ *	The MPU6050 reads the configured slaves after every sample into MPU_6050_EXT_SENS_DATA_00 to 
+ *	MPU_6050_EXT_SENS_DATA_23, so the host gets the data of an external sensor from the MPU6050 and does not
+ *	need to use its own bus for it. The data ready interrupt waits until the external sensor data is loaded.
+ *	The slaves need to be connected to the XDA and XCL pins of the MPU6050.
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	clock	clock of the auxiliary I2C bus, one of MPU6050_AUX_CLK_x
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ */
+uint8_t aux_master_enable_mpu6050(mpu6050_dev_t *dev, uint8_t clock){
+	uint8_t err;
+	
+	err = update_reg_mpu6050(dev, MPU_6050_I2C_MST_CTRL, MPU6050_MST_WAIT_FOR_ES_bm | clock, MPU6050_MST_WAIT_FOR_ES_bm | MPU6050_MST_CLK_gm);
+	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	
+	err = update_reg_mpu6050(dev, MPU_6050_USER_CTRL, MPU6050_USER_I2C_MST_EN_bm, MPU6050_USER_I2C_MST_EN_bm);
+	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	
+	return 0;
+}
+
+/*! \brief  Disables the auxiliary I2C master of the MPU6050
+ *
+ *	The configuration of the slaves is kept.
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ */
+uint8_t aux_master_disable_mpu6050(mpu6050_dev_t *dev){
+	uint8_t err;
+	
+	err = update_reg_mpu6050(dev, MPU_6050_USER_CTRL, 0, MPU6050_USER_I2C_MST_EN_bm);
+	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	
+	return 0;
+}
+
+/*! \brief  Configures a slave of the auxiliary I2C master
+ *
+ *	\note	This function is for internal use
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	slave	slave 0 to 3
+ *	\param	addr	value of MPU_6050_I2C_SLVx_ADDR
+ *	\param	reg		value of MPU_6050_I2C_SLVx_REG
+ *	\param	ctrl	value of MPU_6050_I2C_SLVx_CTRL
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ */
+static uint8_t aux_slave_set_mpu6050(mpu6050_dev_t *dev, uint8_t slave, uint8_t addr, uint8_t reg, uint8_t ctrl){
+	uint8_t err, buff[3];
+	
+	buff[0] = addr;	//!< MPU_6050_I2C_SLVx_ADDR
+	buff[1] = reg;	//!< MPU_6050_I2C_SLVx_REG
+	buff[2] = ctrl;	//!< MPU_6050_I2C_SLVx_CTRL
+	
+	err = write_burst_mpu6050(dev, MPU_6050_I2C_SLV0_ADDR + 3 * (slave & 0x03), buff, 3);
+	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	
+	return 0;
+}
+
+/*! \brief  Lets the auxiliary I2C master read registers of a slave after every sample
+ *
+ *	The data of the enabled slaves is stored in the order of the slave numbers from MPU_6050_EXT_SENS_DATA_00,
+ *	so the data of a slave starts after the bytes of the enabled slaves with a lower number.
+ *	Together the slaves can read at most MPU6050_EXT_SENS_BYTES bytes.
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	slave	slave 0 to 3
+ *	\param	addr	7 bit I2C address of the external sensor
+ *	\param	reg		first register of the external sensor that needs to be read
+ *	\param	len		amount of registers that need to be read, 1 to 15
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ */
+uint8_t aux_slave_read_mpu6050(mpu6050_dev_t *dev, uint8_t slave, uint8_t addr, uint8_t reg, uint8_t len){
+	return aux_slave_set_mpu6050(dev, slave, MPU6050_SLV_READ_bm | addr, reg, MPU6050_SLV_EN_bm | (len & MPU6050_SLV_LEN_gm));
+}
+
+/*! \brief  Lets the auxiliary I2C master write a register of a slave after every sample
+ *
+ *	Used to start a measurement of an external sensor that does not measure continuously, for example
+ *	the single measurement mode of a magnetometer. The write is done before the reads of the slaves with a higher number.
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	slave	slave 0 to 3
+ *	\param	addr	7 bit I2C address of the external sensor
+ *	\param	reg		register of the external sensor that needs to be written
+ *	\param	data	value that is written
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ */
+uint8_t aux_slave_write_mpu6050(mpu6050_dev_t *dev, uint8_t slave, uint8_t addr, uint8_t reg, uint8_t data){
+	uint8_t err;
+	
+	err = write_reg_mpu6050(dev, MPU_6050_I2C_SLV0_DO + (slave & 0x03), data);
+	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	
+	return aux_slave_set_mpu6050(dev, slave, addr & ~MPU6050_SLV_READ_bm, reg, MPU6050_SLV_EN_bm | 1);
+}
+
+/*! \brief  Stops the auxiliary I2C master from accessing a slave
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	slave	slave 0 to 3
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ */
+uint8_t aux_slave_disable_mpu6050(mpu6050_dev_t *dev, uint8_t slave){
+	uint8_t err;
+	
+	err = write_reg_mpu6050(dev, MPU_6050_I2C_SLV0_CTRL + 3 * (slave & 0x03), 0);
+	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	
+	return 0;
+}
+
+/*! \brief  Sets the rate at which slaves are accessed
+ *
+ *	A magnetometer or barometer is often slower than the sample rate of the MPU6050. The selected slaves are only
+ *	accessed every divider samples, the other slaves every sample. The external sensor data is only
+ *	updated when all slaves are read, so the data of the slaves belongs together.
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	slaves	bit n selects slave n, 0 accesses all slaves every sample
+ *	\param	divider	the selected slaves are accessed every divider samples, 1 to 32
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ */
+uint8_t aux_set_rate_mpu6050(mpu6050_dev_t *dev, uint8_t slaves, uint8_t divider){
+	uint8_t err;
+	
+	if(divider < 1) divider = 1;
+	if(divider > 32) divider = 32;
+	
+	err = update_reg_mpu6050(dev, MPU_6050_I2C_SLV4_CTRL, divider - 1, MPU6050_MST_DLY_gm);
+	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	
+	err = update_reg_mpu6050(dev, MPU_6050_I2C_MST_DELAY_CTRL, MPU6050_MST_DELAY_ES_SHADOW_bm | (slaves & 0x0F), MPU6050_MST_DELAY_ES_SHADOW_bm | 0x0F);
+	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	
+	return 0;
+}
+
+/*! \brief  Read external sensor value from the MPU6050
+ *
+ *	Use ext_sens_read_mpu6050 to read more than one byte, it reads them in one burst.
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	reg		external sensor register that needs to be read, MPU_6050_EXT_SENS_DATA_00 to MPU_6050_EXT_SENS_DATA_23
+ *	\param	*data	pointer to store the external sensor value
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ */
+uint8_t ext_sens_value_mpu6050(mpu6050_dev_t *dev, uint8_t reg, uint8_t *data){
+		uint8_t err;
+		
+		err = read_reg_mpu6050(dev, reg, data);
+		if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+				
 		return 0;
 }
 
-/*! \brief  Disables temperature measurement
+/*! \brief  Reads external sensor data registers in one burst
+ *
+ *	The range is limited to the MPU6050_EXT_SENS_BYTES external sensor data registers.
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	offset	first register, 0 is MPU_6050_EXT_SENS_DATA_00
+ *	\param	*buff	pointer to store len bytes
+ *	\param	len		amount of registers that need to be read
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ */
+uint8_t ext_sens_read_mpu6050(mpu6050_dev_t *dev, uint8_t offset, uint8_t *buff, uint8_t len){
+	uint8_t err;
+	
+	if(offset >= MPU6050_EXT_SENS_BYTES) return 0;
+	if(len > MPU6050_EXT_SENS_BYTES - offset) len = MPU6050_EXT_SENS_BYTES - offset;
+	if(len == 0) return 0;
+	
+	err = read_burst_mpu6050(dev, MPU_6050_EXT_SENS_DATA_00 + offset, buff, len);
+	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	
+	return 0;
+}
+
+/*! \brief  Disables temperature measurement
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ */
+uint8_t disable_temp_mpu6050(mpu6050_dev_t *dev){
+	uint8_t err;
+	
+	err = update_reg_mpu6050(dev, MPU_6050_PWR_MGMT_1, (1 << 3), (1 << 3)); //!< Disables Temperature measurements
+	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	
+	return 0;
+}
+
+/*! \brief  Enables temperature measurement
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ */
+uint8_t enable_temp_mpu6050(mpu6050_dev_t *dev){
+	uint8_t err;
+	
+	err = update_reg_mpu6050(dev, MPU_6050_PWR_MGMT_1, (0 << 3), (1 << 3)); //!< Enables Temperature measurements
+	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	
+	return 0;
+}
+
+/*! \brief  Resets the MPU6050
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ *
+ *	When set to 1, this bit resets all internal registers to their default values.
+ *	The bit automatically clears to 0 once the reset is done.
+ *	The copies of the configuration registers are set to the default values as well, 
+ *	call resync_mpu6050 after the reset is done to make sure they match the MPU6050.
+ *	The FIFO and the Digital Motion Processor are disabled by the reset, the device struct forgets their settings.
+ *	The reset restores the factory values of the offset registers, so the calibration of the device struct is cleared.
+ *	Call enable_mpu6050 or calibrate_mpu6050 again.
+ */
+uint8_t reset_mpu6050(mpu6050_dev_t *dev){
+	uint8_t err;
+	uint8_t reset = 0;
+	
+	reset = (1 << 7);
+	
+	err = write_reg_mpu6050(dev, MPU_6050_PWR_MGMT_1, reset);
+	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	
+	shadow_defaults_mpu6050(dev);
+	dev->accel_state = MPU6050_ACCEL_SCL_2G;
+	dev->gyro_state = MPU6050_GYRO_SCL_250;
+	dev->fifo_sensors = 0;		//!< FIFO_EN and USER_CTRL are 0 after the reset
+	dev->dmp_features = 0;
+	dev->fifo_time_valid = 0;
+	
+	for(uint8_t i = 0; i < 3; i++){
+		for(uint8_t r = 0; r < 4; r++){
+			dev->accel_offset[i][r] = 0;
+			dev->gyro_offset[i][r] = 0;
+		}
+	}
+	dev->hw_valid = 0;
+	
+	return 0;	
+}
+
+/*! \brief  Resets the accelerometer of the MPU6050
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ *
+ *	This register is used to reset the analog and digital signal paths of the accelerometer.
+ *	The reset will revert the signal path analog to digital converters and filters to their power up
+ *	configurations
+ *
+ *	\note This function does not clear the sensor register
+ */
+uint8_t reset_accel_mpu6050(mpu6050_dev_t *dev){
+	uint8_t err;
+	uint8_t reset = 0;
+	
+	reset = (1 << 1);
+	
+	err = write_reg_mpu6050(dev, MPU_6050_SIGNAL_PATH_RESET, reset);
+	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	
+	return 0;
+}
+
+/*! \brief  Resets the gyroscope of the MPU6050
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ *
+ *	This register is used to reset the analog and digital signal paths of the gyroscope.
+ *	The reset will revert the signal path analog to digital converters and filters to their power up
+ *	configurations
+ *
+ *	\note This function does not clear the sensor register
+ */
+uint8_t reset_gyro_mpu6050(mpu6050_dev_t *dev){
+	uint8_t err;
+	uint8_t reset = 0;
+	
+	reset = (1 << 2);
+	
+	err = write_reg_mpu6050(dev, MPU_6050_SIGNAL_PATH_RESET, reset);
+	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	
+	return 0;	
+}
+
+/*! \brief  Resets the temperature sensor of the MPU6050
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ *
+ *	This register is used to reset the analog and digital signal paths of the temperature sensors.
+ *	The reset will revert the signal path analog to digital converters and filters to their power up
+ *	configurations
+ *
+ *	\note This function does not clear the sensor register
+ */
+uint8_t reset_temp_mpu6050(mpu6050_dev_t *dev){
+	uint8_t err;
+	uint8_t reset = 0;
+	
+	reset = (1 << 0);
+	
+	err = write_reg_mpu6050(dev, MPU_6050_SIGNAL_PATH_RESET, reset);
+	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	
+	return 0;	
+}
+
+/*! \brief  Select the clock source of the MPU6050
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	clk_sel	used to select what clk source the MPU6050 uses.
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ */
+uint8_t clk_sel_mpu6050(mpu6050_dev_t *dev, uint8_t clk_sel){
+	uint8_t err;
+	MPU6050_PWR_MGMT_1_TYPE reg;
+	
+	reg.PWR_MGMT_1 = 0;
+	reg.CLKSEL = clk_sel;
+	
+	err = update_reg_mpu6050(dev, MPU_6050_PWR_MGMT_1, reg.PWR_MGMT_1, 0x07);
+	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	
+	return 0;		
+}
+
+
+/*! \brief  Set the bandwidth of the digital low pass filter
+ *
+ *	The gyroscope output rate is 8kHz with MPU6050_DLPF_260 and 1kHz otherwise, 
+ *	call set_sample_rate_mpu6050 after this function to keep the same sample rate.
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	bw		bandwidth of the filter, one of MPU6050_DLPF_x
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ */
+uint8_t set_dlpf_mpu6050(mpu6050_dev_t *dev, uint8_t bw){
+	uint8_t err;
+	MPU6050_CONFIG_TYPE reg;
+	
+	reg.CONFIG = 0;
+	reg.DLPF_CFG = bw;
+	
+	err = update_reg_mpu6050(dev, MPU_6050_CONFIG, reg.CONFIG, 0x07);
+	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	
+	return 0;
+}
+
+/*! \brief  Get the gyroscope output rate for the current filter setting
+ *
+ *	\note	This function is for internal use
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *
+ *  \return gyroscope output rate in Hz
+ */
+static uint16_t gyro_rate_mpu6050(mpu6050_dev_t *dev){
+	MPU6050_CONFIG_TYPE reg;
+	
+	reg.CONFIG = (*shadow_mpu6050(dev, MPU_6050_CONFIG));
+	
+	if(reg.DLPF_CFG == MPU6050_DLPF_260 || reg.DLPF_CFG == 7) return 8000;
+	return 1000;
+}
+
+/*! \brief  Set the sample rate of the MPU6050
  *
- *  \param  *twi	pointer to the TWI module that is connected to the MPU6050
- *	\param	addr	address of the MPU6050
+ *	The divider is calculated from the gyroscope output rate of the current filter setting,
+ *	the closest possible rate between output rate / 256 and the output rate is used.
+ *	The data registers, the FIFO and the data ready interrupt are all updated at this rate.
+ *
+ *	\note The accelerometer output rate is 1kHz, with a higher sample rate the same accelerometer sample is read multiple times.
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	hz		wanted sample rate in Hz
  *
  *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
  */
-uint8_t disable_temp_mpu6050(TWI_t *twi, uint8_t addr){
-	uint8_t old_reg, err;
+uint8_t set_sample_rate_mpu6050(mpu6050_dev_t *dev, uint16_t hz){
+	uint8_t err;
+	uint16_t rate = gyro_rate_mpu6050(dev);
+	uint16_t div;
 	
-	err = read_8bit_register_TWI(twi, addr, &old_reg, MPU_6050_PWR_MGMT_1);
-	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
-	old_reg = (1 << 3); //!< Disables Temperature measurements
-	err = write_8bit_register_TWI(twi, addr, old_reg, MPU_6050_PWR_MGMT_1);
+	if(hz == 0) hz = 1;
+	
+	div = (rate + hz / 2) / hz;
+	if(div < 1) div = 1;
+	if(div > 256) div = 256;
+	
+	err = update_reg_mpu6050(dev, MPU_6050_SMPLRT_DIV, div - 1, 0xFF);
 	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
 	
 	return 0;
 }
 
-/*! \brief  Enables temperature measurement
+/*! \brief  Get the effective sample rate of the MPU6050
  *
- *  \param  *twi	pointer to the TWI module that is connected to the MPU6050
- *	\param	addr	address of the MPU6050
+ *	The sample rate is calculated from the copies of the CONFIG and SMPLRT_DIV registers, 
+ *	there is no I2C communication.
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	*hz		pointer to store the sample rate in Hz, rounded down
+ *
+ *  \return 0
+ */
+uint8_t get_sample_rate_mpu6050(mpu6050_dev_t *dev, uint16_t *hz){
+	*hz = gyro_rate_mpu6050(dev) / ((uint16_t) (*shadow_mpu6050(dev, MPU_6050_SMPLRT_DIV)) + 1);
+	
+	return 0;
+}
+
+/*! \brief  Get the time between two samples of the MPU6050
+ *
+ *	Calculated like get_sample_rate_mpu6050, but without rounding the rate, there is no I2C communication.
+ *	Use it as the time step of the fusion when the frames have no time stamps.
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *
+ *  \return sample period in us
+ */
+uint32_t get_sample_period_mpu6050(mpu6050_dev_t *dev){
+	return ((uint32_t) (*shadow_mpu6050(dev, MPU_6050_SMPLRT_DIV)) + 1) * 1000000UL / gyro_rate_mpu6050(dev);
+}
+
+/*! \brief  Checks if the MPU6050 has a new sample
+ *
+ *	Use this function to read once per sample instead of reading the data registers continuously.
+ *
+ *	\note Reading INT_STATUS clears all interrupt flags of the MPU6050.
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	*ready	pointer to store 1 if there is a new sample, 0 otherwise
  *
  *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
  */
-uint8_t enable_temp_mpu6050(TWI_t *twi, uint8_t addr){
-	uint8_t old_reg, err;
+uint8_t data_ready_mpu6050(mpu6050_dev_t *dev, uint8_t *ready){
+	uint8_t err;
+	MPU6050_INT_STATUS_TYPE int_status;
 	
-	err = read_8bit_register_TWI(twi, addr, &old_reg, MPU_6050_PWR_MGMT_1);
+	err = read_reg_mpu6050(dev, MPU_6050_INT_STATUS, &int_status.int_reg);
 	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
-	old_reg = (0 << 3); //!< Enables Temperature measurements
-	err = write_8bit_register_TWI(twi, addr, old_reg, MPU_6050_PWR_MGMT_1);
+	
+	*ready = int_status.DATA_RDY;
+	
+	return 0;
+}
+
+/*! \brief  Used for self testing
+ *
+ *	\warning	This function is not implemented!
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *
+ *  \return	returns always 0
+ */
+uint8_t self_test_x_mpu6050(mpu6050_dev_t *dev){
+	return 0;
+}
+
+/*! \brief  Used for self testing
+ *
+ *	\warning	This function is not implemented!
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *
+ *  \return returns always 0
+ */
+uint8_t self_test_y_mpu6050(mpu6050_dev_t *dev){
+	return 0;
+}
+
+/*! \brief  Used for self testing
+ *
+ *	\warning	This function is not implemented!
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *
+ *  \return returns always 0
+ */
+uint8_t self_test_z_mpu6050(mpu6050_dev_t *dev){
+	return 0;
+}
+
+/*! \brief  Used for self testing
+ *
+ *	\warning	This function is not implemented!
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	xyz		select XA/YA/ZA_TEST
+ *
+ *  \return returns always 0
+ */
+uint8_t self_test_a_mpu6050(mpu6050_dev_t *dev, uint8_t xyz){
+	return 0;
+}
+
+/*! \brief  Set accelerometer scale/range
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	scale	select The scale
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ */
+uint8_t accel_set_scale_mpu6050(mpu6050_dev_t *dev, uint8_t scale){
+	uint8_t err;
+	MPU6050_ACCEL_CONFIG_TYPE ACCEL;
+	ACCEL.ACCEL_CONFIG = 0;
+	
+	ACCEL.AFS_SEL = scale;
+	
+	err = update_reg_mpu6050(dev, MPU_6050_ACCEL_CONFIG, ACCEL.ACCEL_CONFIG, 0x18);
 	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
 	
+	dev->accel_state = scale;
+	
 	return 0;
 }
 
-/*! \brief  Resets the MPU6050
+/*! \brief  Get the accelerometer scale/range
  *
- *  \param  *twi	pointer to the TWI module that is connected to the MPU6050
- *	\param	addr	address of the MPU6050
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	*scale	pointer to store the scale/range value
  *
  *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ */
+uint8_t accel_get_scale_mpu6050(mpu6050_dev_t *dev, uint8_t *scale){
+	MPU6050_ACCEL_CONFIG_TYPE ACCEL;
+	
+	ACCEL.ACCEL_CONFIG = (*shadow_mpu6050(dev, MPU_6050_ACCEL_CONFIG));
+	(*scale) = ACCEL.AFS_SEL;
+	dev->accel_state = ACCEL.AFS_SEL;
+	
+	return 0;	
+}
+
+/*! \brief  Set gyroscope scale/range
  *
- *	When set to 1, this bit resets all internal registers to their default values.
- *	The bit automatically clears to 0 once the reset is done.
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	scale	select The scale
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
  */
-uint8_t reset_mpu6050(TWI_t *twi, uint8_t addr){
+uint8_t gyro_set_scale_mpu6050(mpu6050_dev_t *dev, uint8_t scale){
 	uint8_t err;
-	uint8_t reset = 0;
+	MPU6050_GYRO_CONFIG_TYPE GYRO;
+	GYRO.GYRO_CONFIG = 0;
 	
-	reset = (1 << 7);
+	GYRO.FS_SEL = scale;
 	
-	err = write_8bit_register_TWI(twi, addr, reset, MPU_6050_PWR_MGMT_1);
+	err = update_reg_mpu6050(dev, MPU_6050_GYRO_CONFIG, GYRO.GYRO_CONFIG, 0x18);
 	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
 	
+	dev->gyro_state = scale;
+	
 	return 0;	
 }
 
-/*! \brief  Resets the accelerometer of the MPU6050
+/*! \brief  Get the gyroscope scale/range
  *
- *  \param  *twi	pointer to the TWI module that is connected to the MPU6050
- *	\param	addr	address of the MPU6050
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	*scale	pointer to store the scale/range value
  *
  *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ */
+uint8_t gyro_get_scale_mpu6050(mpu6050_dev_t *dev, uint8_t *scale){
+	MPU6050_GYRO_CONFIG_TYPE GYRO;
+	
+	GYRO.GYRO_CONFIG = (*shadow_mpu6050(dev, MPU_6050_GYRO_CONFIG));
+	(*scale) = GYRO.FS_SEL;
+	dev->gyro_state = GYRO.FS_SEL;
+	
+	return 0;	
+}
+
+/*! \brief  Turn off or on standby mode accelerometer and gyroscope
  *
- *	This register is used to reset the analog and digital signal paths of the accelerometer.
- *	The reset will revert the signal path analog to digital converters and filters to their power up
- *	configurations
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	on_off	1 turn on standby 0 turn off standby
  *
- *	\note This function does not clear the sensor register
+ *  \return 0 if successful error code from TWI if unsuccessful full
  */
-uint8_t reset_accel_mpu6050(TWI_t *twi, uint8_t addr){
+uint8_t stdby_all_mpu6050(mpu6050_dev_t *dev, uint8_t on_off){
 	uint8_t err;
-	uint8_t reset = 0;
 	
-	reset = (1 << 1);
+	err = update_reg_mpu6050(dev, MPU_6050_PWR_MGMT_2, on_off ? 0x3F : 0x00, 0x3F);	//!< Keeps LP_WAKE_CTRL
+	if(check_err_mpu6050(err) != 0) return err;
+	
+	return 0;
+}
+
+/*! \brief  Turn off or on standby mode accelerometer x-axis
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	on_off	1 turn on standby 0 turn off standby
+ *
+ *  \return 0 if successful error code from TWI if unsuccessful full
+ */
+uint8_t stdby_accel_x_mpu6050(mpu6050_dev_t *dev, uint8_t on_off){
+	uint8_t err;
+	MPU6050_PWR_MGMT_2_TYPE PWR_MGMT_2;
+	
+	PWR_MGMT_2.PWR_MGMT_2 = 0;
+	PWR_MGMT_2.STBY_XA = on_off;
+	
+	err = update_reg_mpu6050(dev, MPU_6050_PWR_MGMT_2, PWR_MGMT_2.PWR_MGMT_2, (1 << 5));
+	if(check_err_mpu6050(err) != 0) return err;
+	
+	return 0;
+}
+
+/*! \brief  Turn off or on standby mode accelerometer y-axis
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	on_off	1 turn on standby 0 turn off standby
+ *
+ *  \return 0 if successful error code from TWI if unsuccessful full
+ */
+uint8_t stdby_accel_y_mpu6050(mpu6050_dev_t *dev, uint8_t on_off){
+	uint8_t err;
+	MPU6050_PWR_MGMT_2_TYPE PWR_MGMT_2;
+	
+	PWR_MGMT_2.PWR_MGMT_2 = 0;
+	PWR_MGMT_2.STBY_YA = on_off;
+	
+	err = update_reg_mpu6050(dev, MPU_6050_PWR_MGMT_2, PWR_MGMT_2.PWR_MGMT_2, (1 << 4));
+	if(check_err_mpu6050(err) != 0) return err;
+	
+	return 0;
+}
+
+/*! \brief  Turn off or on standby mode accelerometer z-axis
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	on_off	1 turn on standby 0 turn off standby
+ *
+ *  \return 0 if successful error code from TWI if unsuccessful full
+ */
+uint8_t stdby_accel_z_mpu6050(mpu6050_dev_t *dev, uint8_t on_off){
+	uint8_t err;
+	MPU6050_PWR_MGMT_2_TYPE PWR_MGMT_2;
+	
+	PWR_MGMT_2.PWR_MGMT_2 = 0;
+	PWR_MGMT_2.STBY_ZA = on_off;
+	
+	err = update_reg_mpu6050(dev, MPU_6050_PWR_MGMT_2, PWR_MGMT_2.PWR_MGMT_2, (1 << 3));
+	if(check_err_mpu6050(err) != 0) return err;
+	
+	return 0;
+}
+
+/*! \brief  Turn off or on standby mode gyroscope x-axis
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	on_off	1 turn on standby 0 turn off standby
+ *
+ *  \return 0 if successful error code from TWI if unsuccessful full
+ */
+uint8_t stdby_gyro_x_mpu6050(mpu6050_dev_t *dev, uint8_t on_off){
+	uint8_t err;
+	MPU6050_PWR_MGMT_2_TYPE PWR_MGMT_2;
+	
+	PWR_MGMT_2.PWR_MGMT_2 = 0;
+	PWR_MGMT_2.STBY_XG = on_off;
+	
+	err = update_reg_mpu6050(dev, MPU_6050_PWR_MGMT_2, PWR_MGMT_2.PWR_MGMT_2, (1 << 2));
+	if(check_err_mpu6050(err) != 0) return err;
+	
+	return 0;
+}
+
+/*! \brief  Turn off or on standby mode gyroscope y-axis
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	on_off	1 turn on standby 0 turn off standby
+ *
+ *  \return 0 if successful error code from TWI if unsuccessful full
+ */
+uint8_t stdby_gyro_y_mpu6050(mpu6050_dev_t *dev, uint8_t on_off){
+	uint8_t err;
+	MPU6050_PWR_MGMT_2_TYPE PWR_MGMT_2;
+	
+	PWR_MGMT_2.PWR_MGMT_2 = 0;
+	PWR_MGMT_2.STBY_YG = on_off;
+	
+	err = update_reg_mpu6050(dev, MPU_6050_PWR_MGMT_2, PWR_MGMT_2.PWR_MGMT_2, (1 << 1));
+	if(check_err_mpu6050(err) != 0) return err;
+	
+	return 0;
+}
+
+/*! \brief  Turn off or on standby mode gyroscope z-axis
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	on_off	1 turn on standby 0 turn off standby
+ *
+ *  \return 0 if successful error code from TWI if unsuccessful full
+ */
+uint8_t stdby_gyro_z_mpu6050(mpu6050_dev_t *dev, uint8_t on_off){
+	uint8_t err;
+	MPU6050_PWR_MGMT_2_TYPE PWR_MGMT_2;
+	
+	PWR_MGMT_2.PWR_MGMT_2 = 0;
+	PWR_MGMT_2.STBY_ZG = on_off;
+	
+	err = update_reg_mpu6050(dev, MPU_6050_PWR_MGMT_2, PWR_MGMT_2.PWR_MGMT_2, (1 << 0));
+	if(check_err_mpu6050(err) != 0) return err;
+	
+	return 0;
+}
+/*! \brief  Selects which sensors are written to the FIFO and enables the FIFO
+ *
+ *	The FIFO is reset before it is enabled so it only contains frames with the new layout.
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	sensors	MPU6050_FIFO_xxx_bm bits of the sensors that need to be written to the FIFO, 0 disables the FIFO
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ */
+uint8_t fifo_enable_mpu6050(mpu6050_dev_t *dev, uint8_t sensors){
+	uint8_t err, user_ctrl;
+	
+	sensors &= MPU6050_FIFO_TEMP_bm | MPU6050_FIFO_GYRO_bm | MPU6050_FIFO_ACCEL_bm;
+	
+	err = update_reg_mpu6050(dev, MPU_6050_FIFO_EN, sensors, 0xFF);
+	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	
+	user_ctrl = (*shadow_mpu6050(dev, MPU_6050_USER_CTRL)) & ~MPU6050_USER_FIFO_EN_bm;
+	if(sensors != 0) user_ctrl |= MPU6050_USER_FIFO_EN_bm;
 	
-	err = write_8bit_register_TWI(twi, addr, reset, MPU_6050_SIGNAL_PATH_RESET);
+	err = write_reg_mpu6050(dev, MPU_6050_USER_CTRL, user_ctrl | MPU6050_USER_FIFO_RESET_bm);
 	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
 	
+	(*shadow_mpu6050(dev, MPU_6050_USER_CTRL)) = user_ctrl;	//!< The reset bit clears itself
+	dev->fifo_sensors = sensors;
+	dev->fifo_time_valid = 0;
+	
 	return 0;
 }
 
-/*! \brief  Resets the gyroscope of the MPU6050
+/*! \brief  Empties the FIFO
  *
- *  \param  *twi	pointer to the TWI module that is connected to the MPU6050
- *	\param	addr	address of the MPU6050
+ *  \param  *dev	pointer to the MPU6050 device
  *
  *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
- *
- *	This register is used to reset the analog and digital signal paths of the gyroscope.
- *	The reset will revert the signal path analog to digital converters and filters to their power up
- *	configurations
- *
- *	\note This function does not clear the sensor register
  */
-uint8_t reset_gyro_mpu6050(TWI_t *twi, uint8_t addr){
-	uint8_t err;
-	uint8_t reset = 0;
+uint8_t fifo_reset_mpu6050(mpu6050_dev_t *dev){
+	uint8_t err, user_ctrl;
 	
-	reset = (1 << 2);
+	user_ctrl = (*shadow_mpu6050(dev, MPU_6050_USER_CTRL));
 	
-	err = write_8bit_register_TWI(twi, addr, reset, MPU_6050_SIGNAL_PATH_RESET);
+	err = write_reg_mpu6050(dev, MPU_6050_USER_CTRL, user_ctrl | MPU6050_USER_FIFO_RESET_bm);	//!< The bit automatically clears to 0 after the FIFO is reset
 	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
 	
-	return 0;	
+	dev->fifo_time_valid = 0;
+	
+	return 0;
 }
 
-/*! \brief  Resets the temperature sensor of the MPU6050
- *
- *  \param  *twi	pointer to the TWI module that is connected to the MPU6050
- *	\param	addr	address of the MPU6050
+/*! \brief  Sets the minimum amount of frames that need to be in the FIFO before fifo_drain_mpu6050 reads them
  *
- *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ *  \param  *dev	pointer to the MPU6050 device
+ *  \param  frames	amount of frames, 0 is handled as 1
+ */
+void fifo_set_watermark_mpu6050(mpu6050_dev_t *dev, uint16_t frames){
+	if(frames == 0) frames = 1;
+	dev->fifo_watermark = frames;
+}
+
+/*! \brief  Get the size of one FIFO frame
  *
- *	This register is used to reset the analog and digital signal paths of the temperature sensors.
- *	The reset will revert the signal path analog to digital converters and filters to their power up
- *	configurations
+ *  \param  sensors	MPU6050_FIFO_xxx_bm bits of the sensors that are written to the FIFO
  *
- *	\note This function does not clear the sensor register
+ *  \return amount of bytes in one frame
  */
-uint8_t reset_temp_mpu6050(TWI_t *twi, uint8_t addr){
-	uint8_t err;
-	uint8_t reset = 0;
-	
-	reset = (1 << 0);
+uint8_t fifo_frame_size_mpu6050(uint8_t sensors){
+	uint8_t size = 0;
 	
-	err = write_8bit_register_TWI(twi, addr, reset, MPU_6050_SIGNAL_PATH_RESET);
-	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	if(sensors & MPU6050_FIFO_TEMP_bm) size += 2;
+	if(sensors & MPU6050_FIFO_XG_bm) size += 2;
+	if(sensors & MPU6050_FIFO_YG_bm) size += 2;
+	if(sensors & MPU6050_FIFO_ZG_bm) size += 2;
+	if(sensors & MPU6050_FIFO_ACCEL_bm) size += 6;
 	
-	return 0;	
+	return size;
 }
 
-/*! \brief  Select the clock source of the MPU6050
+/*! \brief  Get the amount of bytes in the FIFO
  *
- *  \param  *twi	pointer to the TWI module that is connected to the MPU6050
- *	\param	addr	address of the MPU6050
- *	\param	clk_sel	used to select what clk source the MPU6050 uses.
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	*count	pointer to store the amount of bytes
  *
  *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
  */
-uint8_t clk_sel_mpu6050(TWI_t *twi, uint8_t addr, uint8_t clk_sel){
-	uint8_t err;
-	MPU6050_PWR_MGMT_1_TYPE reg;
+uint8_t fifo_count_mpu6050(mpu6050_dev_t *dev, uint16_t *count){
+	uint8_t err, buff[2];
 	
-	err = read_8bit_register_TWI(twi, addr, &reg.PWR_MGMT_1, MPU_6050_PWR_MGMT_1);
+	err = read_burst_mpu6050(dev, MPU_6050_FIFO_COUNTH, buff, 2);
 	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
 	
-	reg.CLKSEL = clk_sel;
-	
-	err = write_8bit_register_TWI(twi, addr, reg.PWR_MGMT_1 , MPU_6050_PWR_MGMT_1);
-	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	(*count) = ( (uint16_t) buff[0] << 8 ) | buff[1];
 	
-	return 0;		
-}
-
-
-/*! \brief  Used for self testing
- *
- *	\warning	This function is not implemented!
- *
- *  \param  *twi	pointer to the TWI module that is connected to the MPU6050
- *	\param	addr	address of the MPU6050
- *
- *  \return	returns always 0
- */
-uint8_t self_test_x_mpu6050(TWI_t *twi, uint8_t addr){
 	return 0;
 }
 
-/*! \brief  Used for self testing
+/*! \brief  Reads whole frames from the FIFO once the watermark is reached
  *
- *	\warning	This function is not implemented!
+ *	The frames are read in one burst from MPU_6050_FIFO_R_W. The register pointer does not increment
+ *	on this register, so every byte of the burst is the next byte of the FIFO.
+ *	The bytes are stored as they are in the FIFO: big endian, in the order accel, temp, gyro x, y, z.
  *
- *  \param  *twi	pointer to the TWI module that is connected to the MPU6050
- *	\param	addr	address of the MPU6050
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	*buff	pointer to store the frames, needs to hold max_frames frames
+ *	\param	max_frames	maximum amount of frames that fit in buff
+ *	\param	*frames	pointer to store the amount of frames that were read, 0 if the watermark is not reached
  *
- *  \return returns always 0
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1, MPU6050_FIFO_OVERFLOW if frames were lost 
+ *			(the FIFO is reset) otherwise returns 2
  */
-uint8_t self_test_y_mpu6050(TWI_t *twi, uint8_t addr){
-	return 0;
+uint8_t fifo_drain_mpu6050(mpu6050_dev_t *dev, uint8_t *buff, uint16_t max_frames, uint16_t *frames){
+	return fifo_drain_stamped_mpu6050(dev, buff, 0, max_frames, frames);
 }
 
-/*! \brief  Used for self testing
+/*! \brief  Calculates the time stamps of the frames in the FIFO
  *
- *	\warning	This function is not implemented!
+ *	\note	This function is for internal use
  *
- *  \param  *twi	pointer to the TWI module that is connected to the MPU6050
- *	\param	addr	address of the MPU6050
+ *	The newest frame in the FIFO was sampled at most one sample period before the FIFO count was read.
+ *	The time stamps of the previous read are continued with the sample period, and only moved into that
+ *	window when they drift out of it. So the time stamps do not jitter with the time the FIFO is read.
  *
- *  \return returns always 0
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	*stamps	pointer to store the time stamps of the frames that are read
+ *	\param	now		value of clock_us after the FIFO count was read
+ *	\param	count	amount of frames in the FIFO
+ *	\param	read	amount of frames that are read, the oldest frames
  */
-uint8_t self_test_z_mpu6050(TWI_t *twi, uint8_t addr){
-	return 0;
+static void fifo_stamp_mpu6050(mpu6050_dev_t *dev, uint32_t *stamps, uint32_t now, uint16_t count, uint16_t read){
+	uint32_t period = get_sample_period_mpu6050(dev);
+	uint32_t newest = now - period / 2;	//!< Without history the middle of the window has the smallest error
+	int32_t diff;
+	
+	if(read == 0) return;
+	
+	if(dev->fifo_time_valid){
+		newest = dev->fifo_time_us + count * period;
+		diff = (int32_t) (newest - now);
+		if(diff > 0) newest = now;
+		else if(diff < -(int32_t) period) newest = now - period;
+	}
+	
+	for(uint16_t i = 0; i < read; i++){
+		stamps[i] = newest - (uint32_t) (count - 1 - i) * period;
+	}
+	
+	dev->fifo_time_us = stamps[read - 1];
+	dev->fifo_time_valid = 1;
 }
 
-/*! \brief  Used for self testing
+/*! \brief  Reads whole frames from the FIFO with the time each frame was sampled
  *
- *	\warning	This function is not implemented!
+ *	Works like fifo_drain_mpu6050. The time stamps are reconstructed from the sample rate and the time
+ *	the FIFO count is read with clock_us of the device, so the FIFO can be read in batches long after the
+ *	samples were taken. The time stamps are only meaningful when clock_us is set.
  *
- *  \param  *twi	pointer to the TWI module that is connected to the MPU6050
- *	\param	addr	address of the MPU6050
- *	\param	xyz		select XA/YA/ZA_TEST
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	*buff	pointer to store the frames, needs to hold max_frames frames
+ *	\param	*stamps	pointer to store the time stamp in us of every frame, needs to hold max_frames values, can be 0
+ *	\param	max_frames	maximum amount of frames that fit in buff
+ *	\param	*frames	pointer to store the amount of frames that were read, 0 if the watermark is not reached
  *
- *  \return returns always 0
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1, MPU6050_FIFO_OVERFLOW if frames were lost 
+ *			(the FIFO is reset) otherwise returns 2
  */
-uint8_t self_test_a_mpu6050(TWI_t *twi, uint8_t addr, uint8_t xyz){
+uint8_t fifo_drain_stamped_mpu6050(mpu6050_dev_t *dev, uint8_t *buff, uint32_t *stamps, uint16_t max_frames, uint16_t *frames){
+	uint8_t err, size;
+	uint16_t count, read;
+	uint32_t now;
+	
+	(*frames) = 0;
+	if(max_frames == 0) return 0;
+	
+	size = fifo_frame_size_mpu6050(dev->fifo_sensors);
+	if(size == 0) return 0;
+	
+	err = fifo_count_mpu6050(dev, &count);
+	if(err != 0) return err;
+	
+	now = clock_now_mpu6050(dev);	//!< After the read, a sample during the read is counted
+	
+	if(count >= MPU6050_FIFO_SIZE){	//!< A full FIFO can hold a partial frame, start over
+		err = fifo_reset_mpu6050(dev);
+		if(err != 0) return err;
+		return MPU6050_FIFO_OVERFLOW;
+	}
+	
+	count /= size;
+	if(count < dev->fifo_watermark || count == 0) return 0;
+	read = (count > max_frames) ? max_frames : count;
+	
+	err = read_burst_mpu6050(dev, MPU_6050_FIFO_R_W, buff, read * size);
+	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	
+	if(stamps != 0) fifo_stamp_mpu6050(dev, stamps, now, count, read);
+	else dev->fifo_time_valid = 0;
+	
+	(*frames) = read;
+	
 	return 0;
 }
 
-/*! \brief  Set accelerometer scale/range
+/*! \brief  Starts the Digital Motion Processor
  *
- *  \param  *twi	pointer to the TWI module that is connected to the MPU6050
- *	\param	addr	address of the MPU6050
- *	\param	scale	select The scale
+ *	The firmware needs to be loaded with dmp_load_mpu6050 first. The FIFO is switched from the sensors 
+ *	to the Digital Motion Processor, the FIFO and the Digital Motion Processor are reset.
+ *	Read the packets with dmp_read_mpu6050.
+ *
+ *  \param  *dev		pointer to the MPU6050 device
+ *	\param	features	MPU6050_DMP_xxx_bm outputs that the loaded firmware writes to the FIFO
  *
  *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
  */
-uint8_t accel_set_scale_mpu6050(TWI_t *twi, uint8_t addr, uint8_t scale){
-	uint8_t err, data;
-	MPU6050_ACCEL_CONFIG_TYPE ACCEL;
-	ACCEL.ACCEL_CONFIG = 0;
+uint8_t dmp_enable_mpu6050(mpu6050_dev_t *dev, uint8_t features){
+	uint8_t err, user_ctrl;
 	
-	err = read_8bit_register_TWI(twi, addr, &data, MPU_6050_ACCEL_CONFIG);
+	err = update_reg_mpu6050(dev, MPU_6050_FIFO_EN, 0, 0xFF);
 	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	dev->fifo_sensors = 0;
 	
-	ACCEL.ACCEL_CONFIG = data;
-	ACCEL.AFS_SEL = scale;
-	data = ACCEL.ACCEL_CONFIG;
+	user_ctrl = (*shadow_mpu6050(dev, MPU_6050_USER_CTRL)) | MPU6050_USER_DMP_EN_bm | MPU6050_USER_FIFO_EN_bm;
 	
-	err = write_8bit_register_TWI(twi, addr, data, MPU_6050_ACCEL_CONFIG);
+	err = write_reg_mpu6050(dev, MPU_6050_USER_CTRL, user_ctrl | MPU6050_USER_DMP_RESET_bm | MPU6050_USER_FIFO_RESET_bm);
 	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
 	
-	accel_state = scale;
+	(*shadow_mpu6050(dev, MPU_6050_USER_CTRL)) = user_ctrl;	//!< The reset bits clear themselves
+	dev->dmp_features = features;
 	
 	return 0;
 }
 
-/*! \brief  Get the accelerometer scale/range
+/*! \brief  Stops the Digital Motion Processor and disables the FIFO
  *
- *  \param  *twi	pointer to the TWI module that is connected to the MPU6050
- *	\param	addr	address of the MPU6050
- *	\param	*scale	pointer to store the scale/range value
+ *  \param  *dev	pointer to the MPU6050 device
  *
  *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
  */
-uint8_t accel_get_scale_mpu6050(TWI_t *twi, uint8_t addr, uint8_t *scale){
-	uint8_t err, data;
-	MPU6050_ACCEL_CONFIG_TYPE ACCEL;
+uint8_t dmp_disable_mpu6050(mpu6050_dev_t *dev){
+	uint8_t err;
 	
-	err = read_8bit_register_TWI(twi, addr, &data, MPU_6050_ACCEL_CONFIG);
+	err = update_reg_mpu6050(dev, MPU_6050_USER_CTRL, 0, MPU6050_USER_DMP_EN_bm | MPU6050_USER_FIFO_EN_bm);
 	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
 	
-	ACCEL.ACCEL_CONFIG = data;
-	(*scale) = ACCEL.AFS_SEL;
-	accel_state = ACCEL.AFS_SEL;
+	dev->dmp_features = 0;
 	
-	return 0;	
+	return 0;
 }
 
-/*! \brief  Set gyroscope scale/range
+#ifdef __AVR__
+/*! \brief  Starts interrupt driven acquisition on the DATA_RDY interrupt
  *
- *  \param  *twi	pointer to the TWI module that is connected to the MPU6050
- *	\param	addr	address of the MPU6050
- *	\param	scale	select The scale
+ *	The INT pin of the MPU6050 has to be connected to pin of port. INT0 of that port is configured
+ *	to trigger on the rising edge, the application has to call acq_isr_mpu6050 from its
+ *	ISR(PORTx_INT0_vect), twi_isr_async_mpu6050 from its ISR(TWIx_TWIM_vect) and enable interrupts with sei().
+ *
+ *	\note	While acquisition is running the TWI module is used from the interrupt. Blocking transactions on the
+ *			same TWI module can still be done, a sample that arrives during one is counted as dropped.
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	*port	pointer to the port that the INT pin is connected to
+ *	\param	pin		pin number (0-7) that the INT pin is connected to
  *
  *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
  */
-uint8_t gyro_set_scale_mpu6050(TWI_t *twi, uint8_t addr, uint8_t scale){
-	uint8_t err, data;
-	MPU6050_GYRO_CONFIG_TYPE GYRO;
-	GYRO.GYRO_CONFIG = 0;
-	
-	err = read_8bit_register_TWI(twi, addr, &data, MPU_6050_ACCEL_CONFIG);
-	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+uint8_t acq_start_mpu6050(mpu6050_dev_t *dev, PORT_t *port, uint8_t pin){
+	uint8_t err;
 	
-	GYRO.GYRO_CONFIG = data;
-	GYRO.FS_SEL = scale;
-	data = GYRO.GYRO_CONFIG;
+	dev->acq.port = port;
+	dev->acq.pin = pin;
+	dev->acq.head = 0;
+	dev->acq.tail = 0;
+	dev->acq.dropped = 0;
 	
-	err = write_8bit_register_TWI(twi, addr, data, MPU_6050_ACCEL_CONFIG);
-	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	port->DIRCLR = (1 << pin);
+	(&port->PIN0CTRL)[pin] = PORT_ISC_RISING_gc;
+	port->INT0MASK |= (1 << pin);
+	port->INTFLAGS = PORT_INT0IF_bm;
+	port->INTCTRL = (port->INTCTRL & ~PORT_INT0LVL_gm) | PORT_INT0LVL_LO_gc;
+	PMIC.CTRL |= PMIC_LOLVLEN_bm;
 	
-	gyro_state = scale;
+	err = int_enable_mpu6050(dev, DATA_RDY_INT_EN);
+	if(err != 0) return err;
 	
-	return 0;	
+	return 0;
 }
 
-/*! \brief  Get the gyroscope scale/range
+/*! \brief  Stops interrupt driven acquisition
  *
- *  \param  *twi	pointer to the TWI module that is connected to the MPU6050
- *	\param	addr	address of the MPU6050
- *	\param	*scale	pointer to store the scale/range value
+ *	Frames that are still in the ring buffer can be read with acq_pop_mpu6050.
+ *
+ *  \param  *dev	pointer to the MPU6050 device
  *
  *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
  */
-uint8_t gyro_get_scale_mpu6050(TWI_t *twi, uint8_t addr, uint8_t *scale){
-	uint8_t err, data;
-	MPU6050_GYRO_CONFIG_TYPE GYRO;
-	
-	err = read_8bit_register_TWI(twi, addr, &data, MPU_6050_ACCEL_CONFIG);
-	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+uint8_t acq_stop_mpu6050(mpu6050_dev_t *dev){
+	if(dev->acq.port == 0) return 0;
 	
-	GYRO.GYRO_CONFIG = data;	
-	(*scale) = GYRO.FS_SEL;
-	gyro_state = GYRO.FS_SEL;
+	dev->acq.port->INT0MASK &= ~(1 << dev->acq.pin);
 	
-	return 0;	
+	return int_disable_mpu6050(dev, DATA_RDY_INT_EN);
 }
 
-/*! \brief  Turn off or on standby mode accelerometer and gyroscope
+/*! \brief  Starts reading a new sample into the ring buffer
  *
- *  \param  *twi	pointer to the TWI module that is connected to the MPU6050
- *	\param	addr	address of the MPU6050
- *	\param	on_off	1 turn on standby 0 turn off standby
+ *	Call this function from the ISR of the port interrupt that is configured with acq_start_mpu6050.
+ *	The sample is read with read_async_mpu6050, so twi_isr_async_mpu6050 also needs to be called from
+ *	the TWI master interrupt. If the ring buffer is full or the previous read is still busy the sample 
+ *	is left in the MPU6050 and counted as dropped.
  *
- *  \return 0 if successful error code from TWI if unsuccessful full
+ *  \param  *dev	pointer to the MPU6050 device that is connected to the interrupt pin
  */
-uint8_t stdby_all_mpu6050(TWI_t *twi, uint8_t addr, uint8_t on_off){
-	uint8_t err, buff;
-	MPU6050_PWR_MGMT_2_TYPE PWR_MGMT_2;
-	
-	err = read_8bit_register_TWI(twi, addr, &buff, MPU_6050_PWR_MGMT_2);
-	if(check_err_mpu6050(err) != 0) return err;
+void acq_isr_mpu6050(mpu6050_dev_t *dev){
+	uint8_t next = (dev->acq.head + 1) & (MPU6050_RING_SIZE - 1);
+	uint32_t stamp = clock_now_mpu6050(dev);	//!< As close to the DATA_RDY edge as possible
 	
-	PWR_MGMT_2.PWR_MGMT_2 = buff;
+	if(next == dev->acq.tail){
+		dev->acq.dropped++;
+		return;
+	}
 	
-	buff = PWR_MGMT_2.LP_WAKE_CTRL;
-	PWR_MGMT_2.PWR_MGMT_2 = 0;
-	PWR_MGMT_2.LP_WAKE_CTRL = buff;
-	buff = PWR_MGMT_2.PWR_MGMT_2;
+	dev->acq.len = ((*shadow_mpu6050(dev, MPU_6050_PWR_MGMT_1)) & (1 << 5)) ? MPU6050_ACCEL_BYTES : MPU6050_MOTION_BYTES;	//!< Only the accelerometer in cycle mode
 	
-	err = write_8bit_register_TWI(twi, addr, buff, MPU_6050_PWR_MGMT_2);
-	if(check_err_mpu6050(err) != 0) return err;
+	dev->acq.stamp = stamp;
 	
-	return 0;
+	if(read_async_mpu6050(dev, MPU_6050_ACCEL_XOUT_H, dev->acq.raw, dev->acq.len, acq_done_mpu6050) != 0){
+		dev->acq.dropped++;
+	}
 }
 
-/*! \brief  Turn off or on standby mode accelerometer x-axis
+/*! \brief  Stores the sample that was read by acq_isr_mpu6050 in the ring buffer
  *
- *  \param  *twi	pointer to the TWI module that is connected to the MPU6050
- *	\param	addr	address of the MPU6050
- *	\param	on_off	1 turn on standby 0 turn off standby
+ *	\note	This function is for internal use
  *
- *  \return 0 if successful error code from TWI if unsuccessful full
+ *  \param  *dev	pointer to the MPU6050 device
+ *  \param  status	status code of the TWI library
  */
-uint8_t stdby_accel_x_mpu6050(TWI_t *twi, uint8_t addr, uint8_t on_off){
-	uint8_t err, buff;
-	MPU6050_PWR_MGMT_2_TYPE PWR_MGMT_2;
-	
-	err = read_8bit_register_TWI(twi, addr, &buff, MPU_6050_PWR_MGMT_2);
-	if(check_err_mpu6050(err) != 0) return err;
-	
-	PWR_MGMT_2.PWR_MGMT_2 = buff;
-	PWR_MGMT_2.STBY_XA = on_off;
-	buff = PWR_MGMT_2.PWR_MGMT_2;
+static void acq_done_mpu6050(mpu6050_dev_t *dev, uint8_t status){
+	uint8_t head = dev->acq.head;
 	
-	err = write_8bit_register_TWI(twi, addr, buff, MPU_6050_PWR_MGMT_2);
-	if(check_err_mpu6050(err) != 0) return err;
+	if(status != TWI_STATUS_OK){
+		dev->acq.dropped++;
+		return;
+	}
 	
-	return 0;
+	if(dev->acq.len == MPU6050_ACCEL_BYTES){
+		memset(dev->acq.raw + MPU6050_ACCEL_BYTES, 0, MPU6050_MOTION_BYTES - MPU6050_ACCEL_BYTES);
+	}
+	unpack_motion_mpu6050(dev->acq.raw, &dev->acq.frame[head]);
+	dev->acq.frame[head].time_us = dev->acq.stamp;
+	dev->acq.head = (head + 1) & (MPU6050_RING_SIZE - 1);	//!< Publish the frame after it is completely written
 }
 
-/*! \brief  Turn off or on standby mode accelerometer y-axis
+/*! \brief  Takes the oldest frame out of the ring buffer
  *
- *  \param  *twi	pointer to the TWI module that is connected to the MPU6050
- *	\param	addr	address of the MPU6050
- *	\param	on_off	1 turn on standby 0 turn off standby
+ *	This function does not block and does not use the TWI bus.
  *
- *  \return 0 if successful error code from TWI if unsuccessful full
+ *  \param  *dev	pointer to the MPU6050 device
+ *  \param  *frame	pointer to store the frame
+ *
+ *  \return 1 if a frame was stored in frame, 0 if the ring buffer is empty
  */
-uint8_t stdby_accel_y_mpu6050(TWI_t *twi, uint8_t addr, uint8_t on_off){
-	uint8_t err, buff;
-	MPU6050_PWR_MGMT_2_TYPE PWR_MGMT_2;
+uint8_t acq_pop_mpu6050(mpu6050_dev_t *dev, mpu6050_motion_t *frame){
+	uint8_t tail = dev->acq.tail;
 	
-	err = read_8bit_register_TWI(twi, addr, &buff, MPU_6050_PWR_MGMT_2);
-	if(check_err_mpu6050(err) != 0) return err;
+	if(tail == dev->acq.head) return 0;
 	
-	PWR_MGMT_2.PWR_MGMT_2 = buff;
-	PWR_MGMT_2.STBY_YA = on_off;
-	buff = PWR_MGMT_2.PWR_MGMT_2;
+	(*frame) = dev->acq.frame[tail];
+	dev->acq.tail = (tail + 1) & (MPU6050_RING_SIZE - 1);	//!< Free the slot after it is copied
 	
-	err = write_8bit_register_TWI(twi, addr, buff, MPU_6050_PWR_MGMT_2);
-	if(check_err_mpu6050(err) != 0) return err;
+	return 1;
+}
+
+/*! \brief  Get the amount of samples that could not be stored since acq_start_mpu6050
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *
+ *  \return amount of dropped samples
+ */
+uint16_t acq_dropped_mpu6050(mpu6050_dev_t *dev){
+	uint16_t dropped;
+	uint8_t sreg = SREG;
 	
-	return 0;	
+	cli();
+	dropped = dev->acq.dropped;
+	SREG = sreg;
+	
+	return dropped;
 }
 
-/*! \brief  Turn off or on standby mode accelerometer z-axis
+/*! \brief  Starts the asynchronous read of the TWI transport
  *
- *  \param  *twi	pointer to the TWI module that is connected to the MPU6050
+ *	\note	This function is for internal use
+ *
+ *  \param  *ctx	pointer to the TWI module that is connected to the MPU6050
  *	\param	addr	address of the MPU6050
- *	\param	on_off	1 turn on standby 0 turn off standby
+ *	\param	reg		first register that needs to be read
+ *	\param	*data	pointer to store the register values
+ *	\param	len		amount of registers that need to be read
+ *	\param	done	function that is called from the TWI master interrupt when the read is finished
+ *	\param	*arg		passed to done
  *
- *  \return 0 if successful error code from TWI if unsuccessful full
+ *  \return TWI_STATUS_OK if the read is started, BUS_IN_USE if the TWI module or the TWI/I2C bus is in use
  */
-uint8_t stdby_accel_z_mpu6050(TWI_t *twi, uint8_t addr, uint8_t on_off){
-	uint8_t err, buff;
-	MPU6050_PWR_MGMT_2_TYPE PWR_MGMT_2;
+static uint8_t twi_bus_read_async_mpu6050(void *ctx, uint8_t addr, uint8_t reg, uint8_t *data, uint16_t len, mpu6050_done_t done, void *arg){
+	TWI_t *twi = (TWI_t *) ctx;
+	mpu6050_twi_async_t *slot = async_slot_mpu6050(twi);
+	uint8_t sreg;
+	
+	if(slot == 0) return BUS_IN_USE;
+	
+	sreg = SREG;
+	cli();	//!< Can be called from the main loop and from the port interrupt
+	if(slot->state != ASYNC_IDLE || (twi->MASTER.STATUS & TWI_MASTER_BUSSTATE_gm) == TWI_MASTER_BUSSTATE_BUSY_gc){
+		SREG = sreg;
+		return BUS_IN_USE;
+	}
+	slot->state = ASYNC_ADDR_W;
+	SREG = sreg;
+	
+	slot->addr = addr;
+	slot->reg = reg;
+	slot->data = data;
+	slot->len = len;
+	slot->index = 0;
+	slot->done = done;
+	slot->arg = arg;
+	
+	twi->MASTER.CTRLA = (twi->MASTER.CTRLA & ~TWI_MASTER_INTLVL_gm) | TWI_MASTER_INTLVL_LO_gc | TWI_MASTER_RIEN_bm | TWI_MASTER_WIEN_bm;
+	PMIC.CTRL |= PMIC_LOLVLEN_bm;
+	twi->MASTER.ADDR = (addr << 1);	//!< Write the register pointer
+	
+	return TWI_STATUS_OK;
+}
+
+/*! \brief  Handles the next step of the asynchronous transaction of a TWI module
+ *
+ *	Call this function from the TWI master interrupt of every TWI module that is connected to an MPU6050,
+ *	for example ISR(TWIE_TWIM_vect){ twi_isr_async_mpu6050(&TWIE); }
+ *
+ *  \param  *twi	pointer to the TWI module of the interrupt
+ */
+void twi_isr_async_mpu6050(TWI_t *twi){
+	mpu6050_twi_async_t *slot = async_slot_mpu6050(twi);
+	uint8_t status;
 	
-	err = read_8bit_register_TWI(twi, addr, &buff, MPU_6050_PWR_MGMT_2);
-	if(check_err_mpu6050(err) != 0) return err;
+	if(slot == 0) return;
+	if(slot->state == ASYNC_IDLE || slot->state == ASYNC_BLOCKING) return;
 	
-	PWR_MGMT_2.PWR_MGMT_2 = buff;
-	PWR_MGMT_2.STBY_ZA = on_off;
-	buff = PWR_MGMT_2.PWR_MGMT_2;
+	status = twi->MASTER.STATUS;
 	
-	err = write_8bit_register_TWI(twi, addr, buff, MPU_6050_PWR_MGMT_2);
-	if(check_err_mpu6050(err) != 0) return err;
+	if(status & (TWI_MASTER_ARBLOST_bm | TWI_MASTER_BUSERR_bm)){
+		twi->MASTER.STATUS = TWI_MASTER_ARBLOST_bm | TWI_MASTER_BUSERR_bm;
+		twi_async_done_mpu6050(slot, DATA_NOT_RECEIVED);
+		return;
+	}
 	
-	return 0;	
+	if( (status & TWI_MASTER_WIF_bm) && (status & TWI_MASTER_RXACK_bm) ){
+		twi->MASTER.CTRLC = TWI_MASTER_CMD_STOP_gc;
+		twi_async_done_mpu6050(slot, NACK);
+		return;
+	}
+	
+	switch(slot->state){
+		case ASYNC_ADDR_W:
+			twi->MASTER.DATA = slot->reg;
+			slot->state = ASYNC_REG;
+			break;
+			
+		case ASYNC_REG:
+			twi->MASTER.ADDR = (slot->addr << 1) | 0x01;	//!< Repeated start to read
+			slot->state = ASYNC_READ;
+			break;
+			
+		case ASYNC_READ:
+			slot->data[slot->index++] = twi->MASTER.DATA;
+			if(slot->index < slot->len){
+				twi->MASTER.CTRLC = TWI_MASTER_CMD_RECVTRANS_gc;	//!< ACK and read the next byte
+			}else{
+				twi->MASTER.CTRLC = TWI_MASTER_ACKACT_bm | TWI_MASTER_CMD_STOP_gc;	//!< NACK the last byte
+				twi_async_done_mpu6050(slot, TWI_STATUS_OK);
+			}
+			break;
+	}
 }
 
-/*! \brief  Turn off or on standby mode gyroscope x-axis
+/*! \brief  Finishes the asynchronous transaction of a TWI module
  *
- *  \param  *twi	pointer to the TWI module that is connected to the MPU6050
- *	\param	addr	address of the MPU6050
- *	\param	on_off	1 turn on standby 0 turn off standby
+ *	\note	This function is for internal use
  *
- *  \return 0 if successful error code from TWI if unsuccessful full
+ *  \param  *slot	pointer to the state of the TWI module
+ *  \param  status	status code of the TWI library
  */
-uint8_t stdby_gyro_x_mpu6050(TWI_t *twi, uint8_t addr, uint8_t on_off){
-	uint8_t err, buff;
-	MPU6050_PWR_MGMT_2_TYPE PWR_MGMT_2;
-	
-	err = read_8bit_register_TWI(twi, addr, &buff, MPU_6050_PWR_MGMT_2);
-	if(check_err_mpu6050(err) != 0) return err;
-	
-	PWR_MGMT_2.PWR_MGMT_2 = buff;
-	PWR_MGMT_2.STBY_XG = on_off;
-	buff = PWR_MGMT_2.PWR_MGMT_2;
+static void twi_async_done_mpu6050(mpu6050_twi_async_t *slot, uint8_t status){
+	mpu6050_done_t done = slot->done;
+	void *arg = slot->arg;
 	
-	err = write_8bit_register_TWI(twi, addr, buff, MPU_6050_PWR_MGMT_2);
-	if(check_err_mpu6050(err) != 0) return err;
+	slot->twi->MASTER.CTRLA &= ~(TWI_MASTER_RIEN_bm | TWI_MASTER_WIEN_bm);
+	slot->state = ASYNC_IDLE;	//!< done can start the next transaction
 	
-	return 0;	
+	done(arg, status);
 }
+#endif
 
-/*! \brief  Turn off or on standby mode gyroscope y-axis
+/*! \brief  Starts reading consecutive registers of the MPU6050 without waiting for the transaction
  *
- *  \param  *twi	pointer to the TWI module that is connected to the MPU6050
- *	\param	addr	address of the MPU6050
- *	\param	on_off	1 turn on standby 0 turn off standby
+ *	The transaction is handled by the read_async function of the transport. With init_mpu6050 that is the
+ *	TWI master interrupt, the application has to call twi_isr_async_mpu6050 from its ISR(TWIx_TWIM_vect) and 
+ *	enable low level interrupts. The simulated MPU6050 finishes the read in sim_isr_async_mpu6050.
+ *	When the transaction is finished callback is called from the interrupt, the result can
+ *	also be polled with async_status_mpu6050. Every TWI module runs one transaction at a time.
  *
- *  \return 0 if successful error code from TWI if unsuccessful full
+ *	\note data must stay valid until the transaction is finished.
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	reg		first register that needs to be read
+ *	\param	*data	pointer to store the register values
+ *	\param	len		amount of registers that need to be read
+ *	\param	callback	function that is called with the device and the status code of the TWI library, can be 0
+ *
+ *  \return 0 if the transaction is started, 1 if a transaction on the TWI module is still busy or the TWI/I2C bus is in use
  */
-uint8_t stdby_gyro_y_mpu6050(TWI_t *twi, uint8_t addr, uint8_t on_off){
-	uint8_t err, buff;
-	MPU6050_PWR_MGMT_2_TYPE PWR_MGMT_2;
+uint8_t read_async_mpu6050(mpu6050_dev_t *dev, uint8_t reg, uint8_t *data, uint16_t len, mpu6050_async_cb_t callback){
+	uint8_t err = BUS_IN_USE;
+	uint8_t status;
+#ifdef __AVR__
+	uint8_t sreg = SREG;
 	
-	err = read_8bit_register_TWI(twi, addr, &buff, MPU_6050_PWR_MGMT_2);
-	if(check_err_mpu6050(err) != 0) return err;
+	cli();	//!< The check and the claim of the device can not be split by the port interrupt
+#endif
 	
-	PWR_MGMT_2.PWR_MGMT_2 = buff;
-	PWR_MGMT_2.STBY_YG = on_off;
-	buff = PWR_MGMT_2.PWR_MGMT_2;
+	status = dev->async_status;
 	
-	err = write_8bit_register_TWI(twi, addr, buff, MPU_6050_PWR_MGMT_2);
-	if(check_err_mpu6050(err) != 0) return err;
+	if(dev->bus.read_async != 0 && len != 0 && status != MPU6050_ASYNC_BUSY){
+		dev->async_cb = callback;
+		dev->async_status = MPU6050_ASYNC_BUSY;
+		
+		err = dev->bus.read_async(dev->bus.ctx, dev->addr, reg, data, len, async_done_mpu6050, dev);
+		if(err != TWI_STATUS_OK) dev->async_status = status;
+	}
 	
-	return 0;	
+#ifdef __AVR__
+	SREG = sreg;
+#endif
+	
+	return (err == TWI_STATUS_OK) ? 0 : 1;
 }
 
-/*! \brief  Turn off or on standby mode gyroscope z-axis
+/*! \brief  Get the status of the last asynchronous transaction of an MPU6050
  *
- *  \param  *twi	pointer to the TWI module that is connected to the MPU6050
- *	\param	addr	address of the MPU6050
- *	\param	on_off	1 turn on standby 0 turn off standby
+ *  \param  *dev	pointer to the MPU6050 device
  *
- *  \return 0 if successful error code from TWI if unsuccessful full
+ *  \return MPU6050_ASYNC_BUSY while the transaction is busy, otherwise the status code of the TWI library
  */
-uint8_t stdby_gyro_z_mpu6050(TWI_t *twi, uint8_t addr, uint8_t on_off){
-	uint8_t err, buff;
-	MPU6050_PWR_MGMT_2_TYPE PWR_MGMT_2;
-	
-	err = read_8bit_register_TWI(twi, addr, &buff, MPU_6050_PWR_MGMT_2);
-	if(check_err_mpu6050(err) != 0) return err;
-	
-	PWR_MGMT_2.PWR_MGMT_2 = buff;
-	PWR_MGMT_2.STBY_ZG = on_off;
-	buff = PWR_MGMT_2.PWR_MGMT_2;
+uint8_t async_status_mpu6050(mpu6050_dev_t *dev){
+	return dev->async_status;
+}
+
+/*! \brief  Finishes the asynchronous transaction of an MPU6050
+ *
+ *	\note	This function is for internal use
+ *
+ *  \param  *arg	pointer to the MPU6050 device
+ *  \param  status	status code of the TWI library
+ */
+static void async_done_mpu6050(void *arg, uint8_t status){
+	mpu6050_dev_t *dev = (mpu6050_dev_t *) arg;
+	mpu6050_async_cb_t callback = dev->async_cb;
 	
-	err = write_8bit_register_TWI(twi, addr, buff, MPU_6050_PWR_MGMT_2);
-	if(check_err_mpu6050(err) != 0) return err;
+	dev->async_status = status;	//!< The callback can start the next transaction
 	
-	return 0;	
-}
\ No newline at end of file
+	if(callback != 0) callback(dev, status);
+}
+
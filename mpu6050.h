@@ -10,7 +10,7 @@
  *
  *	\note For the HvA-Xmegaboard you need to use TWIE!
  *
- *	\note This library <b>does not</b> support slave devices for the mpu6050!!! 
+ *	\note Slave devices are connected to the auxiliary I2C master of the MPU6050, see aux_master_enable_mpu6050.
  */
 
 /*!	\copyright
@@ -48,15 +48,27 @@
  *	\section section_2 how to use the MPU6050 library
  *	place the c and h files of the dependencies in the same folder as the c and h files of this library.<br>
  *	To start using this library you need to init a TWI module of the AtXmega device, this can be done with the TWI library.<br>
- *	After initializing the TWI module you need to enable the MPU6050.
+ *	After initializing the TWI module you need to initialize the device struct and enable the MPU6050.
  *	\subsection code_example example
  *	\code{.c}
- 	enable_mpu6050(&TWIx, addr);
+ 	mpu6050_dev_t mpu;
+ 	init_mpu6050(&mpu, &TWIx, addr);
+ 	enable_mpu6050(&mpu);
  	\endcode
  *	&TWIx = The TWI module address of the TWI module that needs to be used for the communication with the MPU6050.<br>
  *	addr  = The address of the MPU6050. If AD0 is connected to ground the address is: 0x68 (hexadecimal). 
  *	If AD0 is connected to VCC then the address of the MPU6050 will be: 0x69 (hexadecimal). 
  *
+ *	Every MPU6050 needs its own mpu6050_dev_t, all other functions take a pointer to it.
+ *
+ *	On other platforms the MPU6050 is connected with init_bus_mpu6050 and a mpu6050_bus_t transport.
+ *	mpu6050_sim.h has a simulated MPU6050 that can be used as transport to run the library on a PC.
+ *	The interrupt driven acquisition is only available on the Xmega, read_async_mpu6050 needs a transport
+ *	with read_async like the TWI module of the Xmega and the simulated MPU6050.
+ *
+ *	To skip the calibration at boot set store of the mpu6050_dev_t to a storage backend of mpu6050_store.h 
+ *	before enable_mpu6050 is called. The first boot saves the calibration, the next boots load it.
+ *
  *	after enabling the MPU6050 you can use the other functions to get acceleration, rotational velocity and temperature data.<br>
  *	With the MPU6050_ACCEL_SCL_x and the MPU6050_GYRO_SCL_x to select the precision of the measurements. The lower the precision
  *	the higher the values you can measure.
@@ -66,11 +78,26 @@
  *	
  */
 
-#include <avr/io.h>
+#include <stdint.h>
 #include <float.h>
 
+#ifdef __AVR__
+#include <avr/io.h>
+#include <avr/interrupt.h>
 
 #include "TWI.h"
+#else
+/*
+ *	Status codes of the TWI library, transports on other platforms return the same codes
+ */
+#define TWI_STATUS_OK		0
+#define BUS_IN_USE			1
+#define NACK				2
+#define DATA_NOT_SEND		3
+#define DATA_NOT_RECEIVED	4
+#endif
+
+#include "mpu6050_store.h"
 
 #ifndef MPU6050_H_
 #define MPU6050_H_
@@ -88,6 +115,23 @@
  *	\brief Register definitions
  */
 
+/*
+ *	Offset registers
+ */
+#define MPU_6050_XA_OFFS_H		0x06
+#define MPU_6050_XA_OFFS_L		0x07
+#define MPU_6050_YA_OFFS_H		0x08
+#define MPU_6050_YA_OFFS_L		0x09
+#define MPU_6050_ZA_OFFS_H		0x0A
+#define MPU_6050_ZA_OFFS_L		0x0B
+
+#define MPU_6050_XG_OFFS_USRH	0x13
+#define MPU_6050_XG_OFFS_USRL	0x14
+#define MPU_6050_YG_OFFS_USRH	0x15
+#define MPU_6050_YG_OFFS_USRL	0x16
+#define MPU_6050_ZG_OFFS_USRH	0x17
+#define MPU_6050_ZG_OFFS_USRL	0x18
+
 /*
  *	Self test registers
  */
@@ -106,6 +150,12 @@
 #define MPU_6050_GYRO_CONFIG	0x1B
 #define MPU_6050_ACCEL_CONFIG	0x1C
 
+/*
+ *	Motion detection registers of the MPU6050
+ */
+#define MPU_6050_MOT_THR		0x1F	//!< Motion threshold, 1 LSB is 2mg
+#define MPU_6050_MOT_DUR		0x20	//!< Motion duration, 1 LSB is 1ms
+
 /*
  *	Slave settings for slave devices for the MPU6050
  */
@@ -127,13 +177,13 @@
 #define MPU_6050_I2C_SLV3_ADDR	0x2E
 #define MPU_6050_I2C_SLV3_REG	0x2F
 #define MPU_6050_I2C_SLV3_DO	0x66
-#define MPU_6050_I2C_SLV3_CTRL	0x302
+#define MPU_6050_I2C_SLV3_CTRL	0x30
 
 #define MPU_6050_I2C_SLV4_ADDR	0x31
 #define MPU_6050_I2C_SLV4_REG	0x32
 #define MPU_6050_I2C_SLV4_DO	0x33
 #define MPU_6050_I2C_SLV4_CTRL	0x34
-#define MPU_6050_I2C_SLV4_DI	0x53
+#define MPU_6050_I2C_SLV4_DI	0x35
 
 
 /*
@@ -206,6 +256,7 @@
 
 
 #define MPU_6050_SIGNAL_PATH_RESET	0x68
+#define MPU_6050_MOT_DETECT_CTRL	0x69
 
 
 #define MPU_6050_USER_CTRL	0x6A
@@ -216,6 +267,15 @@
 #define MPU_6050_PWR_MGMT_1	0x6B
 #define MPU_6050_PWR_MGMT_2	0x6C
 
+/*
+ *	Digital Motion Processor memory registers
+ */
+#define MPU_6050_BANK_SEL		0x6D
+#define MPU_6050_MEM_START_ADDR	0x6E
+#define MPU_6050_MEM_R_W		0x6F
+#define MPU_6050_DMP_CFG_1		0x70	//!< Program start address high byte
+#define MPU_6050_DMP_CFG_2		0x71	//!< Program start address low byte
+
 /*
  *	FIFO registers of the MPU6050
  */
@@ -225,7 +285,7 @@
 #define MPU_6050_FIFO_R_W		0x74
 
 
-#define MPU_6050_WHO_AM_I	0x752
+#define MPU_6050_WHO_AM_I	0x75
 
 /*
  *	Bit locations in register
@@ -233,6 +293,7 @@
 #define DATA_RDY_INT_EN			0
 #define MPU_6050_I2C_MST_INT_EN	3
 #define MPU_6050_FIFO_INT_EN	4
+#define MPU_6050_MOT_INT_EN		6
 
 /*
  *	return values for what_happened_MPU6050
@@ -241,6 +302,127 @@
 #define MPU_6050_I2C_MST_INT	4
 #define MPU_6050_FIFO_INT		5
 
+/*
+ *	Bit locations in MPU_6050_INT_STATUS, returned by int_status_mpu6050
+ */
+#define MPU6050_INT_DATA_RDY_bm		(1 << 0)	//!< New sample in the data registers
+#define MPU6050_INT_I2C_MST_bm		(1 << 3)	//!< Interrupt of the auxiliary I2C master
+#define MPU6050_INT_FIFO_OFLOW_bm	(1 << 4)	//!< The FIFO overflowed
+#define MPU6050_INT_MOT_bm			(1 << 6)	//!< Motion detected
+
+/*
+ *	Bit locations in MPU_6050_FIFO_EN
+ */
+#define MPU6050_FIFO_TEMP_bm	(1 << 7)	//!< Temperature in the FIFO
+#define MPU6050_FIFO_XG_bm		(1 << 6)	//!< Gyroscope x-axis in the FIFO
+#define MPU6050_FIFO_YG_bm		(1 << 5)	//!< Gyroscope y-axis in the FIFO
+#define MPU6050_FIFO_ZG_bm		(1 << 4)	//!< Gyroscope z-axis in the FIFO
+#define MPU6050_FIFO_ACCEL_bm	(1 << 3)	//!< Accelerometer x, y and z-axis in the FIFO
+#define MPU6050_FIFO_GYRO_bm	(MPU6050_FIFO_XG_bm | MPU6050_FIFO_YG_bm | MPU6050_FIFO_ZG_bm)
+
+#define MPU6050_FIFO_SIZE		1024	//!< Size of the FIFO in bytes
+
+/*
+ *	Bit locations in MPU_6050_USER_CTRL
+ */
+#define MPU6050_USER_DMP_EN_bm			(1 << 7)	//!< Enables the Digital Motion Processor
+#define MPU6050_USER_FIFO_EN_bm			(1 << 6)	//!< Enables the FIFO
+#define MPU6050_USER_I2C_MST_EN_bm		(1 << 5)	//!< Enables the auxiliary I2C master
+#define MPU6050_USER_DMP_RESET_bm		(1 << 3)	//!< Resets the Digital Motion Processor, clears itself
+#define MPU6050_USER_FIFO_RESET_bm		(1 << 2)	//!< Resets the FIFO, clears itself
+#define MPU6050_USER_I2C_MST_RESET_bm	(1 << 1)	//!< Resets the auxiliary I2C master, clears itself
+
+/*
+ *	Bit locations in MPU_6050_I2C_MST_CTRL
+ */
+#define MPU6050_MST_WAIT_FOR_ES_bm		(1 << 6)	//!< Data ready waits until the external sensor data is loaded
+#define MPU6050_MST_P_NSR_bm			(1 << 4)	//!< Stop instead of a restart between the slave reads
+#define MPU6050_MST_CLK_gm				0x0F		//!< Clock of the auxiliary I2C bus
+
+/*
+ *	Clock of the auxiliary I2C bus, value of MPU6050_MST_CLK_gm
+ */
+#define MPU6050_AUX_CLK_258KHZ	8
+#define MPU6050_AUX_CLK_348KHZ	0
+#define MPU6050_AUX_CLK_400KHZ	13
+
+/*
+ *	Bit locations in MPU_6050_I2C_SLVx_ADDR and MPU_6050_I2C_SLVx_CTRL
+ */
+#define MPU6050_SLV_READ_bm		(1 << 7)	//!< In MPU_6050_I2C_SLVx_ADDR, the slave is read instead of written
+#define MPU6050_SLV_EN_bm		(1 << 7)	//!< In MPU_6050_I2C_SLVx_CTRL, the slave is accessed every sample
+#define MPU6050_SLV_LEN_gm		0x0F		//!< In MPU_6050_I2C_SLVx_CTRL, amount of bytes that are read
+
+/*
+ *	Bit locations in MPU_6050_I2C_MST_DELAY_CTRL and MPU_6050_I2C_SLV4_CTRL
+ */
+#define MPU6050_MST_DELAY_ES_SHADOW_bm	(1 << 7)	//!< The external sensor data is updated when all slaves are read
+#define MPU6050_MST_DLY_gm				0x1F		//!< In MPU_6050_I2C_SLV4_CTRL, delayed slaves are accessed every 1 + n samples
+
+#define MPU6050_AUX_SLAVES		4	//!< Slaves that can be read into the external sensor data registers
+#define MPU6050_EXT_SENS_BYTES	24	//!< Amount of external sensor data registers
+
+/*
+ *	Calibration settings
+ */
+#ifndef MPU6050_CAL_SAMPLES
+#define MPU6050_CAL_SAMPLES		1000	//!< Maximum amount of samples enable_mpu6050 uses for the calibration
+#endif
+#ifndef MPU6050_CAL_TOLERANCE
+#define MPU6050_CAL_TOLERANCE	2		//!< Standard error of the mean in LSB at which the calibration stops
+#endif
+#define MPU6050_CAL_MIN_SAMPLES	64		//!< Minimum amount of samples and the interval of the convergence check
+#define MPU6050_CAL_READY_POLLS	1000	//!< Maximum reads of INT_STATUS while the calibration waits for one sample
+#define MPU6050_ACCEL_1G_RAW	16384	//!< Raw value of 1G in the +-2G range
+
+/*
+ *	Calibration record
+ */
+#define MPU6050_CALIB_MAGIC		0x6050
+#define MPU6050_CALIB_VERSION	2
+#define MPU6050_CALIB_BYTES		70	//!< Size of a serialized calibration record
+
+/*
+ *	Amount of configuration registers that have a copy in mpu6050_dev_t
+ */
+#define MPU6050_SHADOW_REGS		12
+
+/*
+ *	Retry policy that init_bus_mpu6050 sets, change retry of the device struct for another policy
+ */
+#ifndef MPU6050_RETRY_ATTEMPTS
+#define MPU6050_RETRY_ATTEMPTS		3		//!< Tries of one transaction
+#endif
+#ifndef MPU6050_RETRY_RECOVER
+#define MPU6050_RETRY_RECOVER		2		//!< Failed tries after which the bus is recovered
+#endif
+#ifndef MPU6050_RETRY_BACKOFF_US
+#define MPU6050_RETRY_BACKOFF_US	50		//!< Wait before the first retry in us
+#endif
+#ifndef MPU6050_RETRY_BACKOFF_MAX_US
+#define MPU6050_RETRY_BACKOFF_MAX_US	1000	//!< Maximum wait between two tries in us
+#endif
+#ifndef MPU6050_RETRY_DEADLINE_US
+#define MPU6050_RETRY_DEADLINE_US	5000	//!< Maximum time of one transaction in us
+#endif
+
+/*
+ *	Times the status of the TWI module is polled for one byte before the transaction is given up. Before the register
+ *	pointer is acknowledged this is BUS_IN_USE, so a slave that holds SCL low ends in the retry and recovery of the bus,
+ *	afterwards DATA_NOT_RECEIVED or DATA_NOT_SEND because data can already be transferred. At 32 MHz this is a few ms.
+ */
+#ifndef MPU6050_TWI_WAIT_LOOPS
+#define MPU6050_TWI_WAIT_LOOPS		20000
+#endif
+
+/*
+ *	Amount of frames in the ring buffer of the interrupt driven acquisition, needs to be a power of 2.
+ *	One slot is always kept free.
+ */
+#ifndef MPU6050_RING_SIZE
+#define MPU6050_RING_SIZE		16
+#endif
+
 /*
  *	CLK selection value
  */
@@ -252,6 +434,19 @@
 #define MPU6050_TWI_ERROR	1
 #define MPU6050_TWI_OK		0
 
+#define MPU6050_FIFO_OVERFLOW	50	//!< The FIFO was full and has been reset
+
+#define MPU6050_ASYNC_BUSY		0xFF	//!< The asynchronous transaction is not finished yet
+
+#define MPU6050_CALIB_INVALID	60		//!< There is no valid calibration record
+
+#define MPU6050_DMP_VERIFY		70		//!< The memory of the Digital Motion Processor does not match the image
+
+#define MPU6050_LOG_INVALID		80		//!< A log block is damaged or is not a log block
+#define MPU6050_LOG_FULL		81		//!< A valid log block has more frames than fit in frames
+
+#define MPU6050_STREAM_FULL		90		//!< Both stream buffers are in use, the frame is dropped
+
 #define MPU6050_ACCEL_SCL_2G	0	//!< +-2G Max measurement
 #define MPU6050_ACCEL_SCL_4G	1	//!< +-4G Max measurement
 #define MPU6050_ACCEL_SCL_8G	2	//!< +-8G Max measurement
@@ -262,17 +457,41 @@
 #define MPU6050_GYRO_SCL_1000	2	//!< +-1000 degrees per second Max measurement 
 #define MPU6050_GYRO_SCL_2000	3	//!< +-2000 degrees per second Max measurement 
 
-#define ON 1
-#define OFF 0 
+/*
+ *	Bandwidth of the digital low pass filter, accelerometer / gyroscope
+ */
+#define MPU6050_DLPF_260		0	//!< 260Hz / 256Hz, gyroscope output rate 8kHz
+#define MPU6050_DLPF_184		1	//!< 184Hz / 188Hz, gyroscope output rate 1kHz
+#define MPU6050_DLPF_94			2	//!< 94Hz / 98Hz, gyroscope output rate 1kHz
+#define MPU6050_DLPF_44			3	//!< 44Hz / 42Hz, gyroscope output rate 1kHz
+#define MPU6050_DLPF_21			4	//!< 21Hz / 20Hz, gyroscope output rate 1kHz
+#define MPU6050_DLPF_10			5	//!< 10Hz / 10Hz, gyroscope output rate 1kHz
+#define MPU6050_DLPF_5			6	//!< 5Hz / 5Hz, gyroscope output rate 1kHz
 
+#define MPU6050_MOTION_BYTES	14	//!< Bytes from MPU_6050_ACCEL_XOUT_H up to MPU_6050_GYRO_ZOUT_L
+#define MPU6050_ACCEL_BYTES		6	//!< Bytes from MPU_6050_ACCEL_XOUT_H up to MPU_6050_ACCEL_ZOUT_L
 
-float ACCELX_OFFSET_MPU6050[4];	//!< The sensor offset value for all sensitivities  
-float ACCELY_OFFSET_MPU6050[4];	//!< The sensor offset value for all sensitivities
-float ACCELZ_OFFSET_MPU6050[4];	//!< The sensor offset value for all sensitivities
+/*
+ *	Digital high pass filter of the accelerometer, only used by the motion detection
+ */
+#define MPU6050_HPF_RESET		0	//!< Filter off
+#define MPU6050_HPF_5HZ			1	//!< 5Hz cut off
+#define MPU6050_HPF_2_5HZ		2	//!< 2.5Hz cut off
+#define MPU6050_HPF_1_25HZ		3	//!< 1.25Hz cut off
+#define MPU6050_HPF_0_63HZ		4	//!< 0.63Hz cut off
+#define MPU6050_HPF_HOLD		7	//!< Compares to the sample that was taken when the filter was set to hold
+
+/*
+ *	Wake up rate of the low power accelerometer mode
+ */
+#define MPU6050_LP_WAKE_1_25HZ	0	//!< 1.25Hz
+#define MPU6050_LP_WAKE_5HZ		1	//!< 5Hz
+#define MPU6050_LP_WAKE_20HZ	2	//!< 20Hz
+#define MPU6050_LP_WAKE_40HZ	3	//!< 40Hz
+
+#define ON 1
+#define OFF 0 
 
-float GYROX_OFFSET_MPU6050[4];	//!< The sensor offset value for all sensitivities
-float GYROY_OFFSET_MPU6050[4];	//!< The sensor offset value for all sensitivities
-float GYROZ_OFFSET_MPU6050[4];	//!< The sensor offset value for all sensitivities
 
 /*! \brief  Union to store 16bits sensor values 
  *
@@ -297,76 +516,302 @@ typedef union {
 	int16_t TEMP;
 } TEMP16_t;
 
+/*! \brief  Struct to store one raw sample of all motion axes
+ *
+ *	The values are read in one burst from MPU_6050_ACCEL_XOUT_H up to MPU_6050_GYRO_ZOUT_L.
+ *	Index 0, 1 and 2 of accel and gyro are the x, y and z axis.
+ */
+typedef struct {
+	int16_t accel[3];	//!< Raw accelerometer values
+	int16_t temp;		//!< Raw temperature value
+	int16_t gyro[3];	//!< Raw gyroscope values
+	uint32_t time_us;	//!< Value of clock_us of the device when the sample was taken, 0 without clock
+} mpu6050_motion_t;
+
+/*! \brief  Struct to store one sample of all motion axes in fixed point
+ */
+typedef struct {
+	int32_t accel[3];	//!< Acceleration in milli-g
+	int32_t temp;		//!< Temperature in milli-degrees Celsius
+	int32_t gyro[3];	//!< Rotational velocity in milli-degrees per second
+	uint32_t time_us;	//!< Value of clock_us of the device when the sample was taken, 0 without clock
+} mpu6050_motion_fixed_t;
+
+/*! \brief  Function that a transport calls when an asynchronous read is finished
+ *
+ *	arg is the value that was given to read_async, status is a status code of the TWI library.
+ */
+typedef void (*mpu6050_done_t)(void *arg, uint8_t status);
 
-uint8_t enable_mpu6050(TWI_t *twi, uint8_t addr);
-uint8_t disable_mpu6050(TWI_t *twi, uint8_t addr);
-
-uint8_t wake_up_mpu6050(TWI_t *twi, uint8_t addr);
-uint8_t sleep_mpu6050(TWI_t *twi, uint8_t addr);
-
-uint8_t get_accel_x_raw_mpu6050(TWI_t *twi, uint8_t addr, int16_t *data);
-uint8_t get_accel_y_raw_mpu6050(TWI_t *twi, uint8_t addr, int16_t *data);
-uint8_t get_accel_z_raw_mpu6050(TWI_t *twi, uint8_t addr, int16_t *data);
-
-uint8_t get_gyro_x_raw_mpu6050(TWI_t *twi, uint8_t addr, int16_t *data);
-uint8_t get_gyro_y_raw_mpu6050(TWI_t *twi, uint8_t addr, int16_t *data);
-uint8_t get_gyro_z_raw_mpu6050(TWI_t *twi, uint8_t addr, int16_t *data);
-
-uint8_t get_accel_x_mpu6050(TWI_t *twi, uint8_t addr, float *data);
-uint8_t get_accel_y_mpu6050(TWI_t *twi, uint8_t addr, float *data);
-uint8_t get_accel_z_mpu6050(TWI_t *twi, uint8_t addr, float *data);
-
-uint8_t get_gyro_x_mpu6050(TWI_t *twi, uint8_t addr, float *data);
-uint8_t get_gyro_y_mpu6050(TWI_t *twi, uint8_t addr, float *data);
-uint8_t get_gyro_z_mpu6050(TWI_t *twi, uint8_t addr, float *data);
-
-uint8_t get_temp_mpu6050(TWI_t *twi, uint8_t addr, float *data);
-
-uint8_t int_enable_mpu6050(TWI_t *twi, uint8_t addr, uint8_t interupt);
-uint8_t int_disable_mpu6050(TWI_t *twi, uint8_t addr, uint8_t interupt);
-uint8_t what_happend_mpu6050(TWI_t *twi, uint8_t addr);
-
-uint8_t ext_sens_value_mpu6050(TWI_t *twi, uint8_t addr, uint8_t reg, uint8_t *data);
-
-uint8_t disable_temp_mpu6050(TWI_t *twi, uint8_t addr);
-uint8_t enable_temp_mpu6050(TWI_t *twi, uint8_t addr);
-
-uint8_t reset_mpu6050(TWI_t *twi, uint8_t addr);
-uint8_t reset_accel_mpu6050(TWI_t *twi, uint8_t addr);
-uint8_t reset_gyro_mpu6050(TWI_t *twi, uint8_t addr);
-uint8_t reset_temp_mpu6050(TWI_t *twi, uint8_t addr);
-
-uint8_t clk_sel_mpu6050(TWI_t *twi, uint8_t addr, uint8_t clk_sel);
+/*! \brief  Transport that is used to communicate with the MPU6050
+ *
+ *	The functions get the 7 bit address of the MPU6050 and the first register, the register pointer
+ *	increments after every byte like on the MPU6050. They return a status code of the TWI library.
+ *	read_async only starts the read and returns BUS_IN_USE if the transport is busy, done is called when the read
+ *	is finished. read and write return BUS_IN_USE while an asynchronous read is busy.
+ *	init_mpu6050 uses the TWI module of the Xmega, init_bus_mpu6050 can be used with any transport,
+ *	for example the simulated MPU6050 of mpu6050_sim.h.
+ */
+typedef struct {
+	uint8_t (*read)(void *ctx, uint8_t addr, uint8_t reg, uint8_t *data, uint16_t len);			//!< Reads len registers from reg
+	uint8_t (*write)(void *ctx, uint8_t addr, uint8_t reg, const uint8_t *data, uint16_t len);	//!< Writes len registers from reg
+	void *ctx;	//!< Passed to read and write, the meaning depends on the transport
+	uint8_t (*recover)(void *ctx);	//!< Frees a stuck bus and reinitializes the interface, can be 0
+	uint8_t (*read_async)(void *ctx, uint8_t addr, uint8_t reg, uint8_t *data, uint16_t len, mpu6050_done_t done, void *arg);	//!< Starts reading len registers from reg, can be 0
+} mpu6050_bus_t;
+
+/*! \brief  Retry policy of the transactions of one MPU6050
+ *
+ *	A failed transaction is tried again after a wait that doubles after every try. The waits and the deadline
+ *	need clock_us of the device struct, without a clock the tries follow each other directly and there is no deadline.
+ *	Reads of registers that change when they are read (FIFO_R_W, MEM_R_W and INT_STATUS) and writes of
+ *	FIFO_R_W and MEM_R_W are only tried again when no data was transferred.
+ */
+typedef struct {
+	uint8_t attempts;			//!< Maximum amount of tries of one transaction, 1 disables retrying
+	uint8_t recover_after;		//!< Failed tries after which recover_bus_mpu6050 is called, 0 to never recover
+	uint16_t backoff_us;		//!< Wait before the first retry
+	uint16_t backoff_max_us;	//!< Maximum wait between two tries
+	uint32_t deadline_us;		//!< Maximum time of one transaction including all tries, 0 for no deadline
+} mpu6050_retry_t;
+
+#ifdef MPU6050_STATS
+/*! \brief  Counters of the communication with one MPU6050
+ *
+ *	Only available when MPU6050_STATS is defined. The latency is measured with clock_us of the device struct,
+ *	the latency fields stay 0 when clock_us is 0. Read the counters with stats_snapshot_mpu6050.
+ */
+typedef struct {
+	uint32_t transactions;	//!< Amount of transactions
+	uint32_t bytes;			//!< Amount of register bytes that are read or written
+	uint16_t nacks;			//!< Transactions that were not acknowledged by the MPU6050
+	uint16_t bus_busy;		//!< Transactions that could not start because the TWI/I2C bus was in use
+	uint16_t not_received;	//!< Transactions that failed while receiving
+	uint16_t not_sent;		//!< Transactions that failed while sending
+	uint16_t retries;		//!< Transactions that were tried again
+	uint16_t recoveries;	//!< Calls of recover_bus_mpu6050
+	uint32_t timed;			//!< Amount of transactions with a latency measurement
+	uint32_t latency_min;	//!< Shortest transaction in us
+	uint32_t latency_max;	//!< Longest transaction in us
+	uint32_t latency_sum;	//!< Sum of all latency measurements in us
+	uint32_t latency_avg;	//!< Average transaction in us, only calculated by stats_snapshot_mpu6050
+} mpu6050_stats_t;
+#endif
+
+#ifdef __AVR__
+/*! \brief  Ring buffer of the interrupt driven acquisition
+ *
+ *	Only acq_isr_mpu6050 writes head and only acq_pop_mpu6050 writes tail.
+ *	Both are 8 bits wide so they are read and written atomically on the Xmega.
+ */
+typedef struct {
+	PORT_t *port;		//!< Port that the INT pin is connected to
+	uint8_t pin;		//!< Pin that the INT pin is connected to
+	volatile uint8_t head;
+	volatile uint8_t tail;
+	volatile uint16_t dropped;
+	uint8_t len;		//!< Amount of bytes of the read that is busy
+	uint32_t stamp;		//!< Value of clock_us at the DATA_RDY interrupt of the read that is busy
+	uint8_t raw[MPU6050_MOTION_BYTES];
+	mpu6050_motion_t frame[MPU6050_RING_SIZE];
+} mpu6050_acq_t;
+#endif
+
+struct mpu6050_dev_s;
+
+/*! \brief  Function that is called when an asynchronous transaction is finished
+ *
+ *	The function is called from the TWI master interrupt with the device and the status code of the TWI library.
+ */
+typedef void (*mpu6050_async_cb_t)(struct mpu6050_dev_s *dev, uint8_t status);
 
-uint8_t self_test_x_mpu6050(TWI_t *twi, uint8_t addr);
-uint8_t self_test_y_mpu6050(TWI_t *twi, uint8_t addr);
-uint8_t self_test_z_mpu6050(TWI_t *twi, uint8_t addr);
-uint8_t self_test_a_mpu6050(TWI_t *twi, uint8_t addr, uint8_t xyz);
+/*! \brief  Struct that holds everything the library needs to know about one MPU6050
+ *
+ *	Initialize it with init_mpu6050. Every MPU6050 needs its own struct, so two MPU6050s on the 
+ *	same TWI module (0x68 and 0x69) or on different TWI modules do not share their scale and offsets.
+ *	Use init_bus_mpu6050 for an MPU6050 that is not connected to a TWI module of the Xmega.
+ */
+typedef struct mpu6050_dev_s {
+	mpu6050_bus_t bus;			//!< Transport that is connected to the MPU6050
+#ifdef __AVR__
+	TWI_t *twi;					//!< TWI module that is connected to the MPU6050, 0 for other transports
+#endif
+	uint8_t addr;				//!< Address of the MPU6050
+	uint8_t accel_state;		//!< Selected accelerometer scale/range
+	uint8_t gyro_state;			//!< Selected gyroscope scale/range
+	int16_t accel_offset[3][4];	//!< The raw sensor offset value of the x, y and z-axis for all sensitivities
+	int16_t gyro_offset[3][4];	//!< The raw sensor offset value of the x, y and z-axis for all sensitivities
+	int16_t cal_temp;			//!< Raw temperature during the calibration
+	const mpu6050_store_t *store;	//!< Storage for the calibration record, 0 if the calibration is not stored
+	uint8_t hw_offsets;			//!< 1 if enable_mpu6050 programs the offsets into the offset registers of the MPU6050
+	int16_t hw_accel[3];		//!< Accelerometer offset registers that are programmed by hw_offsets_program_mpu6050
+	int16_t hw_gyro[3];			//!< Gyroscope offset registers that are programmed by hw_offsets_program_mpu6050
+	uint8_t hw_valid;			//!< 1 if hw_accel and hw_gyro are programmed into the MPU6050 and belong to the offsets
+	uint8_t fifo_sensors;		//!< Sensors that are written to the FIFO
+	uint16_t fifo_watermark;	//!< Minimum amount of frames fifo_drain_mpu6050 reads
+	uint32_t fifo_time_us;		//!< Time stamp of the last frame that was read from the FIFO
+	uint8_t fifo_time_valid;	//!< 1 if fifo_time_us belongs to the frame before the oldest frame in the FIFO
+	uint8_t dmp_features;		//!< MPU6050_DMP_xxx_bm outputs in a FIFO packet of the Digital Motion Processor, 0 if it is not running
+	uint8_t shadow[MPU6050_SHADOW_REGS];	//!< Copy of the writable configuration registers
+	uint32_t (*clock_us)(void);	//!< Free running clock in us for the time stamps, the retry policy and the latency counters, for example a timer of the Xmega, can be 0
+	mpu6050_retry_t retry;		//!< Retry policy of the transactions
+	uint8_t recovering;			//!< 1 while recover_bus_mpu6050 restores the configuration registers
+#ifdef MPU6050_STATS
+	mpu6050_stats_t stats;		//!< Counters of the communication
+#endif
+	mpu6050_async_cb_t async_cb;	//!< Callback of the asynchronous transaction
+	volatile uint8_t async_status;	//!< Status of the last asynchronous transaction, see async_status_mpu6050
+#ifdef __AVR__
+	mpu6050_acq_t acq;			//!< Interrupt driven acquisition
+#endif
+} mpu6050_dev_t;
+
+
+#ifdef __AVR__
+void init_mpu6050(mpu6050_dev_t *dev, TWI_t *twi, uint8_t addr);
+#endif
+void init_bus_mpu6050(mpu6050_dev_t *dev, const mpu6050_bus_t *bus, uint8_t addr);
+uint8_t enable_mpu6050(mpu6050_dev_t *dev);
+uint8_t disable_mpu6050(mpu6050_dev_t *dev);
+
+uint8_t wake_up_mpu6050(mpu6050_dev_t *dev);
+uint8_t sleep_mpu6050(mpu6050_dev_t *dev);
+uint8_t lp_accel_mode_mpu6050(mpu6050_dev_t *dev, uint8_t rate);
+uint8_t lp_accel_exit_mpu6050(mpu6050_dev_t *dev);
+
+uint8_t get_accel_x_raw_mpu6050(mpu6050_dev_t *dev, int16_t *data);
+uint8_t get_accel_y_raw_mpu6050(mpu6050_dev_t *dev, int16_t *data);
+uint8_t get_accel_z_raw_mpu6050(mpu6050_dev_t *dev, int16_t *data);
+
+uint8_t get_gyro_x_raw_mpu6050(mpu6050_dev_t *dev, int16_t *data);
+uint8_t get_gyro_y_raw_mpu6050(mpu6050_dev_t *dev, int16_t *data);
+uint8_t get_gyro_z_raw_mpu6050(mpu6050_dev_t *dev, int16_t *data);
+
+uint8_t get_motion6_raw_mpu6050(mpu6050_dev_t *dev, mpu6050_motion_t *data);
+uint8_t get_motion7_raw_mpu6050(mpu6050_dev_t *dev, mpu6050_motion_t *data);
+uint8_t get_motion_ext_raw_mpu6050(mpu6050_dev_t *dev, mpu6050_motion_t *data, uint8_t *ext, uint8_t len);
+uint8_t get_accel_raw_mpu6050(mpu6050_dev_t *dev, int16_t *data);
+
+uint8_t get_accel_x_mpu6050(mpu6050_dev_t *dev, float *data);
+uint8_t get_accel_y_mpu6050(mpu6050_dev_t *dev, float *data);
+uint8_t get_accel_z_mpu6050(mpu6050_dev_t *dev, float *data);
+
+uint8_t get_gyro_x_mpu6050(mpu6050_dev_t *dev, float *data);
+uint8_t get_gyro_y_mpu6050(mpu6050_dev_t *dev, float *data);
+uint8_t get_gyro_z_mpu6050(mpu6050_dev_t *dev, float *data);
+
+uint8_t get_temp_mpu6050(mpu6050_dev_t *dev, float *data);
+
+int32_t accel_raw_to_mg_mpu6050(int16_t raw, uint8_t range);
+int32_t gyro_raw_to_mdps_mpu6050(int16_t raw, uint8_t range);
+int32_t temp_raw_to_mdegc_mpu6050(int16_t raw);
+void motion_to_fixed_mpu6050(mpu6050_dev_t *dev, const mpu6050_motion_t *raw, mpu6050_motion_fixed_t *data);
+uint8_t get_motion_fixed_mpu6050(mpu6050_dev_t *dev, mpu6050_motion_fixed_t *data);
+
+uint8_t int_enable_mpu6050(mpu6050_dev_t *dev, uint8_t interupt);
+uint8_t int_disable_mpu6050(mpu6050_dev_t *dev, uint8_t interupt);
+uint8_t what_happend_mpu6050(mpu6050_dev_t *dev);
+uint8_t int_status_mpu6050(mpu6050_dev_t *dev, uint8_t *status);
+
+uint8_t motion_set_mpu6050(mpu6050_dev_t *dev, uint16_t threshold_mg, uint8_t duration_ms);
+uint8_t motion_idle_mpu6050(mpu6050_dev_t *dev, uint16_t threshold_mg, uint8_t duration_ms, uint8_t rate);
+uint8_t motion_event_mpu6050(mpu6050_dev_t *dev, uint8_t *status);
+
+uint8_t aux_master_enable_mpu6050(mpu6050_dev_t *dev, uint8_t clock);
+uint8_t aux_master_disable_mpu6050(mpu6050_dev_t *dev);
+uint8_t aux_slave_read_mpu6050(mpu6050_dev_t *dev, uint8_t slave, uint8_t addr, uint8_t reg, uint8_t len);
+uint8_t aux_slave_write_mpu6050(mpu6050_dev_t *dev, uint8_t slave, uint8_t addr, uint8_t reg, uint8_t data);
+uint8_t aux_slave_disable_mpu6050(mpu6050_dev_t *dev, uint8_t slave);
+uint8_t aux_set_rate_mpu6050(mpu6050_dev_t *dev, uint8_t slaves, uint8_t divider);
+uint8_t ext_sens_value_mpu6050(mpu6050_dev_t *dev, uint8_t reg, uint8_t *data);
+uint8_t ext_sens_read_mpu6050(mpu6050_dev_t *dev, uint8_t offset, uint8_t *buff, uint8_t len);
+
+uint8_t disable_temp_mpu6050(mpu6050_dev_t *dev);
+uint8_t enable_temp_mpu6050(mpu6050_dev_t *dev);
+
+uint8_t reset_mpu6050(mpu6050_dev_t *dev);
+uint8_t resync_mpu6050(mpu6050_dev_t *dev);
+uint8_t reset_accel_mpu6050(mpu6050_dev_t *dev);
+uint8_t reset_gyro_mpu6050(mpu6050_dev_t *dev);
+uint8_t reset_temp_mpu6050(mpu6050_dev_t *dev);
+
+uint8_t clk_sel_mpu6050(mpu6050_dev_t *dev, uint8_t clk_sel);
+
+uint8_t set_dlpf_mpu6050(mpu6050_dev_t *dev, uint8_t bw);
+uint8_t set_sample_rate_mpu6050(mpu6050_dev_t *dev, uint16_t hz);
+uint8_t get_sample_rate_mpu6050(mpu6050_dev_t *dev, uint16_t *hz);
+uint32_t get_sample_period_mpu6050(mpu6050_dev_t *dev);
+uint8_t data_ready_mpu6050(mpu6050_dev_t *dev, uint8_t *ready);
+
+uint8_t self_test_x_mpu6050(mpu6050_dev_t *dev);
+uint8_t self_test_y_mpu6050(mpu6050_dev_t *dev);
+uint8_t self_test_z_mpu6050(mpu6050_dev_t *dev);
+uint8_t self_test_a_mpu6050(mpu6050_dev_t *dev, uint8_t xyz);
 
 uint8_t check_err_mpu6050(uint8_t err);
-
-uint8_t accel_set_scale_mpu6050(TWI_t *twi, uint8_t addr, uint8_t scale);
-uint8_t accel_get_scale_mpu6050(TWI_t *twi, uint8_t addr, uint8_t *scale);
-uint8_t gyro_set_scale_mpu6050(TWI_t *twi, uint8_t addr, uint8_t scale);
-uint8_t gyro_get_scale_mpu6050(TWI_t *twi, uint8_t addr, uint8_t *scale);
-uint8_t temp_set_scale_mpu6050(TWI_t *twi, uint8_t addr, uint8_t scale);
-uint8_t temp_get_scale_mpu6050(TWI_t *twi, uint8_t addr, uint8_t *scale);
-
-uint8_t calibrate_gyro_x_mpu6050(TWI_t *twi, uint8_t addr);
-uint8_t calibrate_gyro_y_mpu6050(TWI_t *twi, uint8_t addr);
-uint8_t calibrate_gyro_z_mpu6050(TWI_t *twi, uint8_t addr);
-uint8_t calibrate_accel_x_mpu6050(TWI_t *twi, uint8_t addr);
-uint8_t calibrate_accel_y_mpu6050(TWI_t *twi, uint8_t addr);
-uint8_t calibrate_accel_z_mpu6050(TWI_t *twi, uint8_t addr);
-
-uint8_t stdby_all_mpu6050(TWI_t *twi, uint8_t addr, uint8_t on_off); 
-
-uint8_t stdby_accel_x_mpu6050(TWI_t *twi, uint8_t addr, uint8_t on_off);
-uint8_t stdby_accel_y_mpu6050(TWI_t *twi, uint8_t addr, uint8_t on_off);
-uint8_t stdby_accel_z_mpu6050(TWI_t *twi, uint8_t addr, uint8_t on_off);
-
-uint8_t stdby_gyro_x_mpu6050(TWI_t *twi, uint8_t addr, uint8_t on_off);
-uint8_t stdby_gyro_y_mpu6050(TWI_t *twi, uint8_t addr, uint8_t on_off);
-uint8_t stdby_gyro_z_mpu6050(TWI_t *twi, uint8_t addr, uint8_t on_off);
+uint8_t read_burst_mpu6050(mpu6050_dev_t *dev, uint8_t reg, uint8_t *data, uint16_t len);
+uint8_t write_burst_mpu6050(mpu6050_dev_t *dev, uint8_t reg, const uint8_t *data, uint16_t len);
+uint8_t recover_bus_mpu6050(mpu6050_dev_t *dev);
+
+#ifdef MPU6050_STATS
+void stats_snapshot_mpu6050(mpu6050_dev_t *dev, mpu6050_stats_t *stats);
+void stats_clear_mpu6050(mpu6050_dev_t *dev);
+#endif
+
+uint8_t accel_set_scale_mpu6050(mpu6050_dev_t *dev, uint8_t scale);
+uint8_t accel_get_scale_mpu6050(mpu6050_dev_t *dev, uint8_t *scale);
+uint8_t gyro_set_scale_mpu6050(mpu6050_dev_t *dev, uint8_t scale);
+uint8_t gyro_get_scale_mpu6050(mpu6050_dev_t *dev, uint8_t *scale);
+uint8_t temp_set_scale_mpu6050(mpu6050_dev_t *dev, uint8_t scale);
+uint8_t temp_get_scale_mpu6050(mpu6050_dev_t *dev, uint8_t *scale);
+
+uint8_t calibrate_mpu6050(mpu6050_dev_t *dev, uint16_t samples);
+void calib_serialize_mpu6050(mpu6050_dev_t *dev, uint8_t *buff);
+uint8_t calib_deserialize_mpu6050(mpu6050_dev_t *dev, const uint8_t *buff);
+uint8_t calib_save_mpu6050(mpu6050_dev_t *dev);
+uint8_t calib_load_mpu6050(mpu6050_dev_t *dev);
+uint8_t hw_offsets_program_mpu6050(mpu6050_dev_t *dev);
+uint8_t hw_offsets_write_mpu6050(mpu6050_dev_t *dev);
+uint8_t hw_offsets_read_mpu6050(mpu6050_dev_t *dev, int16_t *accel, int16_t *gyro);
+uint8_t calibrate_gyro_x_mpu6050(mpu6050_dev_t *dev);
+uint8_t calibrate_gyro_y_mpu6050(mpu6050_dev_t *dev);
+uint8_t calibrate_gyro_z_mpu6050(mpu6050_dev_t *dev);
+uint8_t calibrate_accel_x_mpu6050(mpu6050_dev_t *dev);
+uint8_t calibrate_accel_y_mpu6050(mpu6050_dev_t *dev);
+uint8_t calibrate_accel_z_mpu6050(mpu6050_dev_t *dev);
+
+uint8_t stdby_all_mpu6050(mpu6050_dev_t *dev, uint8_t on_off); 
+
+uint8_t stdby_accel_x_mpu6050(mpu6050_dev_t *dev, uint8_t on_off);
+uint8_t stdby_accel_y_mpu6050(mpu6050_dev_t *dev, uint8_t on_off);
+uint8_t stdby_accel_z_mpu6050(mpu6050_dev_t *dev, uint8_t on_off);
+
+uint8_t stdby_gyro_x_mpu6050(mpu6050_dev_t *dev, uint8_t on_off);
+uint8_t stdby_gyro_y_mpu6050(mpu6050_dev_t *dev, uint8_t on_off);
+uint8_t stdby_gyro_z_mpu6050(mpu6050_dev_t *dev, uint8_t on_off);
+
+uint8_t fifo_enable_mpu6050(mpu6050_dev_t *dev, uint8_t sensors);
+uint8_t fifo_reset_mpu6050(mpu6050_dev_t *dev);
+void fifo_set_watermark_mpu6050(mpu6050_dev_t *dev, uint16_t frames);
+uint8_t fifo_frame_size_mpu6050(uint8_t sensors);
+uint8_t fifo_count_mpu6050(mpu6050_dev_t *dev, uint16_t *count);
+uint8_t fifo_drain_mpu6050(mpu6050_dev_t *dev, uint8_t *buff, uint16_t max_frames, uint16_t *frames);
+uint8_t fifo_drain_stamped_mpu6050(mpu6050_dev_t *dev, uint8_t *buff, uint32_t *stamps, uint16_t max_frames, uint16_t *frames);
+
+uint8_t dmp_enable_mpu6050(mpu6050_dev_t *dev, uint8_t features);
+uint8_t dmp_disable_mpu6050(mpu6050_dev_t *dev);
+
+#ifdef __AVR__
+uint8_t acq_start_mpu6050(mpu6050_dev_t *dev, PORT_t *port, uint8_t pin);
+uint8_t acq_stop_mpu6050(mpu6050_dev_t *dev);
+void acq_isr_mpu6050(mpu6050_dev_t *dev);
+uint8_t acq_pop_mpu6050(mpu6050_dev_t *dev, mpu6050_motion_t *frame);
+uint16_t acq_dropped_mpu6050(mpu6050_dev_t *dev);
+
+void twi_isr_async_mpu6050(TWI_t *twi);
+#endif
+
+uint8_t read_async_mpu6050(mpu6050_dev_t *dev, uint8_t reg, uint8_t *data, uint16_t len, mpu6050_async_cb_t callback);
+uint8_t async_status_mpu6050(mpu6050_dev_t *dev);
 
 #endif /* MPU6050_H_ */
\ No newline at end of file
@@ -0,0 +1,305 @@
+/*!
+ *  \file    mpu6050_dmp.c
+ *  \author  Tycho Jobsis
+ *  \date    04-04-2021
+ *  \version 0.1.0
+ *
+ *  \brief   Digital Motion Processor support for the MPU6050 library
+ *
+ *  \details The memory of the Digital Motion Processor is accessed with MPU_6050_BANK_SEL and MPU_6050_MEM_START_ADDR,
+ *			 followed by a burst on MPU_6050_MEM_R_W. A burst may not cross the end of a memory bank.
+ */
+
+/*!	\copyright
+ *
+ *	MIT License
+ *
+ *	Copyright (c) 2021 TychoJ
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#include <string.h>
+
+#ifdef __AVR__
+#include <avr/pgmspace.h>
+#endif
+
+#include "mpu6050_dmp.h"
+
+/*! \brief  Selects the memory bank and the start address of the next memory transaction
+ *
+ *	\note	This function is for internal use
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	addr	address in the memory of the Digital Motion Processor
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ */
+static uint8_t dmp_seek_mpu6050(mpu6050_dev_t *dev, uint16_t addr){
+	uint8_t err, buff[2];
+	
+	buff[0] = addr >> 8;	//!< MPU_6050_BANK_SEL
+	buff[1] = addr & 0xFF;	//!< MPU_6050_MEM_START_ADDR
+	
+	err = write_burst_mpu6050(dev, MPU_6050_BANK_SEL, buff, 2);
+	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	
+	return 0;
+}
+
+/*! \brief  Get the amount of bytes of the next memory transaction
+ *
+ *	\note	This function is for internal use
+ *
+ *  \param  addr	start address of the transaction
+ *	\param	len		amount of bytes that still need to be transferred
+ *
+ *  \return amount of bytes up to MPU6050_DMP_CHUNK_SIZE that do not cross the end of the memory bank
+ */
+static uint16_t dmp_chunk_mpu6050(uint16_t addr, uint16_t len){
+	uint16_t bank_left = MPU6050_DMP_BANK_SIZE - (addr & (MPU6050_DMP_BANK_SIZE - 1));
+	
+	if(len > MPU6050_DMP_CHUNK_SIZE) len = MPU6050_DMP_CHUNK_SIZE;
+	if(len > bank_left) len = bank_left;
+	
+	return len;
+}
+
+/*! \brief  Writes to the memory of the Digital Motion Processor
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	addr	address in the memory of the Digital Motion Processor
+ *	\param	*data	pointer to the bytes that need to be written
+ *	\param	len		amount of bytes that need to be written
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ */
+uint8_t dmp_write_mem_mpu6050(mpu6050_dev_t *dev, uint16_t addr, const uint8_t *data, uint16_t len){
+	uint8_t err;
+	uint16_t chunk;
+	
+	while(len > 0){
+		chunk = dmp_chunk_mpu6050(addr, len);
+		
+		err = dmp_seek_mpu6050(dev, addr);
+		if(err != 0) return err;
+		
+		err = write_burst_mpu6050(dev, MPU_6050_MEM_R_W, data, chunk);
+		if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+		
+		addr += chunk;
+		data += chunk;
+		len -= chunk;
+	}
+	
+	return 0;
+}
+
+/*! \brief  Reads from the memory of the Digital Motion Processor
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	addr	address in the memory of the Digital Motion Processor
+ *	\param	*data	pointer to store the bytes
+ *	\param	len		amount of bytes that need to be read
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ */
+uint8_t dmp_read_mem_mpu6050(mpu6050_dev_t *dev, uint16_t addr, uint8_t *data, uint16_t len){
+	uint8_t err;
+	uint16_t chunk;
+	
+	while(len > 0){
+		chunk = dmp_chunk_mpu6050(addr, len);
+		
+		err = dmp_seek_mpu6050(dev, addr);
+		if(err != 0) return err;
+		
+		err = read_burst_mpu6050(dev, MPU_6050_MEM_R_W, data, chunk);
+		if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+		
+		addr += chunk;
+		data += chunk;
+		len -= chunk;
+	}
+	
+	return 0;
+}
+
+/*! \brief  Loads a firmware image into the Digital Motion Processor
+ *
+ *	The image is written from address 0 in chunks, every chunk is read back and compared.
+ *	Afterwards the program start address is set. The Digital Motion Processor is not started,
+ *	use dmp_enable_mpu6050 for that.
+ *
+ *	\note On the Xmega the image needs to be stored in program memory.
+ *
+ *  \param  *dev		pointer to the MPU6050 device
+ *	\param	*image		pointer to the firmware image
+ *	\param	len			size of the firmware image in bytes
+ *	\param	start_addr	program start address of the firmware image
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1, MPU6050_DMP_VERIFY if the read back 
+ *			memory does not match the image otherwise returns 2
+ */
+uint8_t dmp_load_mpu6050(mpu6050_dev_t *dev, const uint8_t *image, uint16_t len, uint16_t start_addr){
+	uint8_t err, chunk, buff[MPU6050_DMP_CHUNK_SIZE], check[MPU6050_DMP_CHUNK_SIZE];
+	uint16_t addr = 0;
+	
+	while(addr < len){
+		chunk = dmp_chunk_mpu6050(addr, len - addr);
+		
+#ifdef __AVR__
+		memcpy_P(buff, image + addr, chunk);
+#else
+		memcpy(buff, image + addr, chunk);
+#endif
+		
+		err = dmp_write_mem_mpu6050(dev, addr, buff, chunk);
+		if(err != 0) return err;
+		
+		err = dmp_read_mem_mpu6050(dev, addr, check, chunk);
+		if(err != 0) return err;
+		
+		if(memcmp(buff, check, chunk) != 0) return MPU6050_DMP_VERIFY;
+		
+		addr += chunk;
+	}
+	
+	buff[0] = start_addr >> 8;		//!< MPU_6050_DMP_CFG_1
+	buff[1] = start_addr & 0xFF;	//!< MPU_6050_DMP_CFG_2
+	
+	err = write_burst_mpu6050(dev, MPU_6050_DMP_CFG_1, buff, 2);
+	if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+	
+	return 0;
+}
+
+/*! \brief  Sets the rate at which the Digital Motion Processor writes packets to the FIFO
+ *
+ *	The divider is written to MPU6050_DMP_RATE_ADDR, the location that is used by the InvenSense firmware.
+ *	Redefine MPU6050_DMP_RATE_ADDR when a different image is used.
+ *
+ *  \param  *dev	pointer to the MPU6050 device
+ *	\param	hz		wanted rate in Hz, between 1 and MPU6050_DMP_RATE
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1 otherwise returns 2
+ */
+uint8_t dmp_set_rate_mpu6050(mpu6050_dev_t *dev, uint16_t hz){
+	uint8_t buff[2];
+	uint16_t div;
+	
+	if(hz == 0) hz = 1;
+	if(hz > MPU6050_DMP_RATE) hz = MPU6050_DMP_RATE;
+	
+	div = MPU6050_DMP_RATE / hz - 1;
+	buff[0] = div >> 8;
+	buff[1] = div & 0xFF;
+	
+	return dmp_write_mem_mpu6050(dev, MPU6050_DMP_RATE_ADDR, buff, 2);
+}
+
+/*! \brief  Get the size of one FIFO packet of the Digital Motion Processor
+ *
+ *  \param  features	MPU6050_DMP_xxx_bm outputs in the packet
+ *
+ *  \return amount of bytes in one packet
+ */
+uint8_t dmp_packet_size_mpu6050(uint8_t features){
+	uint8_t size = 0;
+	
+	if(features & MPU6050_DMP_QUAT_bm) size += 16;
+	if(features & MPU6050_DMP_ACCEL_bm) size += 6;
+	if(features & MPU6050_DMP_GYRO_bm) size += 6;
+	
+	return size;
+}
+
+/*! \brief  Converts one FIFO packet of the Digital Motion Processor
+ *
+ *	All values in the packet are big endian.
+ *
+ *  \param  *buff		pointer to the packet as it was read from the FIFO
+ *	\param	features	MPU6050_DMP_xxx_bm outputs in the packet
+ *	\param	*packet		pointer to store the converted packet
+ */
+void dmp_parse_mpu6050(const uint8_t *buff, uint8_t features, mpu6050_dmp_packet_t *packet){
+	memset(packet, 0, sizeof(*packet));
+	
+	if(features & MPU6050_DMP_QUAT_bm){
+		for(uint8_t i = 0; i < 4; i++){
+			packet->quat[i] = (int32_t) ( ((uint32_t) buff[0] << 24) | ((uint32_t) buff[1] << 16) | ((uint32_t) buff[2] << 8) | buff[3] );
+			buff += 4;
+		}
+	}
+	
+	if(features & MPU6050_DMP_ACCEL_bm){
+		for(uint8_t i = 0; i < 3; i++){
+			packet->accel[i] = (int16_t) ( (buff[0] << 8) | buff[1] );
+			buff += 2;
+		}
+	}
+	
+	if(features & MPU6050_DMP_GYRO_bm){
+		for(uint8_t i = 0; i < 3; i++){
+			packet->gyro[i] = (int16_t) ( (buff[0] << 8) | buff[1] );
+			buff += 2;
+		}
+	}
+}
+
+/*! \brief  Reads the complete packets of the Digital Motion Processor from the FIFO
+ *
+ *  \param  *dev		pointer to the MPU6050 device
+ *	\param	*packets	pointer to store the packets, needs to hold max_packets packets
+ *	\param	max_packets	maximum amount of packets that fit in packets
+ *	\param	*count		pointer to store the amount of packets that were read
+ *
+ *  \return 0 if succeeded if TWI/I2C bus is in use 1, MPU6050_FIFO_OVERFLOW if packets were lost 
+ *			(the FIFO is reset) otherwise returns 2
+ */
+uint8_t dmp_read_mpu6050(mpu6050_dev_t *dev, mpu6050_dmp_packet_t *packets, uint16_t max_packets, uint16_t *count){
+	uint8_t err, size, buff[MPU6050_DMP_PACKET_MAX];
+	uint16_t bytes;
+	
+	(*count) = 0;
+	
+	size = dmp_packet_size_mpu6050(dev->dmp_features);
+	if(size == 0) return 0;
+	
+	err = fifo_count_mpu6050(dev, &bytes);
+	if(err != 0) return err;
+	
+	if(bytes >= MPU6050_FIFO_SIZE){	//!< A full FIFO can hold a partial packet, start over
+		err = fifo_reset_mpu6050(dev);
+		if(err != 0) return err;
+		return MPU6050_FIFO_OVERFLOW;
+	}
+	
+	while(bytes >= size && (*count) < max_packets){
+		err = read_burst_mpu6050(dev, MPU_6050_FIFO_R_W, buff, size);
+		if(check_err_mpu6050(err) != 0) return check_err_mpu6050(err);
+		
+		dmp_parse_mpu6050(buff, dev->dmp_features, &packets[*count]);
+		(*count)++;
+		bytes -= size;
+	}
+	
+	return 0;
+}
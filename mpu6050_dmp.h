@@ -0,0 +1,98 @@
+/*!
+ *  \file    mpu6050_dmp.h
+ *  \author  Tycho Jobsis
+ *  \date    04-04-2021
+ *  \version 0.1.0
+ *
+ *  \brief   Digital Motion Processor support for the MPU6050 library
+ *
+ *  \details The Digital Motion Processor runs the sensor fusion inside the MPU6050 and writes quaternions
+ *			 to the FIFO. Its firmware is not stored in the MPU6050, it needs to be loaded after every power cycle.
+ *			 The library does not contain a firmware image, the application supplies the image, the program start
+ *			 address and the outputs that the image writes to the FIFO.
+ *			 On the Xmega the image needs to be stored in program memory (PROGMEM).
+ *
+ *	\code{.c}
+ 	dmp_load_mpu6050(&mpu, dmp_image, sizeof(dmp_image), 0x0400);
+ 	dmp_set_rate_mpu6050(&mpu, 100);
+ 	dmp_enable_mpu6050(&mpu, MPU6050_DMP_QUAT_bm | MPU6050_DMP_ACCEL_bm | MPU6050_DMP_GYRO_bm);
+ 	
+ 	while(1){
+ 		dmp_read_mpu6050(&mpu, packets, 4, &count);
+ 	}
+ 	\endcode
+ */
+
+/*!	\copyright
+ *
+ *	MIT License
+ *
+ *	Copyright (c) 2021 TychoJ <br>
+ *  
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy <br>
+ *	of this software and associated documentation files (the "Software"), to deal <br>
+ *	in the Software without restriction, including without limitation the rights <br>
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell <br>
+ *	copies of the Software, and to permit persons to whom the Software is <br>
+ *	furnished to do so, subject to the following conditions: <br>
+ *  
+ *	The above copyright notice and this permission notice shall be included in all <br>
+ *	copies or substantial portions of the Software. <br>
+ *  
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR <br>
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, <br>
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE <br>
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER <br>
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, <br>
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE <br>
+ *	SOFTWARE.<br>
+ */
+
+#include "mpu6050.h"
+
+#ifndef MPU6050_DMP_H_
+#define MPU6050_DMP_H_
+
+/*
+ *	Memory layout of the Digital Motion Processor
+ */
+#define MPU6050_DMP_BANK_SIZE	256		//!< Size of one memory bank
+#define MPU6050_DMP_CHUNK_SIZE	16		//!< Maximum amount of bytes in one memory transaction
+
+/*
+ *	Location of the output rate divider in the memory of the Digital Motion Processor, depends on the firmware image
+ */
+#ifndef MPU6050_DMP_RATE_ADDR
+#define MPU6050_DMP_RATE_ADDR	0x0216
+#endif
+#define MPU6050_DMP_RATE		200		//!< Internal rate of the Digital Motion Processor in Hz
+
+/*
+ *	Outputs in a FIFO packet of the Digital Motion Processor, in the order of the packet
+ */
+#define MPU6050_DMP_QUAT_bm		(1 << 0)	//!< Quaternion, 4 times 32 bit Q30
+#define MPU6050_DMP_ACCEL_bm	(1 << 1)	//!< Raw accelerometer x, y and z-axis
+#define MPU6050_DMP_GYRO_bm		(1 << 2)	//!< Raw gyroscope x, y and z-axis
+
+#define MPU6050_DMP_PACKET_MAX	28			//!< Size of a packet with all outputs
+
+/*! \brief  One FIFO packet of the Digital Motion Processor
+ *
+ *	Outputs that are not in the packet are 0.
+ */
+typedef struct {
+	int32_t quat[4];	//!< Quaternion w, x, y, z in Q30 (1 << 30 is 1.0)
+	int16_t accel[3];	//!< Raw x, y and z accelerometer values
+	int16_t gyro[3];	//!< Raw x, y and z gyroscope values
+} mpu6050_dmp_packet_t;
+
+uint8_t dmp_write_mem_mpu6050(mpu6050_dev_t *dev, uint16_t addr, const uint8_t *data, uint16_t len);
+uint8_t dmp_read_mem_mpu6050(mpu6050_dev_t *dev, uint16_t addr, uint8_t *data, uint16_t len);
+uint8_t dmp_load_mpu6050(mpu6050_dev_t *dev, const uint8_t *image, uint16_t len, uint16_t start_addr);
+uint8_t dmp_set_rate_mpu6050(mpu6050_dev_t *dev, uint16_t hz);
+
+uint8_t dmp_packet_size_mpu6050(uint8_t features);
+void dmp_parse_mpu6050(const uint8_t *buff, uint8_t features, mpu6050_dmp_packet_t *packet);
+uint8_t dmp_read_mpu6050(mpu6050_dev_t *dev, mpu6050_dmp_packet_t *packets, uint16_t max_packets, uint16_t *count);
+
+#endif /* MPU6050_DMP_H_ */
@@ -0,0 +1,440 @@
+/*!
+ *  \file    mpu6050_filter.c
+ *  \author  Tycho Jobsis
+ *  \date    04-04-2021
+ *  \version 0.1.0
+ *
+ *  \brief   Fixed point filter and decimation stages for raw MPU6050 samples
+ *
+ *  \details Every stage keeps its history per channel, so a block can be split at any frame without
+ *			 changing the result.
+ */
+
+/*!	\copyright
+ *
+ *	MIT License
+ *
+ *	Copyright (c) 2021 TychoJ
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "mpu6050_filter.h"
+
+/*! \brief  Limits a value to the range of an int16_t
+ *
+ *	\note	This function is for internal use
+ *
+ *  \param  value	value that needs to be limited
+ *
+ *  \return value limited to -32768 up to 32767
+ */
+static int16_t sat16_mpu6050(int32_t value){
+	if(value > 32767) return 32767;
+	if(value < -32768) return -32768;
+	return (int16_t) value;
+}
+
+/*! \brief  Divides and rounds to the nearest integer
+ *
+ *	\note	This function is for internal use
+ *
+ *  \param  value	value that needs to be divided
+ *	\param	div		divider, larger than 0
+ *
+ *  \return value / div rounded half away from zero
+ */
+static int32_t div_round_mpu6050(int32_t value, int32_t div){
+	if(value >= 0) return (value + div / 2) / div;
+	return (value - div / 2) / div;
+}
+
+/*! \brief  Initializes a moving average
+ *
+ *  \param  *f			pointer to the filter state
+ *	\param	channels	channels in a frame, at most MPU6050_FILTER_CHANNELS
+ *	\param	len			amount of frames that are averaged, 1 up to MPU6050_FILTER_MA_MAX
+ *	\param	decim		one output frame every decim input frames, 1 does not decimate
+ */
+void filter_ma_init_mpu6050(mpu6050_filter_ma_t *f, uint8_t channels, uint8_t len, uint8_t decim){
+	memset(f, 0, sizeof(*f));
+	
+	if(channels > MPU6050_FILTER_CHANNELS) channels = MPU6050_FILTER_CHANNELS;
+	if(len < 1) len = 1;
+	if(len > MPU6050_FILTER_MA_MAX) len = MPU6050_FILTER_MA_MAX;
+	if(decim < 1) decim = 1;
+	
+	f->channels = channels;
+	f->len = len;
+	f->decim = decim;
+}
+
+/*! \brief  Runs a block of frames through a moving average
+ *
+ *	The sum is updated with the newest and the oldest frame, so the cost does not depend on the length.
+ *
+ *  \param  *f		pointer to the filter state
+ *	\param	*in		pointer to the input frames
+ *	\param	*out	pointer to store the output frames, can be the same as in
+ *	\param	frames	amount of input frames
+ *
+ *  \return amount of output frames
+ */
+uint16_t filter_ma_process_mpu6050(mpu6050_filter_ma_t *f, const int16_t *in, int16_t *out, uint16_t frames){
+	uint16_t n = 0;
+	uint8_t ch = f->channels;
+	int16_t *hist;
+	
+	for(uint16_t i = 0; i < frames; i++, in += ch){
+		hist = f->hist[f->pos];
+		for(uint8_t c = 0; c < ch; c++){
+			f->sum[c] += in[c] - hist[c];
+			hist[c] = in[c];
+		}
+		if(++f->pos == f->len) f->pos = 0;
+		
+		if(++f->phase < f->decim) continue;
+		f->phase = 0;
+		
+		for(uint8_t c = 0; c < ch; c++) out[c] = (int16_t) div_round_mpu6050(f->sum[c], f->len);
+		out += ch;
+		n++;
+	}
+	
+	return n;
+}
+
+/*! \brief  Calculates the coefficients of a second order Butterworth low pass filter
+ *
+ *	The coefficients are rounded to Q12 and b1 is corrected so the gain at 0Hz is exactly 1.
+ *	Uses floats, call it once and keep the coefficients.
+ *
+ *  \param  *coef	pointer to store b0, b1, b2, a1, a2 in Q12
+ *	\param	fs		sample rate in Hz
+ *	\param	fc		cut off frequency in Hz, below fs / 2
+ */
+void filter_biquad_lowpass_mpu6050(int32_t *coef, uint16_t fs, uint16_t fc){
+	float w0 = 2.0f * (float) M_PI * fc / fs;
+	float alpha = sinf(w0) / (2.0f * (float) M_SQRT1_2);
+	float cosw = cosf(w0);
+	float a0 = 1.0f + alpha;
+	float one = (float) (1L << MPU6050_BIQUAD_SHIFT);
+	
+	coef[0] = lroundf((1.0f - cosw) / 2.0f / a0 * one);
+	coef[2] = coef[0];
+	coef[3] = lroundf(-2.0f * cosw / a0 * one);
+	coef[4] = lroundf((1.0f - alpha) / a0 * one);
+	coef[1] = (1L << MPU6050_BIQUAD_SHIFT) + coef[3] + coef[4] - coef[0] - coef[2];
+}
+
+/*! \brief  Initializes a biquad filter
+ *
+ *	With b0, b1, b2 in Q12 the sum of the absolute coefficients needs to be at most 8.0 (32768).
+ *
+ *  \param  *f			pointer to the filter state
+ *	\param	channels	channels in a frame, at most MPU6050_FILTER_CHANNELS
+ *	\param	*coef		b0, b1, b2, a1, a2 in Q12, they are copied
+ */
+void filter_biquad_init_mpu6050(mpu6050_filter_biquad_t *f, uint8_t channels, const int32_t *coef){
+	memset(f, 0, sizeof(*f));
+	
+	if(channels > MPU6050_FILTER_CHANNELS) channels = MPU6050_FILTER_CHANNELS;
+	
+	f->channels = channels;
+	for(uint8_t i = 0; i < 5; i++) f->coef[i] = coef[i];
+}
+
+/*! \brief  Runs a block of frames through a biquad filter
+ *
+ *  \param  *f		pointer to the filter state
+ *	\param	*in		pointer to the input frames
+ *	\param	*out	pointer to store the output frames, can be the same as in
+ *	\param	frames	amount of input frames
+ *
+ *  \return amount of output frames, equal to frames
+ */
+uint16_t filter_biquad_process_mpu6050(mpu6050_filter_biquad_t *f, const int16_t *in, int16_t *out, uint16_t frames){
+	uint8_t ch = f->channels;
+	int32_t acc, y;
+	int16_t x;
+	
+	for(uint16_t i = 0; i < frames; i++, in += ch, out += ch){
+		for(uint8_t c = 0; c < ch; c++){
+			x = in[c];
+			
+			acc = f->coef[0] * x + f->coef[1] * f->x[0][c] + f->coef[2] * f->x[1][c]
+				- f->coef[3] * f->y[0][c] - f->coef[4] * f->y[1][c] + f->err[c];
+			
+			y = acc >> MPU6050_BIQUAD_SHIFT;
+			f->err[c] = (int16_t) (acc - (y << MPU6050_BIQUAD_SHIFT));
+			if(y > 32767 || y < -32768) f->err[c] = 0;
+			
+			f->x[1][c] = f->x[0][c];
+			f->x[0][c] = x;
+			f->y[1][c] = f->y[0][c];
+			f->y[0][c] = sat16_mpu6050(y);
+			
+			out[c] = f->y[0][c];
+		}
+	}
+	
+	return frames;
+}
+
+/*! \brief  Initializes a CIC decimator
+ *
+ *	The order is lowered until decim ^ order is at most 65536.
+ *
+ *  \param  *f			pointer to the filter state
+ *	\param	channels	channels in a frame, at most MPU6050_FILTER_CHANNELS
+ *	\param	order		amount of integrator and comb stages, 1 up to MPU6050_FILTER_CIC_MAX
+ *	\param	decim		one output frame every decim input frames
+ */
+void filter_cic_init_mpu6050(mpu6050_filter_cic_t *f, uint8_t channels, uint8_t order, uint8_t decim){
+	memset(f, 0, sizeof(*f));
+	
+	if(channels > MPU6050_FILTER_CHANNELS) channels = MPU6050_FILTER_CHANNELS;
+	if(order < 1) order = 1;
+	if(order > MPU6050_FILTER_CIC_MAX) order = MPU6050_FILTER_CIC_MAX;
+	if(decim < 1) decim = 1;
+	
+	f->gain = 1;
+	for(uint8_t i = 0; i < order; i++){
+		if(f->gain * decim > 65536L){
+			order = i;
+			break;
+		}
+		f->gain *= decim;
+	}
+	
+	f->channels = channels;
+	f->order = order;
+	f->decim = decim;
+}
+
+/*! \brief  Runs a block of frames through a CIC decimator
+ *
+ *  \param  *f		pointer to the filter state
+ *	\param	*in		pointer to the input frames
+ *	\param	*out	pointer to store the output frames, can be the same as in
+ *	\param	frames	amount of input frames
+ *
+ *  \return amount of output frames
+ */
+uint16_t filter_cic_process_mpu6050(mpu6050_filter_cic_t *f, const int16_t *in, int16_t *out, uint16_t frames){
+	uint16_t n = 0;
+	uint8_t ch = f->channels;
+	uint32_t v, prev;
+	
+	for(uint16_t i = 0; i < frames; i++, in += ch){
+		for(uint8_t c = 0; c < ch; c++){
+			v = (uint32_t) (int32_t) in[c];
+			for(uint8_t k = 0; k < f->order; k++){
+				f->integ[k][c] += v;
+				v = f->integ[k][c];
+			}
+		}
+		
+		if(++f->phase < f->decim) continue;
+		f->phase = 0;
+		
+		for(uint8_t c = 0; c < ch; c++){
+			v = f->integ[f->order - 1][c];
+			for(uint8_t k = 0; k < f->order; k++){
+				prev = f->comb[k][c];
+				f->comb[k][c] = v;
+				v -= prev;
+			}
+			out[c] = sat16_mpu6050(div_round_mpu6050((int32_t) v, f->gain));
+		}
+		out += ch;
+		n++;
+	}
+	
+	return n;
+}
+
+/*! \brief  Calculates the coefficients of a low pass FIR filter
+ *
+ *	Windowed sinc with a Hamming window. The coefficients are rounded to Q15 and the center tap is
+ *	corrected so they add up to 32767, the gain at 0Hz is 1 - 2^-15. Uses floats, call it once and keep the coefficients.
+ *
+ *  \param  *coef	pointer to store taps coefficients in Q15
+ *	\param	taps	amount of coefficients, 1 up to MPU6050_FILTER_FIR_MAX
+ *	\param	fs		sample rate in Hz
+ *	\param	fc		cut off frequency in Hz, below fs / 2
+ */
+void filter_fir_lowpass_mpu6050(int16_t *coef, uint8_t taps, uint16_t fs, uint16_t fc){
+	float h[MPU6050_FILTER_FIR_MAX];
+	float fn = (float) fc / fs;
+	float m, sum = 0.0f, t;
+	int32_t total = 0;
+	
+	if(taps == 0) return;
+	if(taps > MPU6050_FILTER_FIR_MAX) taps = MPU6050_FILTER_FIR_MAX;
+	m = (taps - 1) / 2.0f;	//!< Center of the clamped filter
+	
+	for(uint8_t i = 0; i < taps; i++){
+		t = i - m;
+		h[i] = (t == 0.0f) ? 2.0f * fn : sinf(2.0f * (float) M_PI * fn * t) / ((float) M_PI * t);
+		if(taps > 1) h[i] *= 0.54f - 0.46f * cosf(2.0f * (float) M_PI * i / (taps - 1));
+		sum += h[i];
+	}
+	
+	for(uint8_t i = 0; i < taps; i++){
+		coef[i] = (int16_t) lroundf(h[i] / sum * ((1L << MPU6050_FIR_SHIFT) - 1));
+		total += coef[i];
+	}
+	
+	coef[taps / 2] += (int16_t) ((1L << MPU6050_FIR_SHIFT) - 1 - total);
+}
+
+/*! \brief  Initializes a FIR filter
+ *
+ *  \param  *f			pointer to the filter state
+ *	\param	channels	channels in a frame, at most MPU6050_FILTER_CHANNELS
+ *	\param	*coef		pointer to taps coefficients in Q15, needs to stay valid while the filter is used
+ *	\param	taps		amount of coefficients, 1 up to MPU6050_FILTER_FIR_MAX
+ *	\param	decim		one output frame every decim input frames, 1 does not decimate
+ */
+void filter_fir_init_mpu6050(mpu6050_filter_fir_t *f, uint8_t channels, const int16_t *coef, uint8_t taps, uint8_t decim){
+	memset(f, 0, sizeof(*f));
+	
+	if(channels > MPU6050_FILTER_CHANNELS) channels = MPU6050_FILTER_CHANNELS;
+	if(taps < 1) taps = 1;
+	if(taps > MPU6050_FILTER_FIR_MAX) taps = MPU6050_FILTER_FIR_MAX;
+	if(decim < 1) decim = 1;
+	
+	f->channels = channels;
+	f->coef = coef;
+	f->taps = taps;
+	f->decim = decim;
+}
+
+/*! \brief  Runs a block of frames through a FIR filter
+ *
+ *  \param  *f		pointer to the filter state
+ *	\param	*in		pointer to the input frames
+ *	\param	*out	pointer to store the output frames, can be the same as in
+ *	\param	frames	amount of input frames
+ *
+ *  \return amount of output frames
+ */
+uint16_t filter_fir_process_mpu6050(mpu6050_filter_fir_t *f, const int16_t *in, int16_t *out, uint16_t frames){
+	uint16_t n = 0;
+	uint8_t ch = f->channels;
+	uint8_t taps = f->taps;
+	const int16_t *h, *x;
+	int32_t acc;
+	
+	for(uint16_t i = 0; i < frames; i++, in += ch){
+		for(uint8_t c = 0; c < ch; c++){
+			f->hist[c][f->pos] = in[c];
+			f->hist[c][f->pos + taps] = in[c];
+		}
+		if(++f->pos == taps) f->pos = 0;
+		
+		if(++f->phase < f->decim) continue;
+		f->phase = 0;
+		
+		for(uint8_t c = 0; c < ch; c++){
+			x = &f->hist[c][f->pos + taps - 1];	//!< Newest frame, the older frames are before it
+			h = f->coef;
+			acc = 1L << (MPU6050_FIR_SHIFT - 1);
+			for(uint8_t k = 0; k < taps; k++) acc += (int32_t) (*h++) * (*x--);
+			out[c] = sat16_mpu6050(acc >> MPU6050_FIR_SHIFT);
+		}
+		out += ch;
+		n++;
+	}
+	
+	return n;
+}
+
+/*! \brief  Runs a block of frames through a chain of stages
+ *
+ *	Every stage processes the whole block in place before the next stage starts.
+ *
+ *  \param  *stages	pointer to the stages in the order they are applied
+ *	\param	count	amount of stages
+ *	\param	*block	pointer to the input frames, the output frames are stored in it
+ *	\param	frames	amount of input frames
+ *
+ *  \return amount of output frames in block
+ */
+uint16_t filter_run_mpu6050(const mpu6050_filter_stage_t *stages, uint8_t count, int16_t *block, uint16_t frames){
+	for(uint8_t i = 0; i < count && frames > 0; i++){
+		switch(stages[i].type){
+			case MPU6050_FILTER_MA:
+				frames = filter_ma_process_mpu6050((mpu6050_filter_ma_t *) stages[i].state, block, block, frames);
+				break;
+			case MPU6050_FILTER_BIQUAD:
+				frames = filter_biquad_process_mpu6050((mpu6050_filter_biquad_t *) stages[i].state, block, block, frames);
+				break;
+			case MPU6050_FILTER_CIC:
+				frames = filter_cic_process_mpu6050((mpu6050_filter_cic_t *) stages[i].state, block, block, frames);
+				break;
+			case MPU6050_FILTER_FIR:
+				frames = filter_fir_process_mpu6050((mpu6050_filter_fir_t *) stages[i].state, block, block, frames);
+				break;
+			default:
+				break;
+		}
+	}
+	
+	return frames;
+}
+
+/*! \brief  Converts frames that are read from the FIFO to a block
+ *
+ *	With MPU6050_FIFO_ACCEL_bm, MPU6050_FIFO_TEMP_bm and MPU6050_FIFO_GYRO_bm the frames have the
+ *	MPU6050_FILTER_CHANNELS channels of a motion frame, other FIFO settings have fewer channels.
+ *
+ *  \param  *buff	pointer to the big endian bytes of fifo_drain_mpu6050
+ *	\param	*block	pointer to store the values
+ *	\param	values	amount of 16 bit values, frames times channels
+ */
+void filter_from_fifo_mpu6050(const uint8_t *buff, int16_t *block, uint16_t values){
+	for(uint16_t i = 0; i < values; i++, buff += 2){
+		block[i] = (int16_t) (((uint16_t) buff[0] << 8) | buff[1]);
+	}
+}
+
+/*! \brief  Converts motion frames to a block with MPU6050_FILTER_CHANNELS channels
+ *
+ *	Used for the frames of acq_pop_mpu6050 and get_motion7_raw_mpu6050.
+ *
+ *  \param  *frames	pointer to the motion frames
+ *	\param	*block	pointer to store count * MPU6050_FILTER_CHANNELS values
+ *	\param	count	amount of frames
+ */
+void filter_from_motion_mpu6050(const mpu6050_motion_t *frames, int16_t *block, uint16_t count){
+	for(uint16_t i = 0; i < count; i++, frames++){
+		*block++ = frames->accel[0];
+		*block++ = frames->accel[1];
+		*block++ = frames->accel[2];
+		*block++ = frames->temp;
+		*block++ = frames->gyro[0];
+		*block++ = frames->gyro[1];
+		*block++ = frames->gyro[2];
+	}
+}
@@ -0,0 +1,173 @@
+/*!
+ *  \file    mpu6050_filter.h
+ *  \author  Tycho Jobsis
+ *  \date    04-04-2021
+ *  \version 0.1.0
+ *
+ *  \brief   Fixed point filter and decimation stages for raw MPU6050 samples
+ *
+ *  \details The stages work on blocks of interleaved int16 frames: channel 0 to channels - 1 of the first frame,
+ *			 then the channels of the next frame. Every channel is filtered independently. A stage returns the
+ *			 amount of frames it produced, which is lower than the input for a decimating stage. The output
+ *			 may be the same block as the input, so stages can be chained in place with filter_run_mpu6050.
+ *			 Only integer math is used while filtering, the design functions use floats and are meant to be
+ *			 called once.
+ *
+ *	\code{.c}
+ 	mpu6050_filter_biquad_t lp;
+ 	mpu6050_filter_cic_t cic;
+ 	mpu6050_filter_stage_t chain[2] = {
+ 		{ MPU6050_FILTER_BIQUAD, &lp },
+ 		{ MPU6050_FILTER_CIC, &cic },
+ 	};
+ 	int32_t coef[5];
+ 	
+ 	filter_biquad_lowpass_mpu6050(coef, 1000, 40);
+ 	filter_biquad_init_mpu6050(&lp, MPU6050_FILTER_CHANNELS, coef);
+ 	filter_cic_init_mpu6050(&cic, MPU6050_FILTER_CHANNELS, 2, 10);	// 1kHz to 100Hz
+ 	
+ 	while(1){
+ 		fifo_drain_mpu6050(&mpu, buff, 50, &frames);
+ 		filter_from_fifo_mpu6050(buff, block, frames * MPU6050_FILTER_CHANNELS);
+ 		frames = filter_run_mpu6050(chain, 2, block, frames);	// block holds 5 frames at 100Hz
+ 	}
+ 	\endcode
+ */
+
+/*!	\copyright
+ *
+ *	MIT License
+ *
+ *	Copyright (c) 2021 TychoJ <br>
+ *  
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy <br>
+ *	of this software and associated documentation files (the "Software"), to deal <br>
+ *	in the Software without restriction, including without limitation the rights <br>
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell <br>
+ *	copies of the Software, and to permit persons to whom the Software is <br>
+ *	furnished to do so, subject to the following conditions: <br>
+ *  
+ *	The above copyright notice and this permission notice shall be included in all <br>
+ *	copies or substantial portions of the Software. <br>
+ *  
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR <br>
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, <br>
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE <br>
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER <br>
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, <br>
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE <br>
+ *	SOFTWARE.<br>
+ */
+
+#include "mpu6050.h"
+
+#ifndef MPU6050_FILTER_H_
+#define MPU6050_FILTER_H_
+
+#define MPU6050_FILTER_CHANNELS	7	//!< Channels of a motion frame: accel x, y, z, temp, gyro x, y, z
+
+#ifndef MPU6050_FILTER_MA_MAX
+#define MPU6050_FILTER_MA_MAX	32	//!< Maximum length of the moving average
+#endif
+#ifndef MPU6050_FILTER_FIR_MAX
+#define MPU6050_FILTER_FIR_MAX	32	//!< Maximum amount of taps of the FIR filter
+#endif
+#define MPU6050_FILTER_CIC_MAX	4	//!< Maximum order of the CIC decimator
+
+#define MPU6050_BIQUAD_SHIFT	12	//!< Biquad coefficients are in Q12
+#define MPU6050_FIR_SHIFT		15	//!< FIR coefficients are in Q15
+
+/*
+ *	Stage types of mpu6050_filter_stage_t
+ */
+#define MPU6050_FILTER_MA		0
+#define MPU6050_FILTER_BIQUAD	1
+#define MPU6050_FILTER_CIC		2
+#define MPU6050_FILTER_FIR		3
+
+/*! \brief  Moving average with optional decimation
+ *
+ *	With decim equal to len every output is the average of a block of len inputs.
+ */
+typedef struct {
+	uint8_t channels;	//!< Channels in a frame
+	uint8_t len;		//!< Amount of frames that are averaged
+	uint8_t decim;		//!< One output frame every decim input frames
+	uint8_t pos;		//!< Position of the oldest frame in hist
+	uint8_t phase;		//!< Input frames since the last output frame
+	int32_t sum[MPU6050_FILTER_CHANNELS];	//!< Sum of the frames in hist
+	int16_t hist[MPU6050_FILTER_MA_MAX][MPU6050_FILTER_CHANNELS];
+} mpu6050_filter_ma_t;
+
+/*! \brief  Second order IIR filter in direct form I
+ *
+ *	y = b0 * x + b1 * x[-1] + b2 * x[-2] - a1 * y[-1] - a2 * y[-2], the coefficients are in Q12.
+ *	The bits that are lost when the result is shifted are added to the next result (error feedback),
+ *	so a low cut off frequency does not add an offset.
+ */
+typedef struct {
+	uint8_t channels;	//!< Channels in a frame
+	int32_t coef[5];	//!< b0, b1, b2, a1, a2 in Q12
+	int16_t x[2][MPU6050_FILTER_CHANNELS];	//!< Previous two inputs
+	int16_t y[2][MPU6050_FILTER_CHANNELS];	//!< Previous two outputs
+	int16_t err[MPU6050_FILTER_CHANNELS];	//!< Bits that were lost in the previous output
+} mpu6050_filter_biquad_t;
+
+/*! \brief  Cascaded integrator comb decimator
+ *
+ *	order integrators at the input rate, decimation by decim and order combs at the output rate.
+ *	Only additions are needed per input frame. The gain decim ^ order is divided out,
+ *	decim ^ order may be at most 65536 so the integrators do not lose bits.
+ */
+typedef struct {
+	uint8_t channels;	//!< Channels in a frame
+	uint8_t order;		//!< Amount of integrator and comb stages
+	uint8_t decim;		//!< One output frame every decim input frames
+	uint8_t phase;		//!< Input frames since the last output frame
+	int32_t gain;		//!< decim ^ order
+	uint32_t integ[MPU6050_FILTER_CIC_MAX][MPU6050_FILTER_CHANNELS];	//!< Integrators, overflow wraps around
+	uint32_t comb[MPU6050_FILTER_CIC_MAX][MPU6050_FILTER_CHANNELS];		//!< Previous input of every comb
+} mpu6050_filter_cic_t;
+
+/*! \brief  FIR filter with optional decimation
+ *
+ *	The coefficients are in Q15 and are not copied. The sum of the absolute coefficients needs to be below
+ *	65536 (2.0) so the accumulator can not overflow. When decimating only the outputs that are kept are calculated.
+ */
+typedef struct {
+	uint8_t channels;	//!< Channels in a frame
+	uint8_t taps;		//!< Amount of coefficients
+	uint8_t decim;		//!< One output frame every decim input frames
+	uint8_t pos;		//!< Position of the oldest frame in hist
+	uint8_t phase;		//!< Input frames since the last output frame
+	const int16_t *coef;	//!< Coefficients in Q15, coef[0] is applied to the newest frame
+	int16_t hist[MPU6050_FILTER_CHANNELS][2 * MPU6050_FILTER_FIR_MAX];	//!< Every frame is stored twice so the taps are contiguous
+} mpu6050_filter_fir_t;
+
+/*! \brief  One stage of a filter chain
+ */
+typedef struct {
+	uint8_t type;	//!< One of MPU6050_FILTER_x
+	void *state;	//!< Pointer to the mpu6050_filter_x_t of the stage
+} mpu6050_filter_stage_t;
+
+void filter_ma_init_mpu6050(mpu6050_filter_ma_t *f, uint8_t channels, uint8_t len, uint8_t decim);
+uint16_t filter_ma_process_mpu6050(mpu6050_filter_ma_t *f, const int16_t *in, int16_t *out, uint16_t frames);
+
+void filter_biquad_lowpass_mpu6050(int32_t *coef, uint16_t fs, uint16_t fc);
+void filter_biquad_init_mpu6050(mpu6050_filter_biquad_t *f, uint8_t channels, const int32_t *coef);
+uint16_t filter_biquad_process_mpu6050(mpu6050_filter_biquad_t *f, const int16_t *in, int16_t *out, uint16_t frames);
+
+void filter_cic_init_mpu6050(mpu6050_filter_cic_t *f, uint8_t channels, uint8_t order, uint8_t decim);
+uint16_t filter_cic_process_mpu6050(mpu6050_filter_cic_t *f, const int16_t *in, int16_t *out, uint16_t frames);
+
+void filter_fir_lowpass_mpu6050(int16_t *coef, uint8_t taps, uint16_t fs, uint16_t fc);
+void filter_fir_init_mpu6050(mpu6050_filter_fir_t *f, uint8_t channels, const int16_t *coef, uint8_t taps, uint8_t decim);
+uint16_t filter_fir_process_mpu6050(mpu6050_filter_fir_t *f, const int16_t *in, int16_t *out, uint16_t frames);
+
+uint16_t filter_run_mpu6050(const mpu6050_filter_stage_t *stages, uint8_t count, int16_t *block, uint16_t frames);
+
+void filter_from_fifo_mpu6050(const uint8_t *buff, int16_t *block, uint16_t values);
+void filter_from_motion_mpu6050(const mpu6050_motion_t *frames, int16_t *block, uint16_t count);
+
+#endif /* MPU6050_FILTER_H_ */
@@ -0,0 +1,257 @@
+/*!
+ *  \file    mpu6050_fusion.c
+ *  \author  Tycho Jobsis
+ *  \date    04-04-2021
+ *  \version 0.1.0
+ *
+ *  \brief   Attitude estimation for the MPU6050 library
+ *
+ *  \details Mahony filter: the difference between the measured gravity and the gravity that follows from the
+ *			 quaternion is fed back into the gyroscope rate before the quaternion is integrated.
+ */
+
+/*!	\copyright
+ *
+ *	MIT License
+ *
+ *	Copyright (c) 2021 TychoJ
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#include <math.h>
+
+#include "mpu6050_fusion.h"
+
+#define ONE_Q30		(1L << 30)
+
+/*
+ *	Gyroscope LSB in rad/s Q40 for every range
+ */
+static const int32_t gyro_rad_q40[4] = {146408829, 292817659, 585635317, 1171270634};
+
+/*
+ *	Gyroscope LSB in rad/s for every range
+ */
+static const float gyro_rad[4] = {
+	250.0f / 32768.0f * (float) M_PI / 180.0f,
+	500.0f / 32768.0f * (float) M_PI / 180.0f,
+	1000.0f / 32768.0f * (float) M_PI / 180.0f,
+	2000.0f / 32768.0f * (float) M_PI / 180.0f
+};
+
+/*! \brief  Integer square root
+ *
+ *	\note	This function is for internal use
+ *
+ *  \param  x	value to take the square root of
+ *
+ *  \return square root of x rounded down
+ */
+static uint32_t isqrt_mpu6050(uint32_t x){
+	uint32_t res = 0;
+	uint32_t bit = 1UL << 30;
+	
+	while(bit > x) bit >>= 2;
+	
+	while(bit != 0){
+		if(x >= res + bit){
+			x -= res + bit;
+			res = (res >> 1) + bit;
+		}
+		else {
+			res >>= 1;
+		}
+		bit >>= 2;
+	}
+	
+	return res;
+}
+
+/*! \brief  Multiplies two Q30 values
+ *
+ *	\note	This function is for internal use
+ *
+ *  \return a * b in Q30
+ */
+static int32_t mul_q30_mpu6050(int32_t a, int32_t b){
+	return (int32_t) (((int64_t) a * b) >> 30);
+}
+
+/*! \brief  Initializes the fixed point filter with the default gains and no rotation
+ *
+ *  \param  *f			pointer to the filter state
+ *	\param	gyro_scale	range of the gyroscope samples, one of MPU6050_GYRO_SCL_x
+ */
+void fusion_init_fixed_mpu6050(mpu6050_fusion_fixed_t *f, uint8_t gyro_scale){
+	f->q[0] = ONE_Q30;
+	f->q[1] = 0;
+	f->q[2] = 0;
+	f->q[3] = 0;
+	
+	for(uint8_t i = 0; i < 3; i++) f->integral[i] = 0;
+	
+	f->kp = (int32_t) (MPU6050_FUSION_KP * 65536.0f);
+	f->ki = (int32_t) (MPU6050_FUSION_KI * 65536.0f);
+	f->gyro_scale = gyro_scale & 0x03;
+}
+
+/*! \brief  Updates the fixed point filter with one frame
+ *
+ *	The quaternion is renormalized with one Newton step per update, this only needs multiplications.
+ *	When the accelerometer reads 0 on all axes only the gyroscope is used.
+ *
+ *  \param  *f		pointer to the filter state
+ *	\param	*accel	raw x, y and z accelerometer values
+ *	\param	*gyro	raw x, y and z gyroscope values without offset
+ *	\param	dt_us	time since the previous frame in us, at most MPU6050_FUSION_MAX_DT_FIXED is used
+ */
+void fusion_update_fixed_mpu6050(mpu6050_fusion_fixed_t *f, const int16_t *accel, const int16_t *gyro, uint32_t dt_us){
+	int32_t rate[3], half[3], e[3], a[3], v[3], q[4];
+	uint32_t half_dt, norm;
+	int32_t n2, k;
+	
+	if(dt_us > MPU6050_FUSION_MAX_DT_FIXED) dt_us = MPU6050_FUSION_MAX_DT_FIXED;
+	half_dt = (uint32_t) (((uint64_t) dt_us << 31) / 1000000);	//!< dt / 2 in s Q32
+	
+	for(uint8_t i = 0; i < 3; i++){
+		rate[i] = (int32_t) (((int64_t) gyro[i] * gyro_rad_q40[f->gyro_scale]) >> 16);	//!< rad/s Q24
+	}
+	
+	norm = isqrt_mpu6050((uint32_t) ((int32_t) accel[0] * accel[0]) + (uint32_t) ((int32_t) accel[1] * accel[1]) + (uint32_t) ((int32_t) accel[2] * accel[2]));
+	
+	if(norm != 0){
+		for(uint8_t i = 0; i < 3; i++) a[i] = (int32_t) (((int64_t) accel[i] << 30) / norm);
+		
+		// Direction of gravity according to the quaternion
+		v[0] = 2 * (mul_q30_mpu6050(f->q[1], f->q[3]) - mul_q30_mpu6050(f->q[0], f->q[2]));
+		v[1] = 2 * (mul_q30_mpu6050(f->q[0], f->q[1]) + mul_q30_mpu6050(f->q[2], f->q[3]));
+		v[2] = mul_q30_mpu6050(f->q[0], f->q[0]) - mul_q30_mpu6050(f->q[1], f->q[1])
+			 - mul_q30_mpu6050(f->q[2], f->q[2]) + mul_q30_mpu6050(f->q[3], f->q[3]);
+		
+		e[0] = mul_q30_mpu6050(a[1], v[2]) - mul_q30_mpu6050(a[2], v[1]);
+		e[1] = mul_q30_mpu6050(a[2], v[0]) - mul_q30_mpu6050(a[0], v[2]);
+		e[2] = mul_q30_mpu6050(a[0], v[1]) - mul_q30_mpu6050(a[1], v[0]);
+		
+		for(uint8_t i = 0; i < 3; i++){
+			if(f->ki != 0){
+				f->integral[i] += (int32_t) (((((int64_t) f->ki * e[i]) >> 22) * half_dt) >> 31);
+				rate[i] += f->integral[i];
+			}
+			rate[i] += (int32_t) (((int64_t) f->kp * e[i]) >> 22);
+		}
+	}
+	
+	for(uint8_t i = 0; i < 3; i++){
+		half[i] = (int32_t) (((int64_t) rate[i] * half_dt) >> 26);	//!< Half of the rotation angle in rad Q30
+	}
+	
+	q[0] = f->q[0];
+	q[1] = f->q[1];
+	q[2] = f->q[2];
+	q[3] = f->q[3];
+	
+	f->q[0] += -mul_q30_mpu6050(q[1], half[0]) - mul_q30_mpu6050(q[2], half[1]) - mul_q30_mpu6050(q[3], half[2]);
+	f->q[1] +=  mul_q30_mpu6050(q[0], half[0]) + mul_q30_mpu6050(q[2], half[2]) - mul_q30_mpu6050(q[3], half[1]);
+	f->q[2] +=  mul_q30_mpu6050(q[0], half[1]) - mul_q30_mpu6050(q[1], half[2]) + mul_q30_mpu6050(q[3], half[0]);
+	f->q[3] +=  mul_q30_mpu6050(q[0], half[2]) + mul_q30_mpu6050(q[1], half[1]) - mul_q30_mpu6050(q[2], half[0]);
+	
+	// 1 / sqrt(n2) is close to (3 - n2) / 2 when n2 is close to 1
+	n2 = mul_q30_mpu6050(f->q[0], f->q[0]) + mul_q30_mpu6050(f->q[1], f->q[1])
+	   + mul_q30_mpu6050(f->q[2], f->q[2]) + mul_q30_mpu6050(f->q[3], f->q[3]);
+	k = (int32_t) ((3 * (int64_t) ONE_Q30 - n2) >> 1);
+	
+	for(uint8_t i = 0; i < 4; i++) f->q[i] = mul_q30_mpu6050(f->q[i], k);
+}
+
+/*! \brief  Initializes the float filter with the default gains and no rotation
+ *
+ *  \param  *f			pointer to the filter state
+ *	\param	gyro_scale	range of the gyroscope samples, one of MPU6050_GYRO_SCL_x
+ */
+void fusion_init_float_mpu6050(mpu6050_fusion_float_t *f, uint8_t gyro_scale){
+	f->q[0] = 1.0f;
+	f->q[1] = 0.0f;
+	f->q[2] = 0.0f;
+	f->q[3] = 0.0f;
+	
+	for(uint8_t i = 0; i < 3; i++) f->integral[i] = 0.0f;
+	
+	f->kp = MPU6050_FUSION_KP;
+	f->ki = MPU6050_FUSION_KI;
+	f->gyro_scale = gyro_scale & 0x03;
+}
+
+/*! \brief  Updates the float filter with one frame
+ *
+ *	When the accelerometer reads 0 on all axes only the gyroscope is used.
+ *
+ *  \param  *f		pointer to the filter state
+ *	\param	*accel	raw x, y and z accelerometer values
+ *	\param	*gyro	raw x, y and z gyroscope values without offset
+ *	\param	dt_us	time since the previous frame in us
+ */
+void fusion_update_float_mpu6050(mpu6050_fusion_float_t *f, const int16_t *accel, const int16_t *gyro, uint32_t dt_us){
+	float rate[3], e[3], a[3], v[3], q[4];
+	float half_dt, norm;
+	
+	if(dt_us > MPU6050_FUSION_MAX_DT) dt_us = MPU6050_FUSION_MAX_DT;
+	half_dt = (float) dt_us * 0.5e-6f;
+	
+	for(uint8_t i = 0; i < 3; i++) rate[i] = gyro[i] * gyro_rad[f->gyro_scale];
+	
+	norm = sqrtf((float) accel[0] * accel[0] + (float) accel[1] * accel[1] + (float) accel[2] * accel[2]);
+	
+	if(norm != 0.0f){
+		for(uint8_t i = 0; i < 3; i++) a[i] = accel[i] / norm;
+		
+		// Direction of gravity according to the quaternion
+		v[0] = 2.0f * (f->q[1] * f->q[3] - f->q[0] * f->q[2]);
+		v[1] = 2.0f * (f->q[0] * f->q[1] + f->q[2] * f->q[3]);
+		v[2] = f->q[0] * f->q[0] - f->q[1] * f->q[1] - f->q[2] * f->q[2] + f->q[3] * f->q[3];
+		
+		e[0] = a[1] * v[2] - a[2] * v[1];
+		e[1] = a[2] * v[0] - a[0] * v[2];
+		e[2] = a[0] * v[1] - a[1] * v[0];
+		
+		for(uint8_t i = 0; i < 3; i++){
+			if(f->ki != 0.0f){
+				f->integral[i] += f->ki * e[i] * 2.0f * half_dt;
+				rate[i] += f->integral[i];
+			}
+			rate[i] += f->kp * e[i];
+		}
+	}
+	
+	for(uint8_t i = 0; i < 3; i++) rate[i] *= half_dt;
+	
+	q[0] = f->q[0];
+	q[1] = f->q[1];
+	q[2] = f->q[2];
+	q[3] = f->q[3];
+	
+	f->q[0] += -q[1] * rate[0] - q[2] * rate[1] - q[3] * rate[2];
+	f->q[1] +=  q[0] * rate[0] + q[2] * rate[2] - q[3] * rate[1];
+	f->q[2] +=  q[0] * rate[1] - q[1] * rate[2] + q[3] * rate[0];
+	f->q[3] +=  q[0] * rate[2] + q[1] * rate[1] - q[2] * rate[0];
+	
+	norm = sqrtf(f->q[0] * f->q[0] + f->q[1] * f->q[1] + f->q[2] * f->q[2] + f->q[3] * f->q[3]);
+	
+	for(uint8_t i = 0; i < 4; i++) f->q[i] /= norm;
+}
@@ -0,0 +1,95 @@
+/*!
+ *  \file    mpu6050_fusion.h
+ *  \author  Tycho Jobsis
+ *  \date    04-04-2021
+ *  \version 0.1.0
+ *
+ *  \brief   Attitude estimation for the MPU6050 library
+ *
+ *  \details A Mahony filter that updates an orientation quaternion with one raw frame of the MPU6050.
+ *			 The fixed point version uses no floats and is meant for the Xmega, the float version for host builds.
+ *			 The gyroscope offsets need to be removed before the update, the accelerometer only needs to be
+ *			 in the same range for all axes because only the direction is used.
+ *			 This module does not depend on the rest of the library.
+ *
+ *	\code{.c}
+ 	mpu6050_fusion_fixed_t att;
+ 	fusion_init_fixed_mpu6050(&att, MPU6050_GYRO_SCL_250);
+ 	
+ 	while(1){
+ 		get_motion6_raw_mpu6050(&mpu, &frame);
+ 		fusion_update_fixed_mpu6050(&att, frame.accel, frame.gyro, 1000);	// 1000us between the frames
+ 	}
+ 	\endcode
+ */
+
+/*!	\copyright
+ *
+ *	MIT License
+ *
+ *	Copyright (c) 2021 TychoJ <br>
+ *  
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy <br>
+ *	of this software and associated documentation files (the "Software"), to deal <br>
+ *	in the Software without restriction, including without limitation the rights <br>
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell <br>
+ *	copies of the Software, and to permit persons to whom the Software is <br>
+ *	furnished to do so, subject to the following conditions: <br>
+ *  
+ *	The above copyright notice and this permission notice shall be included in all <br>
+ *	copies or substantial portions of the Software. <br>
+ *  
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR <br>
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, <br>
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE <br>
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER <br>
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, <br>
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE <br>
+ *	SOFTWARE.<br>
+ */
+
+#include <stdint.h>
+
+#ifndef MPU6050_FUSION_H_
+#define MPU6050_FUSION_H_
+
+/*
+ *	Default gains of the filter
+ */
+#define MPU6050_FUSION_KP		0.5f	//!< Proportional gain in rad/s per unit of error
+#define MPU6050_FUSION_KI		0.0f	//!< Integral gain in rad/s^2 per unit of error
+
+#define MPU6050_FUSION_MAX_DT	1000000	//!< Maximum time between two updates in us, larger values are clipped
+#define MPU6050_FUSION_MAX_DT_FIXED	50000	//!< Same for the fixed point filter, keeps the half angle in Q30 below 1 rad at 2000 degrees per second
+
+/*! \brief  Fixed point filter state
+ *
+ *	The quaternion is in Q30 (1 << 30 is 1.0), the order is w, x, y, z.
+ */
+typedef struct {
+	int32_t q[4];		//!< Orientation quaternion in Q30
+	int32_t integral[3];	//!< Integral feedback in rad/s Q24
+	int32_t kp;			//!< Proportional gain in Q16
+	int32_t ki;			//!< Integral gain in Q16
+	uint8_t gyro_scale;	//!< Range of the gyroscope samples, one of MPU6050_GYRO_SCL_x
+} mpu6050_fusion_fixed_t;
+
+/*! \brief  Float filter state
+ *
+ *	The order of the quaternion is w, x, y, z.
+ */
+typedef struct {
+	float q[4];			//!< Orientation quaternion
+	float integral[3];	//!< Integral feedback in rad/s
+	float kp;			//!< Proportional gain
+	float ki;			//!< Integral gain
+	uint8_t gyro_scale;	//!< Range of the gyroscope samples, one of MPU6050_GYRO_SCL_x
+} mpu6050_fusion_float_t;
+
+void fusion_init_fixed_mpu6050(mpu6050_fusion_fixed_t *f, uint8_t gyro_scale);
+void fusion_update_fixed_mpu6050(mpu6050_fusion_fixed_t *f, const int16_t *accel, const int16_t *gyro, uint32_t dt_us);
+
+void fusion_init_float_mpu6050(mpu6050_fusion_float_t *f, uint8_t gyro_scale);
+void fusion_update_float_mpu6050(mpu6050_fusion_float_t *f, const int16_t *accel, const int16_t *gyro, uint32_t dt_us);
+
+#endif /* MPU6050_FUSION_H_ */
@@ -0,0 +1,331 @@
+/*!
+ *  \file    mpu6050_log.c
+ *  \author  Tycho Jobsis
+ *  \date    04-04-2021
+ *  \version 0.1.0
+ *
+ *  \brief   Compact binary log format for raw MPU6050 frames
+ *
+ *  \details The differences are calculated modulo 2^16, so every difference of two int16 values fits in
+ *			 a varint of at most 3 bytes and the decoder gets the exact values back.
+ */
+
+/*!	\copyright
+ *
+ *	MIT License
+ *
+ *	Copyright (c) 2021 TychoJ
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#include "mpu6050_log.h"
+#include "mpu6050_store.h"
+
+/*! \brief  Stores a 16 bit value little endian
+ *
+ *	\note	This function is for internal use
+ *
+ *  \param  *buff	pointer to store the value
+ *	\param	value	value that needs to be stored
+ */
+static void put16_log_mpu6050(uint8_t *buff, uint16_t value){
+	buff[0] = value & 0xFF;
+	buff[1] = value >> 8;
+}
+
+/*! \brief  Stores a 32 bit value little endian
+ *
+ *	\note	This function is for internal use
+ *
+ *  \param  *buff	pointer to store the value
+ *	\param	value	value that needs to be stored
+ */
+static void put32_log_mpu6050(uint8_t *buff, uint32_t value){
+	put16_log_mpu6050(buff, value & 0xFFFF);
+	put16_log_mpu6050(buff + 2, value >> 16);
+}
+
+/*! \brief  Reads a 16 bit little endian value
+ *
+ *	\note	This function is for internal use
+ *
+ *  \param  *buff	pointer to the value
+ *
+ *  \return the value
+ */
+static uint16_t get16_log_mpu6050(const uint8_t *buff){
+	return ( (uint16_t) buff[1] << 8 ) | buff[0];
+}
+
+/*! \brief  Reads a 32 bit little endian value
+ *
+ *	\note	This function is for internal use
+ *
+ *  \param  *buff	pointer to the value
+ *
+ *  \return the value
+ */
+static uint32_t get32_log_mpu6050(const uint8_t *buff){
+	return ( (uint32_t) get16_log_mpu6050(buff + 2) << 16 ) | get16_log_mpu6050(buff);
+}
+
+/*! \brief  Starts a new block with the first frame
+ *
+ *	\note	This function is for internal use
+ *
+ *  \param  *enc	pointer to the encoder
+ *	\param	time_us	time of the first frame
+ */
+static void log_enc_start_mpu6050(mpu6050_log_enc_t *enc, uint32_t time_us){
+	uint8_t *buff = enc->buff;
+	
+	put16_log_mpu6050(buff, MPU6050_LOG_MAGIC);
+	buff[2] = MPU6050_LOG_VERSION;
+	buff[3] = (enc->dev->accel_state & 0x0F) | (enc->dev->gyro_state << 4);
+	buff[4] = enc->channels;
+	put16_log_mpu6050(buff + 8, enc->seq);
+	put32_log_mpu6050(buff + 10, time_us);
+	put32_log_mpu6050(buff + 14, enc->period_us);
+	
+	for(uint8_t i = 0; i < MPU6050_LOG_MOTION7; i++) enc->prev[i] = 0;
+	
+	enc->len = MPU6050_LOG_HEADER;
+}
+
+/*! \brief  Finishes the block that is built
+ *
+ *	\note	This function is for internal use
+ *
+ *  \param  *enc	pointer to the encoder
+ *
+ *  \return length of the block in bytes
+ */
+static uint16_t log_enc_finish_mpu6050(mpu6050_log_enc_t *enc){
+	uint8_t *buff = enc->buff;
+	uint16_t len = enc->len;
+	
+	buff[5] = enc->frames;
+	put16_log_mpu6050(buff + 6, len - MPU6050_LOG_HEADER);
+	put16_log_mpu6050(buff + len, crc16_mpu6050(buff, len));
+	
+	enc->frames = 0;
+	enc->len = 0;
+	enc->seq++;
+	
+	return len + MPU6050_LOG_CRC;
+}
+
+/*! \brief  Initializes the encoder
+ *
+ *	The ranges of the device are stored in the header when a block is started, call log_enc_flush_mpu6050
+ *	before the range is changed.
+ *
+ *  \param  *enc		pointer to the encoder
+ *	\param	*dev		pointer to the MPU6050 device of which the frames are logged
+ *	\param	*buff		pointer to the buffer of one block, at least MPU6050_LOG_BLOCK_MIN(channels) bytes
+ *	\param	size		size of buff
+ *	\param	channels	MPU6050_LOG_MOTION6 or MPU6050_LOG_MOTION7
+ *	\param	max_frames	frames after which a block is finished, at most MPU6050_LOG_MAX_FRAMES
+ *	\param	period_us	sample period that is stored in the header, for example get_sample_period_mpu6050
+ */
+void log_enc_init_mpu6050(mpu6050_log_enc_t *enc, mpu6050_dev_t *dev, uint8_t *buff, uint16_t size, uint8_t channels, uint8_t max_frames, uint32_t period_us){
+	if(channels != MPU6050_LOG_MOTION7) channels = MPU6050_LOG_MOTION6;
+	if(max_frames < 1) max_frames = 1;
+	
+	enc->dev = dev;
+	enc->buff = buff;
+	enc->size = size;
+	enc->len = 0;
+	enc->channels = channels;
+	enc->frames = 0;
+	enc->max_frames = max_frames;
+	enc->seq = 0;
+	enc->period_us = period_us;
+}
+
+/*! \brief  Adds one frame to the block
+ *
+ *	When the block has max_frames frames, or there is no room for another frame, the block is finished
+ *	and its length is returned. The block is in buff and needs to be stored or sent before the next frame is added.
+ *
+ *  \param  *enc	pointer to the encoder
+ *	\param	*frame	pointer to the raw frame
+ *
+ *  \return length of the finished block in bytes, 0 if the block is not finished
+ */
+uint16_t log_enc_put_mpu6050(mpu6050_log_enc_t *enc, const mpu6050_motion_t *frame){
+	int16_t value[MPU6050_LOG_MOTION7];
+	uint8_t *pos, n = 0;
+	uint16_t zz;
+	
+	if(enc->len == 0) log_enc_start_mpu6050(enc, frame->time_us);
+	
+	value[n++] = frame->accel[0];
+	value[n++] = frame->accel[1];
+	value[n++] = frame->accel[2];
+	if(enc->channels == MPU6050_LOG_MOTION7) value[n++] = frame->temp;
+	value[n++] = frame->gyro[0];
+	value[n++] = frame->gyro[1];
+	value[n++] = frame->gyro[2];
+	
+	pos = enc->buff + enc->len;
+	for(uint8_t i = 0; i < n; i++){
+		int16_t delta = (int16_t) (uint16_t) (value[i] - enc->prev[i]);	//!< Modulo 2^16
+		enc->prev[i] = value[i];
+		
+		zz = ((uint16_t) delta << 1) ^ (uint16_t) (delta >> 15);
+		while(zz >= 0x80){
+			*pos++ = (zz & 0x7F) | 0x80;
+			zz >>= 7;
+		}
+		*pos++ = zz;
+	}
+	enc->len = pos - enc->buff;
+	enc->frames++;
+	
+	if(enc->frames >= enc->max_frames || enc->len + 3 * n + MPU6050_LOG_CRC > enc->size){
+		return log_enc_finish_mpu6050(enc);
+	}
+	
+	return 0;
+}
+
+/*! \brief  Finishes the block with the frames that are in it
+ *
+ *  \param  *enc	pointer to the encoder
+ *
+ *  \return length of the block in buff in bytes, 0 if there are no frames
+ */
+uint16_t log_enc_flush_mpu6050(mpu6050_log_enc_t *enc){
+	if(enc->frames == 0) return 0;
+	return log_enc_finish_mpu6050(enc);
+}
+
+/*! \brief  Decodes one block
+ *
+ *	The time stamp of every frame is calculated from the time of the first frame and the sample period,
+ *	the temperature is 0 in blocks with MPU6050_LOG_MOTION6.
+ *
+ *  \param  *buff		pointer to the start of the block
+ *	\param	len			bytes that are available from buff
+ *	\param	*info		pointer to store the header of the block
+ *	\param	*frames		pointer to store the frames
+ *	\param	max_frames	maximum amount of frames that fit in frames
+ *	\param	*used		pointer to store the length of the block in bytes
+ *
+ *  \return 0 if succeeded, MPU6050_LOG_FULL if the block is valid but does not fit in frames, MPU6050_LOG_INVALID if the block is damaged or incomplete
+ */
+uint8_t log_dec_block_mpu6050(const uint8_t *buff, uint32_t len, mpu6050_log_info_t *info, mpu6050_motion_t *frames, uint16_t max_frames, uint16_t *used){
+	const uint8_t *pos, *end;
+	uint16_t payload, zz;
+	int16_t value[MPU6050_LOG_MOTION7], prev[MPU6050_LOG_MOTION7] = {0};
+	uint8_t shift;
+	
+	if(len < MPU6050_LOG_HEADER + MPU6050_LOG_CRC) return MPU6050_LOG_INVALID;
+	if(get16_log_mpu6050(buff) != MPU6050_LOG_MAGIC || buff[2] != MPU6050_LOG_VERSION) return MPU6050_LOG_INVALID;
+	
+	payload = get16_log_mpu6050(buff + 6);
+	if((uint32_t) MPU6050_LOG_HEADER + payload + MPU6050_LOG_CRC > len) return MPU6050_LOG_INVALID;
+	if(get16_log_mpu6050(buff + MPU6050_LOG_HEADER + payload) != crc16_mpu6050(buff, MPU6050_LOG_HEADER + payload)) return MPU6050_LOG_INVALID;
+	
+	info->accel_state = buff[3] & 0x0F;
+	info->gyro_state = buff[3] >> 4;
+	info->channels = buff[4];
+	info->frames = buff[5];
+	info->seq = get16_log_mpu6050(buff + 8);
+	info->time_us = get32_log_mpu6050(buff + 10);
+	info->period_us = get32_log_mpu6050(buff + 14);
+	
+	if(info->channels != MPU6050_LOG_MOTION6 && info->channels != MPU6050_LOG_MOTION7) return MPU6050_LOG_INVALID;
+	if(info->frames > max_frames) return MPU6050_LOG_FULL;
+	
+	pos = buff + MPU6050_LOG_HEADER;
+	end = pos + payload;
+	
+	for(uint16_t f = 0; f < info->frames; f++){
+		for(uint8_t i = 0; i < info->channels; i++){
+			zz = 0;
+			shift = 0;
+			do {
+				if(pos == end || shift > 14) return MPU6050_LOG_INVALID;
+				zz |= (uint16_t) (*pos & 0x7F) << shift;
+				shift += 7;
+			} while(*pos++ & 0x80);
+			
+			prev[i] = (int16_t) (uint16_t) (prev[i] + (uint16_t) ((zz >> 1) ^ -(zz & 1)));
+			value[i] = prev[i];
+		}
+		
+		frames[f].accel[0] = value[0];
+		frames[f].accel[1] = value[1];
+		frames[f].accel[2] = value[2];
+		frames[f].temp = (info->channels == MPU6050_LOG_MOTION7) ? value[3] : 0;
+		frames[f].gyro[0] = value[info->channels - 3];
+		frames[f].gyro[1] = value[info->channels - 2];
+		frames[f].gyro[2] = value[info->channels - 1];
+		frames[f].time_us = info->time_us + f * info->period_us;
+	}
+	
+	if(pos != end) return MPU6050_LOG_INVALID;
+	
+	*used = MPU6050_LOG_HEADER + payload + MPU6050_LOG_CRC;
+	
+	return 0;
+}
+
+/*! \brief  Decodes a recording of blocks
+ *
+ *	Damaged bytes are skipped until the next valid block, so a damaged block only loses its own frames.
+ *	Decoding stops at the first valid block that does not fit in frames.
+ *
+ *  \param  *buff		pointer to the recording
+ *	\param	len			length of the recording in bytes
+ *	\param	*frames		pointer to store the frames
+ *	\param	max_frames	maximum amount of frames that fit in frames
+ *	\param	*skipped	pointer to store the amount of bytes that were skipped or not decoded, can be 0
+ *
+ *  \return amount of decoded frames
+ */
+uint32_t log_decode_mpu6050(const uint8_t *buff, uint32_t len, mpu6050_motion_t *frames, uint32_t max_frames, uint32_t *skipped){
+	mpu6050_log_info_t info;
+	uint32_t pos = 0, count = 0, lost = 0;
+	uint16_t used;
+	uint8_t err;
+	
+	while(pos + MPU6050_LOG_HEADER + MPU6050_LOG_CRC <= len){
+		err = log_dec_block_mpu6050(buff + pos, len - pos, &info, frames + count, max_frames - count > MPU6050_LOG_MAX_FRAMES ?
+									MPU6050_LOG_MAX_FRAMES : max_frames - count, &used);
+		
+		if(err == MPU6050_LOG_FULL) break;
+		
+		if(err == 0){
+			count += info.frames;
+			pos += used;
+		}
+		else {
+			pos++;
+			lost++;
+		}
+	}
+	
+	if(skipped != 0) *skipped = lost + len - pos;
+	
+	return count;
+}
@@ -0,0 +1,114 @@
+/*!
+ *  \file    mpu6050_log.h
+ *  \author  Tycho Jobsis
+ *  \date    04-04-2021
+ *  \version 0.1.0
+ *
+ *  \brief   Compact binary log format for raw MPU6050 frames
+ *
+ *  \details Frames are stored in blocks that can be decoded on their own. Every block starts with a header
+ *			 with the accelerometer and gyroscope range, the time of the first frame and the sample period.
+ *			 Every value is stored as the difference with the same channel of the previous frame, zigzag 
+ *			 encoded so small negative differences are small numbers, in a varint of 1 to 3 bytes.
+ *			 A CRC-16 protects the block. The encoder handles one frame at a time and is meant for the Xmega,
+ *			 the decoder handles a whole recording and is meant for host builds.
+ *
+ *			 Block layout (little endian): magic (2), version (1), ranges (1, accel_state | gyro_state << 4),
+ *			 channels (1), frames (1), payload length (2), sequence number (2), time of the first frame in us (4),
+ *			 sample period in us (4), payload, CRC-16 of the header and the payload (2).
+ *
+ *	\code{.c}
+ 	mpu6050_log_enc_t log;
+ 	uint8_t block[256];
+ 	uint16_t len;
+ 	
+ 	log_enc_init_mpu6050(&log, &mpu, block, sizeof(block), MPU6050_LOG_MOTION6, 100, 1000);
+ 	
+ 	while(1){
+ 		if(acq_pop_mpu6050(&mpu, &frame)){
+ 			len = log_enc_put_mpu6050(&log, &frame);
+ 			if(len != 0) write_storage(block, len);	// block needs to be written before the next frame
+ 		}
+ 	}
+ 	\endcode
+ */
+
+/*!	\copyright
+ *
+ *	MIT License
+ *
+ *	Copyright (c) 2021 TychoJ <br>
+ *  
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy <br>
+ *	of this software and associated documentation files (the "Software"), to deal <br>
+ *	in the Software without restriction, including without limitation the rights <br>
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell <br>
+ *	copies of the Software, and to permit persons to whom the Software is <br>
+ *	furnished to do so, subject to the following conditions: <br>
+ *  
+ *	The above copyright notice and this permission notice shall be included in all <br>
+ *	copies or substantial portions of the Software. <br>
+ *  
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR <br>
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, <br>
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE <br>
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER <br>
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, <br>
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE <br>
+ *	SOFTWARE.<br>
+ */
+
+#include "mpu6050.h"
+
+#ifndef MPU6050_LOG_H_
+#define MPU6050_LOG_H_
+
+#define MPU6050_LOG_MAGIC		0x4C06
+#define MPU6050_LOG_VERSION		1
+#define MPU6050_LOG_HEADER		18		//!< Bytes in front of the payload of a block
+#define MPU6050_LOG_CRC			2		//!< Bytes after the payload of a block
+#define MPU6050_LOG_MAX_FRAMES	255		//!< Maximum amount of frames in one block
+
+/*
+ *	Channels of the logged frames
+ */
+#define MPU6050_LOG_MOTION6		6		//!< Accelerometer x, y, z and gyroscope x, y, z
+#define MPU6050_LOG_MOTION7		7		//!< Accelerometer x, y, z, temperature and gyroscope x, y, z
+
+#define MPU6050_LOG_BLOCK_MIN(channels)	(MPU6050_LOG_HEADER + 3 * (channels) + MPU6050_LOG_CRC)	//!< Smallest buffer that holds a block
+
+/*! \brief  State of the encoder
+ */
+typedef struct {
+	mpu6050_dev_t *dev;		//!< Device of which the ranges are logged
+	uint8_t *buff;			//!< Buffer of the block that is built
+	uint16_t size;			//!< Size of buff
+	uint16_t len;			//!< Bytes in buff
+	uint8_t channels;		//!< MPU6050_LOG_MOTION6 or MPU6050_LOG_MOTION7
+	uint8_t frames;			//!< Frames in the block that is built
+	uint8_t max_frames;		//!< Frames after which a block is finished
+	uint16_t seq;			//!< Sequence number of the block that is built
+	uint32_t period_us;		//!< Sample period that is stored in the header
+	int16_t prev[MPU6050_LOG_MOTION7];	//!< Values of the previous frame
+} mpu6050_log_enc_t;
+
+/*! \brief  Header of a decoded block
+ */
+typedef struct {
+	uint8_t accel_state;	//!< Accelerometer range, one of MPU6050_ACCEL_SCL_x
+	uint8_t gyro_state;		//!< Gyroscope range, one of MPU6050_GYRO_SCL_x
+	uint8_t channels;		//!< MPU6050_LOG_MOTION6 or MPU6050_LOG_MOTION7
+	uint8_t frames;			//!< Frames in the block
+	uint16_t seq;			//!< Sequence number, increments by one every block
+	uint32_t time_us;		//!< Time of the first frame
+	uint32_t period_us;		//!< Sample period
+} mpu6050_log_info_t;
+
+void log_enc_init_mpu6050(mpu6050_log_enc_t *enc, mpu6050_dev_t *dev, uint8_t *buff, uint16_t size, uint8_t channels, uint8_t max_frames, uint32_t period_us);
+uint16_t log_enc_put_mpu6050(mpu6050_log_enc_t *enc, const mpu6050_motion_t *frame);
+uint16_t log_enc_flush_mpu6050(mpu6050_log_enc_t *enc);
+
+uint8_t log_dec_block_mpu6050(const uint8_t *buff, uint32_t len, mpu6050_log_info_t *info, mpu6050_motion_t *frames, uint16_t max_frames, uint16_t *used);
+uint32_t log_decode_mpu6050(const uint8_t *buff, uint32_t len, mpu6050_motion_t *frames, uint32_t max_frames, uint32_t *skipped);
+
+#endif /* MPU6050_LOG_H_ */
@@ -0,0 +1,740 @@
+/*!
+ *  \file    mpu6050_sim.c
+ *  \author  Tycho Jobsis
+ *  \date    04-04-2021
+ *  \version 0.1.0
+ *
+ *  \brief   Simulated MPU6050 for host builds of the MPU6050 library
+ *
+ *  \details Samples are only made by sim_sample_mpu6050 and sim_step_mpu6050, the application decides
+ *			 how much time passes between two transactions.
+ */
+
+/*!	\copyright
+ *
+ *	MIT License
+ *
+ *	Copyright (c) 2021 TychoJ
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "mpu6050_sim.h"
+
+/*
+ *	Bits of the registers that the simulation uses
+ */
+#define SIM_DEVICE_RESET_bm		(1 << 7)	//!< MPU_6050_PWR_MGMT_1
+#define SIM_SLEEP_bm			(1 << 6)	//!< MPU_6050_PWR_MGMT_1
+#define SIM_CYCLE_bm			(1 << 5)	//!< MPU_6050_PWR_MGMT_1
+#define SIM_TEMP_DIS_bm			(1 << 3)	//!< MPU_6050_PWR_MGMT_1
+#define SIM_DATA_RDY_bm			(1 << 0)	//!< MPU_6050_INT_ENABLE and MPU_6050_INT_STATUS
+#define SIM_FIFO_OFLOW_bm		(1 << 4)	//!< MPU_6050_INT_ENABLE and MPU_6050_INT_STATUS
+#define SIM_MOT_bm				(1 << 6)	//!< MPU_6050_INT_ENABLE and MPU_6050_INT_STATUS
+#define SIM_USER_RESETS_bm		0x0F		//!< Self clearing reset bits of MPU_6050_USER_CTRL
+#define SIM_SLV_NACK_bm(n)		(1 << (n))	//!< MPU_6050_I2C_MST_STATUS
+
+static uint8_t sim_read_only_mpu6050(uint8_t reg);
+static uint8_t sim_fault_mpu6050(mpu6050_sim_t *sim);
+static void sim_fifo_put_mpu6050(mpu6050_sim_t *sim, uint8_t data);
+static void sim_fifo_count_mpu6050(mpu6050_sim_t *sim);
+static float sim_noise_mpu6050(mpu6050_sim_t *sim);
+static int16_t sim_raw_mpu6050(float value, int32_t offset);
+static void sim_bus_time_mpu6050(mpu6050_sim_t *sim, uint32_t bytes);
+static void sim_motion_mpu6050(mpu6050_sim_t *sim, const float *accel);
+static void sim_aux_mpu6050(mpu6050_sim_t *sim);
+
+/*! \brief  Initializes a simulated MPU6050
+ *
+ *	The registers have their power on values, the MPU6050 is in sleep mode. The sensors read 0
+ *	without bias and noise.
+ *
+ *  \param  *sim	pointer to the simulated MPU6050
+ *	\param	addr	address the simulated MPU6050 responds to
+ */
+void sim_init_mpu6050(mpu6050_sim_t *sim, uint8_t addr){
+	memset(sim, 0, sizeof(*sim));
+	
+	sim->addr = addr;
+	sim->bus_hz = 400000;
+	sim->temp = 25.0f;
+	sim->seed = 0x6050;
+	
+	sim_reset_mpu6050(sim);
+}
+
+/*! \brief  Resets the registers, the FIFO and the memory of the simulated MPU6050
+ *
+ *	The sensor values, bias, noise and the counters are not changed.
+ *
+ *  \param  *sim	pointer to the simulated MPU6050
+ */
+void sim_reset_mpu6050(mpu6050_sim_t *sim){
+	memset(sim->regs, 0, sizeof(sim->regs));
+	memset(sim->mem, 0, sizeof(sim->mem));
+	
+	sim->regs[MPU_6050_PWR_MGMT_1] = SIM_SLEEP_bm;
+	sim->regs[MPU_6050_WHO_AM_I] = MPU6050_ADDRESS;
+	
+	sim->fifo_head = 0;
+	sim->fifo_count = 0;
+	sim->time_us = 0;
+}
+
+/*! \brief  Makes a transport that is connected to the simulated MPU6050
+ *
+ *  \param  *sim	pointer to the simulated MPU6050
+ *	\param	*bus	pointer to store the transport, use it with init_bus_mpu6050
+ */
+void sim_bus_mpu6050(mpu6050_sim_t *sim, mpu6050_bus_t *bus){
+	bus->read = sim_read_mpu6050;
+	bus->write = sim_write_mpu6050;
+	bus->ctx = sim;
+	bus->recover = sim_recover_mpu6050;
+	bus->read_async = sim_read_async_mpu6050;
+}
+
+/*! \brief  Sets the transaction and byte counters to 0
+ *
+ *  \param  *sim	pointer to the simulated MPU6050
+ */
+void sim_clear_counters_mpu6050(mpu6050_sim_t *sim){
+	sim->transactions = 0;
+	sim->read_bytes = 0;
+	sim->write_bytes = 0;
+	sim->wire_bytes = 0;
+	sim->nacks = 0;
+	sim->recoveries = 0;
+}
+
+/*! \brief  Checks if a register can only be read
+ *
+ *	\note	This function is for internal use
+ *
+ *  \param  reg		register address
+ *
+ *  \return 1 if writes to the register are ignored, 0 otherwise
+ */
+static uint8_t sim_read_only_mpu6050(uint8_t reg){
+	if(reg >= MPU_6050_INT_STATUS && reg <= MPU_6050_EXT_SENS_DATA_23) return 1;
+	if(reg == MPU_6050_I2C_MST_STATUS) return 1;
+	if(reg == MPU_6050_FIFO_COUNTH || reg == MPU_6050_FIFO_COUNTL) return 1;
+	if(reg == MPU_6050_WHO_AM_I) return 1;
+	return 0;
+}
+
+/*! \brief  Copies the amount of bytes in the FIFO to the FIFO count registers
+ *
+ *	\note	This function is for internal use
+ *
+ *  \param  *sim	pointer to the simulated MPU6050
+ */
+static void sim_fifo_count_mpu6050(mpu6050_sim_t *sim){
+	sim->regs[MPU_6050_FIFO_COUNTH] = sim->fifo_count >> 8;
+	sim->regs[MPU_6050_FIFO_COUNTL] = sim->fifo_count & 0xFF;
+}
+
+/*! \brief  Adds one byte to the FIFO, a full FIFO loses its oldest byte
+ *
+ *	\note	This function is for internal use
+ *
+ *  \param  *sim	pointer to the simulated MPU6050
+ *	\param	data	byte that is added
+ */
+static void sim_fifo_put_mpu6050(mpu6050_sim_t *sim, uint8_t data){
+	if(sim->fifo_count == MPU6050_FIFO_SIZE){
+		sim->fifo_head = (sim->fifo_head + 1) % MPU6050_FIFO_SIZE;
+		sim->fifo_count--;
+		if(sim->regs[MPU_6050_INT_ENABLE] & SIM_FIFO_OFLOW_bm) sim->regs[MPU_6050_INT_STATUS] |= SIM_FIFO_OFLOW_bm;
+	}
+	
+	sim->fifo[(sim->fifo_head + sim->fifo_count) % MPU6050_FIFO_SIZE] = data;
+	sim->fifo_count++;
+}
+
+/*! \brief  Adds bytes to the FIFO, for example packets of the Digital Motion Processor
+ *
+ *  \param  *sim	pointer to the simulated MPU6050
+ *	\param	*data	pointer to the bytes
+ *	\param	len		amount of bytes
+ */
+void sim_fifo_push_mpu6050(mpu6050_sim_t *sim, const uint8_t *data, uint16_t len){
+	for(uint16_t i = 0; i < len; i++) sim_fifo_put_mpu6050(sim, data[i]);
+	sim_fifo_count_mpu6050(sim);
+}
+
+/*! \brief  Checks if a transaction fails because of an injected fault
+ *
+ *	\note	This function is for internal use
+ *
+ *  \param  *sim	pointer to the simulated MPU6050
+ *
+ *  \return TWI_STATUS_OK if the transaction can continue, the status code of the fault otherwise
+ */
+static uint8_t sim_fault_mpu6050(mpu6050_sim_t *sim){
+	if(sim->stuck) return BUS_IN_USE;
+	
+	if(sim->fail_count > 0){
+		sim->fail_count--;
+		return sim->fail_status;
+	}
+	
+	return TWI_STATUS_OK;
+}
+
+/*! \brief  Frees the bus of the simulated MPU6050
+ *
+ *  \param  *ctx	pointer to the simulated MPU6050
+ *
+ *  \return TWI_STATUS_OK
+ */
+uint8_t sim_recover_mpu6050(void *ctx){
+	mpu6050_sim_t *sim = (mpu6050_sim_t *) ctx;
+	
+	sim->stuck = 0;
+	sim->recoveries++;
+	
+	return TWI_STATUS_OK;
+}
+
+/*! \brief  Starts an asynchronous read of the simulated MPU6050
+ *
+ *	The read is done when sim_isr_async_mpu6050 is called, like the TWI master interrupt does on the Xmega.
+ *
+ *  \param  *ctx	pointer to the simulated MPU6050
+ *	\param	addr	address of the MPU6050
+ *	\param	reg		first register that needs to be read
+ *	\param	*data	pointer to store the register values
+ *	\param	len		amount of registers that need to be read
+ *	\param	done	function that is called when the read is finished
+ *	\param	*arg		passed to done
+ *
+ *  \return TWI_STATUS_OK if the read is started, BUS_IN_USE if a read is pending or the bus is stuck
+ */
+uint8_t sim_read_async_mpu6050(void *ctx, uint8_t addr, uint8_t reg, uint8_t *data, uint16_t len, mpu6050_done_t done, void *arg){
+	mpu6050_sim_t *sim = (mpu6050_sim_t *) ctx;
+	
+	if(sim->async_pending || sim->stuck) return BUS_IN_USE;
+	
+	sim->async_pending = 1;
+	sim->async_addr = addr;
+	sim->async_reg = reg;
+	sim->async_data = data;
+	sim->async_len = len;
+	sim->async_done = done;
+	sim->async_arg = arg;
+	
+	return TWI_STATUS_OK;
+}
+
+/*! \brief  Finishes the pending asynchronous read of the simulated MPU6050
+ *
+ *	Does nothing if no read is pending. The injected faults apply to the read.
+ *
+ *  \param  *sim	pointer to the simulated MPU6050
+ */
+void sim_isr_async_mpu6050(mpu6050_sim_t *sim){
+	uint8_t err;
+	
+	if(!sim->async_pending) return;
+	
+	sim->async_pending = 0;	//!< done can start the next read
+	err = sim_read_mpu6050(sim, sim->async_addr, sim->async_reg, sim->async_data, sim->async_len);
+	
+	sim->async_done(sim->async_arg, err);
+}
+
+/*! \brief  Reads registers of the simulated MPU6050
+ *
+ *	The register pointer increments after every byte, except on MPU_6050_FIFO_R_W and MPU_6050_MEM_R_W.
+ *	Reading MPU_6050_INT_STATUS clears it.
+ *
+ *  \param  *ctx	pointer to the simulated MPU6050
+ *	\param	addr	address of the MPU6050
+ *	\param	reg		first register that needs to be read
+ *	\param	*data	pointer to store the register values
+ *	\param	len		amount of registers that need to be read
+ *
+ *  \return TWI_STATUS_OK, NACK if addr is not the address of the simulated MPU6050, the status code of an injected fault,
+ *			BUS_IN_USE while an asynchronous read is pending
+ */
+uint8_t sim_read_mpu6050(void *ctx, uint8_t addr, uint8_t reg, uint8_t *data, uint16_t len){
+	mpu6050_sim_t *sim = (mpu6050_sim_t *) ctx;
+	uint16_t pos;
+	uint8_t err;
+	
+	if(sim->async_pending) return BUS_IN_USE;	//!< Like the TWI module that is busy with the asynchronous read
+	
+	sim->transactions++;
+	
+	err = sim_fault_mpu6050(sim);
+	if(err != TWI_STATUS_OK) return err;
+	
+	if(addr != sim->addr){
+		sim->nacks++;
+		sim->wire_bytes++;
+		return NACK;
+	}
+	
+	sim->read_bytes += len;
+	sim->wire_bytes += len + 3;	//!< Write address, register pointer and read address
+	sim_bus_time_mpu6050(sim, len + 3);
+	
+	for(uint16_t i = 0; i < len; i++){
+		reg &= MPU6050_SIM_REGS - 1;
+		
+		if(reg == MPU_6050_FIFO_R_W){
+			if(sim->fifo_count > 0){
+				data[i] = sim->fifo[sim->fifo_head];
+				sim->fifo_head = (sim->fifo_head + 1) % MPU6050_FIFO_SIZE;
+				sim->fifo_count--;
+			}
+			else {
+				data[i] = 0;
+			}
+			sim_fifo_count_mpu6050(sim);
+			continue;
+		}
+		
+		if(reg == MPU_6050_MEM_R_W){
+			pos = ((uint16_t) sim->regs[MPU_6050_BANK_SEL] << 8) | sim->regs[MPU_6050_MEM_START_ADDR];
+			data[i] = sim->mem[pos % MPU6050_SIM_MEM_SIZE];
+			sim->regs[MPU_6050_MEM_START_ADDR]++;
+			continue;
+		}
+		
+		data[i] = sim->regs[reg];
+		if(reg == MPU_6050_INT_STATUS) sim->regs[reg] = 0;
+		reg++;
+	}
+	
+	return TWI_STATUS_OK;
+}
+
+/*! \brief  Writes registers of the simulated MPU6050
+ *
+ *	The register pointer increments after every byte, except on MPU_6050_FIFO_R_W and MPU_6050_MEM_R_W.
+ *	Writes to read only registers are ignored, the reset bits clear themselves.
+ *
+ *  \param  *ctx	pointer to the simulated MPU6050
+ *	\param	addr	address of the MPU6050
+ *	\param	reg		first register that needs to be written
+ *	\param	*data	pointer to the new register values
+ *	\param	len		amount of registers that need to be written
+ *
+ *  \return TWI_STATUS_OK, NACK if addr is not the address of the simulated MPU6050, the status code of an injected fault,
+ *			BUS_IN_USE while an asynchronous read is pending
+ */
+uint8_t sim_write_mpu6050(void *ctx, uint8_t addr, uint8_t reg, const uint8_t *data, uint16_t len){
+	mpu6050_sim_t *sim = (mpu6050_sim_t *) ctx;
+	uint16_t pos;
+	uint8_t err;
+	
+	if(sim->async_pending) return BUS_IN_USE;	//!< Like the TWI module that is busy with the asynchronous read
+	
+	sim->transactions++;
+	
+	err = sim_fault_mpu6050(sim);
+	if(err != TWI_STATUS_OK) return err;
+	
+	if(addr != sim->addr){
+		sim->nacks++;
+		sim->wire_bytes++;
+		return NACK;
+	}
+	
+	sim->write_bytes += len;
+	sim->wire_bytes += len + 2;	//!< Write address and register pointer
+	sim_bus_time_mpu6050(sim, len + 2);
+	
+	for(uint16_t i = 0; i < len; i++){
+		reg &= MPU6050_SIM_REGS - 1;
+		
+		if(reg == MPU_6050_FIFO_R_W){
+			sim_fifo_push_mpu6050(sim, &data[i], 1);
+			continue;
+		}
+		
+		if(reg == MPU_6050_MEM_R_W){
+			pos = ((uint16_t) sim->regs[MPU_6050_BANK_SEL] << 8) | sim->regs[MPU_6050_MEM_START_ADDR];
+			sim->mem[pos % MPU6050_SIM_MEM_SIZE] = data[i];
+			sim->regs[MPU_6050_MEM_START_ADDR]++;
+			continue;
+		}
+		
+		if(!sim_read_only_mpu6050(reg)){
+			sim->regs[reg] = data[i];
+			
+			if(reg == MPU_6050_PWR_MGMT_1 && (data[i] & SIM_DEVICE_RESET_bm)){
+				sim_reset_mpu6050(sim);
+			}
+			else if(reg == MPU_6050_USER_CTRL){
+				if(data[i] & MPU6050_USER_FIFO_RESET_bm){
+					sim->fifo_head = 0;
+					sim->fifo_count = 0;
+					sim_fifo_count_mpu6050(sim);
+				}
+				sim->regs[reg] &= ~SIM_USER_RESETS_bm;
+			}
+			else if(reg == MPU_6050_SIGNAL_PATH_RESET){
+				sim->regs[reg] = 0;
+			}
+		}
+		
+		reg++;
+	}
+	
+	return TWI_STATUS_OK;
+}
+
+/*! \brief  Get the time between two samples with the current configuration
+ *
+ *  \param  *sim	pointer to the simulated MPU6050
+ *
+ *  \return sample period in us, the wake up period in cycle mode
+ */
+uint32_t sim_period_us_mpu6050(mpu6050_sim_t *sim){
+	static const uint32_t wake_us[4] = {800000, 200000, 50000, 25000};
+	uint8_t dlpf = sim->regs[MPU_6050_CONFIG] & 0x07;
+	uint32_t gyro_us = (dlpf == 0 || dlpf == 7) ? 125 : 1000;
+	
+	if(sim->regs[MPU_6050_PWR_MGMT_1] & SIM_CYCLE_bm) return wake_us[sim->regs[MPU_6050_PWR_MGMT_2] >> 6];
+	
+	return gyro_us * ((uint32_t) sim->regs[MPU_6050_SMPLRT_DIV] + 1);
+}
+
+/*! \brief  Gaussian noise with a standard deviation of 1
+ *
+ *	\note	This function is for internal use
+ *
+ *	The sum of 12 uniform values is close enough to a normal distribution for the simulation.
+ *
+ *  \param  *sim	pointer to the simulated MPU6050
+ *
+ *  \return noise value
+ */
+static float sim_noise_mpu6050(mpu6050_sim_t *sim){
+	float sum = 0.0f;
+	
+	for(uint8_t i = 0; i < 12; i++){
+		sim->seed ^= sim->seed << 13;	//!< xorshift32
+		sim->seed ^= sim->seed >> 17;
+		sim->seed ^= sim->seed << 5;
+		sum += (float) sim->seed / 4294967296.0f;
+	}
+	
+	return sum - 6.0f;
+}
+
+/*! \brief  Converts a sensor value to a raw value
+ *
+ *	\note	This function is for internal use
+ *
+ *  \param  value	sensor value in LSB
+ *	\param	offset	value of the offset register in LSB
+ *
+ *  \return raw value, saturated to 16 bits
+ */
+static int16_t sim_raw_mpu6050(float value, int32_t offset){
+	float raw = value + (float) offset;
+	
+	raw += (raw < 0.0f) ? -0.5f : 0.5f;
+	if(raw > 32767.0f) return 32767;
+	if(raw < -32768.0f) return -32768;
+	
+	return (int16_t) raw;
+}
+
+/*! \brief  Motion detection of one accelerometer sample
+ *
+ *	\note	This function is for internal use
+ *
+ *	The high pass filter is modelled as the difference with the previous sample. Motion is detected when
+ *	one of the axes is above MPU_6050_MOT_THR for MPU_6050_MOT_DUR samples in a row.
+ *
+ *  \param  *sim	pointer to the simulated MPU6050
+ *	\param	*accel	acceleration of the x, y and z-axis in g
+ */
+static void sim_motion_mpu6050(mpu6050_sim_t *sim, const float *accel){
+	float threshold = sim->regs[MPU_6050_MOT_THR] * 0.002f;
+	uint8_t above = 0;
+	
+	for(uint8_t i = 0; i < 3; i++){
+		float diff = accel[i] - sim->mot_ref[i];
+		
+		if(diff > threshold || diff < -threshold) above = 1;
+		sim->mot_ref[i] = accel[i];
+	}
+	
+	if(!above || !(sim->regs[MPU_6050_INT_ENABLE] & SIM_MOT_bm)){
+		sim->mot_count = 0;
+		return;
+	}
+	
+	if(sim->mot_count < 255) sim->mot_count++;
+	if(sim->mot_count >= sim->regs[MPU_6050_MOT_DUR]) sim->regs[MPU_6050_INT_STATUS] |= SIM_MOT_bm;
+}
+
+/*! \brief  Accesses the slaves of the auxiliary I2C master after a sample
+ *
+ *	\note	This function is for internal use
+ *
+ *	Every enabled slave gets its part of the external sensor data registers in the order of the slave numbers,
+ *	a delayed slave keeps its old data when it is not accessed. Only ext_addr acknowledges, 
+ *	the other addresses set the NACK bit of the slave in MPU_6050_I2C_MST_STATUS.
+ *
+ *  \param  *sim	pointer to the simulated MPU6050
+ */
+static void sim_aux_mpu6050(mpu6050_sim_t *sim){
+	uint8_t addr, reg, ctrl, len, pos = 0;
+	uint8_t dly = sim->regs[MPU_6050_I2C_SLV4_CTRL] & MPU6050_MST_DLY_gm;
+	
+	if(!(sim->regs[MPU_6050_USER_CTRL] & MPU6050_USER_I2C_MST_EN_bm)) return;
+	
+	for(uint8_t n = 0; n < MPU6050_AUX_SLAVES; n++){
+		addr = sim->regs[MPU_6050_I2C_SLV0_ADDR + 3 * n];
+		reg = sim->regs[MPU_6050_I2C_SLV0_REG + 3 * n];
+		ctrl = sim->regs[MPU_6050_I2C_SLV0_CTRL + 3 * n];
+		len = ctrl & MPU6050_SLV_LEN_gm;
+		
+		if(!(ctrl & MPU6050_SLV_EN_bm)) continue;
+		if(addr & MPU6050_SLV_READ_bm){
+			if(pos + len > MPU6050_EXT_SENS_BYTES) len = MPU6050_EXT_SENS_BYTES - pos;
+			pos += len;
+		}
+		
+		if((sim->regs[MPU_6050_I2C_MST_DELAY_CTRL] & (1 << n)) && (sim->samples % (dly + 1)) != 0) continue;
+		
+		if((addr & ~MPU6050_SLV_READ_bm) != sim->ext_addr){
+			sim->regs[MPU_6050_I2C_MST_STATUS] |= SIM_SLV_NACK_bm(n);
+			continue;
+		}
+		
+		if(addr & MPU6050_SLV_READ_bm){
+			for(uint8_t i = 0; i < len; i++) sim->regs[MPU_6050_EXT_SENS_DATA_00 + pos - len + i] = sim->ext_regs[(uint8_t) (reg + i)];
+		}
+		else {
+			sim->ext_regs[reg] = sim->regs[MPU_6050_I2C_SLV0_DO + n];
+		}
+	}
+}
+
+/*! \brief  Makes one sample
+ *
+ *	The data registers are updated, the sample is added to the FIFO as configured in MPU_6050_FIFO_EN and
+ *	MPU_6050_USER_CTRL and the data ready interrupt is set if it is enabled. Nothing happens in sleep mode.
+ *
+ *  \param  *sim	pointer to the simulated MPU6050
+ */
+void sim_sample_mpu6050(mpu6050_sim_t *sim){
+	uint8_t afs, fs, stby, fifo_en, *out;
+	int16_t accel[3], gyro[3], temp = 0;
+	int32_t offset;
+	
+	float g[3];
+	
+	if(sim->regs[MPU_6050_PWR_MGMT_1] & SIM_SLEEP_bm) return;
+	
+	for(uint8_t i = 0; i < 3; i++) g[i] = sim->accel[i] + sim->accel_bias[i] + sim->accel_noise * sim_noise_mpu6050(sim);
+	sim_motion_mpu6050(sim, g);
+	
+	afs = (sim->regs[MPU_6050_ACCEL_CONFIG] >> 3) & 0x03;
+	fs = (sim->regs[MPU_6050_GYRO_CONFIG] >> 3) & 0x03;
+	stby = sim->regs[MPU_6050_PWR_MGMT_2];
+	
+	for(uint8_t i = 0; i < 3; i++){
+		// Offset registers: accelerometer in the +-16G range with bit 0 reserved, gyroscope in the +-1000 range
+		offset = (int16_t) ((sim->regs[MPU_6050_XA_OFFS_H + 2 * i] << 8) | sim->regs[MPU_6050_XA_OFFS_L + 2 * i]);
+		accel[i] = sim_raw_mpu6050(g[i] * (16384 >> afs),
+								   (offset & ~1) * (8 >> afs));
+		if(stby & (1 << (5 - i))) accel[i] = 0;
+		
+		offset = (int16_t) ((sim->regs[MPU_6050_XG_OFFS_USRH + 2 * i] << 8) | sim->regs[MPU_6050_XG_OFFS_USRL + 2 * i]);
+		gyro[i] = sim_raw_mpu6050((sim->gyro[i] + sim->gyro_bias[i] + sim->gyro_noise * sim_noise_mpu6050(sim)) * 32768.0f / (250 << fs),
+								  offset * 4 / (1 << fs));
+		if(stby & (1 << (2 - i))) gyro[i] = 0;
+	}
+	
+	if(!(sim->regs[MPU_6050_PWR_MGMT_1] & SIM_TEMP_DIS_bm)) temp = sim_raw_mpu6050((sim->temp - 36.53f) * 340.0f, 0);
+	
+	out = &sim->regs[MPU_6050_ACCEL_XOUT_H];
+	for(uint8_t i = 0; i < 3; i++){
+		*out++ = (uint16_t) accel[i] >> 8;
+		*out++ = accel[i] & 0xFF;
+	}
+	*out++ = (uint16_t) temp >> 8;
+	*out++ = temp & 0xFF;
+	for(uint8_t i = 0; i < 3; i++){
+		*out++ = (uint16_t) gyro[i] >> 8;
+		*out++ = gyro[i] & 0xFF;
+	}
+	
+	sim_aux_mpu6050(sim);
+	
+	if(sim->regs[MPU_6050_USER_CTRL] & MPU6050_USER_FIFO_EN_bm){
+		fifo_en = sim->regs[MPU_6050_FIFO_EN];
+		out = &sim->regs[MPU_6050_ACCEL_XOUT_H];
+		
+		if(fifo_en & MPU6050_FIFO_ACCEL_bm) sim_fifo_push_mpu6050(sim, out, 6);
+		if(fifo_en & MPU6050_FIFO_TEMP_bm) sim_fifo_push_mpu6050(sim, out + 6, 2);
+		if(fifo_en & MPU6050_FIFO_XG_bm) sim_fifo_push_mpu6050(sim, out + 8, 2);
+		if(fifo_en & MPU6050_FIFO_YG_bm) sim_fifo_push_mpu6050(sim, out + 10, 2);
+		if(fifo_en & MPU6050_FIFO_ZG_bm) sim_fifo_push_mpu6050(sim, out + 12, 2);
+	}
+	
+	if(sim->regs[MPU_6050_INT_ENABLE] & SIM_DATA_RDY_bm) sim->regs[MPU_6050_INT_STATUS] |= SIM_DATA_RDY_bm;
+	
+	sim->samples++;
+}
+
+/*! \brief  Lets the duration of a transaction pass
+ *
+ *	\note	This function is for internal use
+ *
+ *	Every byte takes 9 clocks, the start and stop condition 1 clock each. The samples of the transaction
+ *	are made after the transaction, the registers that were read are from before the transaction.
+ *
+ *  \param  *sim	pointer to the simulated MPU6050
+ *	\param	bytes	amount of bytes on the bus, including the address and register bytes
+ */
+static void sim_bus_time_mpu6050(mpu6050_sim_t *sim, uint32_t bytes){
+	if(sim->bus_hz == 0) return;
+	
+	sim->bus_ns += (uint32_t) (((uint64_t) bytes * 9 + 2) * 1000000000ULL / sim->bus_hz);
+	sim_step_mpu6050(sim, sim->bus_ns / 1000);
+	sim->bus_ns %= 1000;
+}
+
+/*! \brief  Lets time pass, a sample is made at every sample period
+ *
+ *  \param  *sim	pointer to the simulated MPU6050
+ *	\param	us		time in us
+ */
+void sim_step_mpu6050(mpu6050_sim_t *sim, uint32_t us){
+	uint32_t period = sim_period_us_mpu6050(sim);
+	
+	sim->time_us += us;
+	
+	while(sim->time_us >= period){
+		sim->time_us -= period;
+		sim_sample_mpu6050(sim);
+	}
+}
+
+/*! \brief  Get the level of the INT pin
+ *
+ *  \param  *sim	pointer to the simulated MPU6050
+ *
+ *  \return 1 if an enabled interrupt is pending, 0 otherwise
+ */
+uint8_t sim_int_pin_mpu6050(mpu6050_sim_t *sim){
+	return (sim->regs[MPU_6050_INT_STATUS] & sim->regs[MPU_6050_INT_ENABLE]) != 0;
+}
+
+/*! \brief  Initializes a simulated USART
+ *
+ *  \param  *usart	pointer to the simulated USART
+ *	\param	baud	baud rate
+ *	\param	*out	pointer to store the sent bytes
+ *	\param	size	size of out
+ */
+void sim_usart_init_mpu6050(mpu6050_sim_usart_t *usart, uint32_t baud, uint8_t *out, uint32_t size){
+	usart->baud = baud;
+	usart->out = out;
+	usart->size = size;
+	usart->len = 0;
+	usart->src = 0;
+	usart->remaining = 0;
+	usart->ns = 0;
+	usart->transfers = 0;
+	usart->overruns = 0;
+}
+
+/*! \brief  Starts a transfer of the simulated USART
+ *
+ *	\note	This function is for internal use
+ *
+ *  \param  *ctx	pointer to the simulated USART
+ *	\param	*data	pointer to the bytes
+ *	\param	len		amount of bytes
+ *
+ *  \return 0 if the transfer is started, 1 if the previous transfer is not finished
+ */
+static uint8_t sim_usart_start_mpu6050(void *ctx, const uint8_t *data, uint16_t len){
+	mpu6050_sim_usart_t *usart = (mpu6050_sim_usart_t *) ctx;
+	
+	if(usart->remaining != 0) return 1;
+	
+	usart->src = data;
+	usart->remaining = len;
+	usart->transfers++;
+	
+	return 0;
+}
+
+/*! \brief  Checks if the simulated USART is sending
+ *
+ *	\note	This function is for internal use
+ *
+ *  \param  *ctx	pointer to the simulated USART
+ *
+ *  \return 1 while a transfer is running, 0 otherwise
+ */
+static uint8_t sim_usart_busy_mpu6050(void *ctx){
+	return ((mpu6050_sim_usart_t *) ctx)->remaining != 0;
+}
+
+/*! \brief  Makes a stream sink of the simulated USART
+ *
+ *  \param  *usart	pointer to the simulated USART
+ *	\param	*sink	pointer to store the sink, use it with stream_init_mpu6050
+ */
+void sim_usart_sink_mpu6050(mpu6050_sim_usart_t *usart, mpu6050_sink_t *sink){
+	sink->start = sim_usart_start_mpu6050;
+	sink->busy = sim_usart_busy_mpu6050;
+	sink->ctx = usart;
+}
+
+/*! \brief  Lets time pass, the bytes of the running transfer are sent at the baud rate
+ *
+ *  \param  *usart	pointer to the simulated USART
+ *	\param	us		time in us
+ */
+void sim_usart_step_mpu6050(mpu6050_sim_usart_t *usart, uint32_t us){
+	uint32_t byte_ns = (uint32_t) (10000000000ULL / usart->baud);
+	
+	if(usart->remaining == 0){
+		usart->ns = 0;	//!< An idle USART starts the next byte right away
+		return;
+	}
+	
+	usart->ns += us * 1000;
+	
+	while(usart->remaining != 0 && usart->ns >= byte_ns){
+		usart->ns -= byte_ns;
+		if(usart->len < usart->size) usart->out[usart->len++] = *usart->src;
+		else usart->overruns++;
+		usart->src++;
+		usart->remaining--;
+	}
+	
+	if(usart->remaining == 0) usart->ns = 0;
+}
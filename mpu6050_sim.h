@@ -0,0 +1,154 @@
+/*!
+ *  \file    mpu6050_sim.h
+ *  \author  Tycho Jobsis
+ *  \date    04-04-2021
+ *  \version 0.1.0
+ *
+ *  \brief   Simulated MPU6050 for host builds of the MPU6050 library
+ *
+ *  \details The simulation models the register map with the auto incrementing register pointer, the FIFO,
+ *			 the interrupt status, the motion detection, the offset registers, the memory of the Digital Motion Processor
+ *			 and one external sensor on the auxiliary I2C bus.
+ *			 The sensor values are set in physical units, bias and gaussian noise are added to every sample.
+ *			 Every transaction and byte on the bus is counted, so the cost of a driver function can be measured.
+ *			 Time passes with sim_step_mpu6050 and with the duration of every transaction on the bus.
+ *
+ *	\code{.c}
+ 	mpu6050_sim_t sim;
+ 	mpu6050_bus_t bus;
+ 	mpu6050_dev_t mpu;
+ 	
+ 	sim_init_mpu6050(&sim, MPU6050_ADDRESS);
+ 	sim_bus_mpu6050(&sim, &bus);
+ 	init_bus_mpu6050(&mpu, &bus, MPU6050_ADDRESS);
+ 	
+ 	sim.accel[2] = 1.0f;
+ 	sim_step_mpu6050(&sim, 1000);		// 1ms of samples
+ 	get_motion6_raw_mpu6050(&mpu, &frame);
+ 	\endcode
+ */
+
+/*!	\copyright
+ *
+ *	MIT License
+ *
+ *	Copyright (c) 2021 TychoJ <br>
+ *  
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy <br>
+ *	of this software and associated documentation files (the "Software"), to deal <br>
+ *	in the Software without restriction, including without limitation the rights <br>
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell <br>
+ *	copies of the Software, and to permit persons to whom the Software is <br>
+ *	furnished to do so, subject to the following conditions: <br>
+ *  
+ *	The above copyright notice and this permission notice shall be included in all <br>
+ *	copies or substantial portions of the Software. <br>
+ *  
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR <br>
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, <br>
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE <br>
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER <br>
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, <br>
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE <br>
+ *	SOFTWARE.<br>
+ */
+
+#include "mpu6050.h"
+#include "mpu6050_stream.h"
+
+#ifndef MPU6050_SIM_H_
+#define MPU6050_SIM_H_
+
+#define MPU6050_SIM_REGS		128		//!< Size of the register map
+#define MPU6050_SIM_MEM_SIZE	4096	//!< Size of the memory of the Digital Motion Processor
+
+/*! \brief  State of one simulated MPU6050
+ *
+ *	The sensor values, bias and noise can be changed at any time, they are used for the next sample.
+ */
+typedef struct {
+	uint8_t addr;						//!< Address the simulated MPU6050 responds to
+	uint8_t regs[MPU6050_SIM_REGS];		//!< Register map
+	uint8_t mem[MPU6050_SIM_MEM_SIZE];	//!< Memory of the Digital Motion Processor
+	uint8_t fifo[MPU6050_FIFO_SIZE];	//!< FIFO
+	uint16_t fifo_head;					//!< Index of the oldest byte in the FIFO
+	uint16_t fifo_count;				//!< Amount of bytes in the FIFO
+	
+	float accel[3];			//!< Acceleration of the x, y and z-axis in g
+	float gyro[3];			//!< Rotational velocity of the x, y and z-axis in degrees per second
+	float temp;				//!< Temperature in degrees Celsius
+	float accel_bias[3];	//!< Offset that is added to every accelerometer sample in g
+	float gyro_bias[3];		//!< Offset that is added to every gyroscope sample in degrees per second
+	float accel_noise;		//!< Standard deviation of the accelerometer noise in g
+	float gyro_noise;		//!< Standard deviation of the gyroscope noise in degrees per second
+	uint32_t seed;			//!< State of the noise generator, may not be 0
+	
+	uint8_t ext_addr;		//!< Address of the external sensor on the auxiliary I2C bus
+	uint8_t ext_regs[256];	//!< Registers of the external sensor, read and written by the auxiliary I2C master
+	
+	uint32_t bus_hz;		//!< Clock of the I2C bus, every transaction lets the time on the bus pass, 0 to disable
+	uint32_t bus_ns;		//!< Bus time that is not yet passed to sim_step_mpu6050
+	uint32_t time_us;		//!< Time since the last sample
+	float mot_ref[3];		//!< Previous accelerometer sample of the motion detection in g
+	uint8_t mot_count;		//!< Amount of samples above the motion threshold
+	uint32_t samples;		//!< Amount of samples
+	
+	uint32_t transactions;	//!< Amount of I2C transactions
+	uint32_t read_bytes;	//!< Amount of register bytes that are read
+	uint32_t write_bytes;	//!< Amount of register bytes that are written
+	uint32_t wire_bytes;	//!< Amount of bytes on the bus, including the address and register bytes
+	uint32_t nacks;			//!< Amount of transactions to another address
+	
+	uint16_t fail_count;	//!< Amount of following transactions that fail with fail_status
+	uint8_t fail_status;	//!< Status code of the TWI library of the failing transactions
+	uint8_t stuck;			//!< 1 if SDA is held low, every transaction returns BUS_IN_USE until the bus is recovered
+	uint32_t recoveries;	//!< Amount of bus recoveries
+	
+	uint8_t async_pending;	//!< 1 while an asynchronous read waits for sim_isr_async_mpu6050
+	uint8_t async_addr;		//!< Address of the asynchronous read
+	uint8_t async_reg;		//!< First register of the asynchronous read
+	uint8_t *async_data;	//!< Pointer to store the register values of the asynchronous read
+	uint16_t async_len;		//!< Amount of registers of the asynchronous read
+	mpu6050_done_t async_done;	//!< Called when the asynchronous read is finished
+	void *async_arg;		//!< Passed to async_done
+} mpu6050_sim_t;
+
+/*! \brief  State of a simulated USART with a DMA channel, for use as stream sink
+ *
+ *	The bytes are read from the buffer when they are sent, like the DMA channel does, so a buffer that
+ *	is changed while it is sent shows up as wrong bytes in out.
+ */
+typedef struct {
+	uint32_t baud;			//!< Baud rate, a byte takes 10 bits
+	uint8_t *out;			//!< Buffer that receives the sent bytes
+	uint32_t size;			//!< Size of out
+	uint32_t len;			//!< Amount of bytes in out
+	const uint8_t *src;		//!< Next byte of the running transfer
+	uint16_t remaining;		//!< Bytes left in the running transfer
+	uint32_t ns;			//!< Time that is not yet used to send a byte
+	uint32_t transfers;		//!< Amount of started transfers
+	uint32_t overruns;		//!< Amount of bytes that did not fit in out
+} mpu6050_sim_usart_t;
+
+void sim_init_mpu6050(mpu6050_sim_t *sim, uint8_t addr);
+void sim_reset_mpu6050(mpu6050_sim_t *sim);
+void sim_bus_mpu6050(mpu6050_sim_t *sim, mpu6050_bus_t *bus);
+void sim_clear_counters_mpu6050(mpu6050_sim_t *sim);
+
+uint8_t sim_read_mpu6050(void *ctx, uint8_t addr, uint8_t reg, uint8_t *data, uint16_t len);
+uint8_t sim_write_mpu6050(void *ctx, uint8_t addr, uint8_t reg, const uint8_t *data, uint16_t len);
+uint8_t sim_recover_mpu6050(void *ctx);
+uint8_t sim_read_async_mpu6050(void *ctx, uint8_t addr, uint8_t reg, uint8_t *data, uint16_t len, mpu6050_done_t done, void *arg);
+void sim_isr_async_mpu6050(mpu6050_sim_t *sim);
+
+uint32_t sim_period_us_mpu6050(mpu6050_sim_t *sim);
+void sim_sample_mpu6050(mpu6050_sim_t *sim);
+void sim_step_mpu6050(mpu6050_sim_t *sim, uint32_t us);
+void sim_fifo_push_mpu6050(mpu6050_sim_t *sim, const uint8_t *data, uint16_t len);
+uint8_t sim_int_pin_mpu6050(mpu6050_sim_t *sim);
+
+void sim_usart_init_mpu6050(mpu6050_sim_usart_t *usart, uint32_t baud, uint8_t *out, uint32_t size);
+void sim_usart_sink_mpu6050(mpu6050_sim_usart_t *usart, mpu6050_sink_t *sink);
+void sim_usart_step_mpu6050(mpu6050_sim_usart_t *usart, uint32_t us);
+
+#endif /* MPU6050_SIM_H_ */
@@ -0,0 +1,154 @@
+/*!
+ *  \file    mpu6050_store.c
+ *  \author  Tycho Jobsis
+ *  \date    04-04-2021
+ *  \version 0.1.0
+ *
+ *  \brief   Storage backends for the calibration record of the MPU6050 library
+ *
+ *  \details The EEPROM backend uses the EEPROM of the Xmega, the file backend uses a file on the host.
+ */
+
+/*!	\copyright
+ *
+ *	MIT License
+ *
+ *	Copyright (c) 2021 TychoJ
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#ifdef __AVR__
+#include <avr/eeprom.h>
+#else
+#include <stdio.h>
+#endif
+
+#include "mpu6050_store.h"
+
+/*! \brief  Calculates the CRC-16/CCITT of a block of bytes
+ *
+ *	Polynomial 0x1021 with start value 0xFFFF.
+ *
+ *  \param  *data	pointer to the bytes
+ *	\param	len		amount of bytes
+ *
+ *  \return CRC of the bytes
+ */
+uint16_t crc16_mpu6050(const uint8_t *data, uint16_t len){
+	uint16_t crc = 0xFFFF;
+	
+	for(uint16_t i = 0; i < len; i++){
+		crc ^= (uint16_t) data[i] << 8;
+		for(uint8_t bit = 0; bit < 8; bit++){
+			if(crc & 0x8000) crc = (crc << 1) ^ 0x1021;
+			else crc <<= 1;
+		}
+	}
+	
+	return crc;
+}
+
+#ifdef __AVR__
+
+/*! \brief  Reads bytes from the EEPROM
+ *
+ *  \param  *ctx	EEPROM address where the storage starts
+ *	\param	pos		byte offset from the start of the storage
+ *	\param	*data	pointer to store the bytes
+ *	\param	len		amount of bytes
+ *
+ *  \return always 0
+ */
+uint8_t store_eeprom_read_mpu6050(void *ctx, uint16_t pos, uint8_t *data, uint16_t len){
+	uint16_t addr = (uint16_t) (uintptr_t) ctx + pos;
+	
+	eeprom_read_block(data, (const void *) addr, len);
+	
+	return 0;
+}
+
+/*! \brief  Writes bytes to the EEPROM
+ *
+ *	Only bytes that changed are written to save EEPROM write cycles.
+ *
+ *  \param  *ctx	EEPROM address where the storage starts
+ *	\param	pos		byte offset from the start of the storage
+ *	\param	*data	pointer to the bytes
+ *	\param	len		amount of bytes
+ *
+ *  \return always 0
+ */
+uint8_t store_eeprom_write_mpu6050(void *ctx, uint16_t pos, const uint8_t *data, uint16_t len){
+	uint16_t addr = (uint16_t) (uintptr_t) ctx + pos;
+	
+	eeprom_update_block(data, (void *) addr, len);
+	
+	return 0;
+}
+
+#else
+
+/*! \brief  Reads bytes from a file
+ *
+ *  \param  *ctx	path of the file
+ *	\param	pos		byte offset from the start of the file
+ *	\param	*data	pointer to store the bytes
+ *	\param	len		amount of bytes
+ *
+ *  \return 0 if succeeded, 1 if the file could not be opened or is too short
+ */
+uint8_t store_file_read_mpu6050(void *ctx, uint16_t pos, uint8_t *data, uint16_t len){
+	FILE *file = fopen((const char *) ctx, "rb");
+	uint8_t err = 0;
+	
+	if(file == 0) return 1;
+	
+	if(fseek(file, pos, SEEK_SET) != 0 || fread(data, 1, len, file) != len) err = 1;
+	
+	fclose(file);
+	
+	return err;
+}
+
+/*! \brief  Writes bytes to a file
+ *
+ *	The file is created if it does not exist.
+ *
+ *  \param  *ctx	path of the file
+ *	\param	pos		byte offset from the start of the file
+ *	\param	*data	pointer to the bytes
+ *	\param	len		amount of bytes
+ *
+ *  \return 0 if succeeded, 1 if the file could not be written
+ */
+uint8_t store_file_write_mpu6050(void *ctx, uint16_t pos, const uint8_t *data, uint16_t len){
+	FILE *file = fopen((const char *) ctx, "r+b");
+	uint8_t err = 0;
+	
+	if(file == 0) file = fopen((const char *) ctx, "w+b");
+	if(file == 0) return 1;
+	
+	if(fseek(file, pos, SEEK_SET) != 0 || fwrite(data, 1, len, file) != len) err = 1;
+	if(fclose(file) != 0) err = 1;
+	
+	return err;
+}
+
+#endif
@@ -0,0 +1,70 @@
+/*!
+ *  \file    mpu6050_store.h
+ *  \author  Tycho Jobsis
+ *  \date    04-04-2021
+ *  \version 0.1.0
+ *
+ *  \brief   Storage backends for the calibration record of the MPU6050 library
+ *
+ *  \details A backend is a read and a write function with a context pointer. The library
+ *			 uses it to keep the calibration of an MPU6050 over a power cycle.
+ *			 On the Xmega the EEPROM backend is available, on other platforms the file backend.
+ *
+ *	\code{.c}
+ 	const mpu6050_store_t store = { store_eeprom_read_mpu6050, store_eeprom_write_mpu6050, (void *) 0x0000 };
+ 	mpu.store = &store;
+ 	\endcode
+ */
+
+/*!	\copyright
+ *
+ *	MIT License
+ *
+ *	Copyright (c) 2021 TychoJ <br>
+ *  
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy <br>
+ *	of this software and associated documentation files (the "Software"), to deal <br>
+ *	in the Software without restriction, including without limitation the rights <br>
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell <br>
+ *	copies of the Software, and to permit persons to whom the Software is <br>
+ *	furnished to do so, subject to the following conditions: <br>
+ *  
+ *	The above copyright notice and this permission notice shall be included in all <br>
+ *	copies or substantial portions of the Software. <br>
+ *  
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR <br>
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, <br>
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE <br>
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER <br>
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, <br>
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE <br>
+ *	SOFTWARE.<br>
+ */
+
+#include <stdint.h>
+
+#ifndef MPU6050_STORE_H_
+#define MPU6050_STORE_H_
+
+/*! \brief  Storage backend
+ *
+ *	Both functions return 0 if succeeded and something else if the data could not be read or written.
+ *	pos is the byte offset from the start of the storage of the backend.
+ */
+typedef struct {
+	uint8_t (*read)(void *ctx, uint16_t pos, uint8_t *data, uint16_t len);			//!< Reads len bytes from pos
+	uint8_t (*write)(void *ctx, uint16_t pos, const uint8_t *data, uint16_t len);	//!< Writes len bytes to pos
+	void *ctx;	//!< Passed to read and write, the meaning depends on the backend
+} mpu6050_store_t;
+
+uint16_t crc16_mpu6050(const uint8_t *data, uint16_t len);
+
+#ifdef __AVR__
+uint8_t store_eeprom_read_mpu6050(void *ctx, uint16_t pos, uint8_t *data, uint16_t len);
+uint8_t store_eeprom_write_mpu6050(void *ctx, uint16_t pos, const uint8_t *data, uint16_t len);
+#else
+uint8_t store_file_read_mpu6050(void *ctx, uint16_t pos, uint8_t *data, uint16_t len);
+uint8_t store_file_write_mpu6050(void *ctx, uint16_t pos, const uint8_t *data, uint16_t len);
+#endif
+
+#endif /* MPU6050_STORE_H_ */
@@ -0,0 +1,236 @@
+/*!
+ *  \file    mpu6050_stream.c
+ *  \author  Tycho Jobsis
+ *  \date    04-04-2021
+ *  \version 0.1.0
+ *
+ *  \brief   Binary streaming of raw MPU6050 frames through a DMA channel and a USART
+ *
+ *  \details The buffer that is filled is never the buffer in the sink: a buffer is only handed to the sink
+ *			 when the sink is idle, and from then on the frames go to the other buffer.
+ */
+
+/*!	\copyright
+ *
+ *	MIT License
+ *
+ *	Copyright (c) 2021 TychoJ
+ *
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy
+ *	of this software and associated documentation files (the "Software"), to deal
+ *	in the Software without restriction, including without limitation the rights
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *	copies of the Software, and to permit persons to whom the Software is
+ *	furnished to do so, subject to the following conditions:
+ *
+ *	The above copyright notice and this permission notice shall be included in all
+ *	copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *	SOFTWARE.
+ */
+
+#include "mpu6050_stream.h"
+#include "mpu6050_store.h"
+
+#ifdef __AVR__
+/*! \brief  Starts a DMA transfer of a buffer to the USART
+ *
+ *	\note	This function is for internal use
+ *
+ *  \param  *ctx	pointer to the mpu6050_dma_sink_t
+ *	\param	*data	pointer to the bytes
+ *	\param	len		amount of bytes
+ *
+ *  \return 0 if the transfer is started, 1 if the previous transfer is not finished
+ */
+static uint8_t dma_start_mpu6050(void *ctx, const uint8_t *data, uint16_t len){
+	DMA_CH_t *ch = ((mpu6050_dma_sink_t *) ctx)->ch;
+	uint16_t src = (uint16_t) data;
+	
+	if(ch->CTRLA & DMA_CH_ENABLE_bm) return 1;
+	
+	ch->CTRLB |= DMA_CH_TRNIF_bm | DMA_CH_ERRIF_bm;	//!< Clear the flags of the previous transfer
+	ch->SRCADDR0 = src & 0xFF;
+	ch->SRCADDR1 = src >> 8;
+	ch->SRCADDR2 = 0;
+	ch->TRFCNT = len;
+	ch->CTRLA = DMA_CH_ENABLE_bm | DMA_CH_SINGLE_bm | DMA_CH_BURSTLEN_1BYTE_gc;	//!< One byte every time DATA is empty
+	
+	return 0;
+}
+
+/*! \brief  Checks if the DMA transfer is still running
+ *
+ *	\note	This function is for internal use
+ *
+ *  \param  *ctx	pointer to the mpu6050_dma_sink_t
+ *
+ *  \return 1 while the DMA channel is enabled, 0 otherwise
+ */
+static uint8_t dma_busy_mpu6050(void *ctx){
+	return (((mpu6050_dma_sink_t *) ctx)->ch->CTRLA & DMA_CH_ENABLE_bm) != 0;	//!< The channel disables itself after the last byte
+}
+
+/*! \brief  Makes a sink of a DMA channel and a USART
+ *
+ *	The DMA controller is enabled and the channel is set up to copy bytes to the DATA register of the USART
+ *	on its data register empty trigger. The USART needs to be configured with its transmitter enabled.
+ *
+ *  \param  *dma	pointer to store the DMA channel and the USART, needs to stay valid while the sink is used
+ *	\param	*sink	pointer to store the sink, use it with stream_init_mpu6050
+ *	\param	*ch		pointer to the DMA channel, for example &DMA.CH0
+ *	\param	*usart	pointer to the USART, for example &USARTC0
+ *	\param	trigger	data register empty trigger of the USART, for example DMA_CH_TRIGSRC_USARTC0_DRE_gc
+ */
+void stream_dma_sink_mpu6050(mpu6050_dma_sink_t *dma, mpu6050_sink_t *sink, DMA_CH_t *ch, USART_t *usart, uint8_t trigger){
+	uint16_t dest = (uint16_t) &usart->DATA;
+	
+	dma->ch = ch;
+	dma->usart = usart;
+	
+	DMA.CTRL |= DMA_ENABLE_bm;
+	
+	ch->CTRLA = 0;
+	ch->ADDRCTRL = DMA_CH_SRCRELOAD_NONE_gc | DMA_CH_SRCDIR_INC_gc | DMA_CH_DESTRELOAD_NONE_gc | DMA_CH_DESTDIR_FIXED_gc;
+	ch->TRIGSRC = trigger;
+	ch->REPCNT = 1;
+	ch->DESTADDR0 = dest & 0xFF;
+	ch->DESTADDR1 = dest >> 8;
+	ch->DESTADDR2 = 0;
+	
+	sink->start = dma_start_mpu6050;
+	sink->busy = dma_busy_mpu6050;
+	sink->ctx = dma;
+}
+#endif
+
+/*! \brief  Initializes a stream
+ *
+ *  \param  *stream	pointer to the stream
+ *	\param	*sink	pointer to the sink, it is copied
+ *	\param	*buff0	pointer to the first buffer
+ *	\param	*buff1	pointer to the second buffer
+ *	\param	size	size of one buffer, at least MPU6050_STREAM_FRAME bytes
+ */
+void stream_init_mpu6050(mpu6050_stream_t *stream, const mpu6050_sink_t *sink, uint8_t *buff0, uint8_t *buff1, uint16_t size){
+	stream->sink = *sink;
+	stream->buff[0] = buff0;
+	stream->buff[1] = buff1;
+	stream->size = size;
+	stream->pos = 0;
+	stream->fill = 0;
+	stream->seq = 0;
+	stream->sent = 0;
+	stream->dropped = 0;
+}
+
+/*! \brief  Hands the filled buffer to the sink if the sink is idle
+ *
+ *	Call this function regularly, for example from the main loop, so frames do not wait until a buffer is full.
+ *	While the sink sends one buffer the frames are collected in the other one.
+ *
+ *  \param  *stream	pointer to the stream
+ *
+ *  \return 1 if a buffer was handed to the sink, 0 otherwise
+ */
+uint8_t stream_poll_mpu6050(mpu6050_stream_t *stream){
+	if(stream->pos == 0) return 0;
+	if(stream->sink.busy(stream->sink.ctx)) return 0;
+	if(stream->sink.start(stream->sink.ctx, stream->buff[stream->fill], stream->pos) != 0) return 0;
+	
+	stream->sent += stream->pos / MPU6050_STREAM_FRAME;
+	stream->fill ^= 1;
+	stream->pos = 0;
+	
+	return 1;
+}
+
+/*! \brief  Stores a 16 bit value little endian
+ *
+ *	\note	This function is for internal use
+ *
+ *  \param  *buff	pointer to store the value
+ *	\param	value	value that needs to be stored
+ *
+ *  \return pointer behind the value
+ */
+static uint8_t *put16_stream_mpu6050(uint8_t *buff, uint16_t value){
+	*buff++ = value & 0xFF;
+	*buff++ = value >> 8;
+	return buff;
+}
+
+/*! \brief  Packs a frame into the buffer that is filled
+ *
+ *	If the buffer is full it is handed to the sink first. When the sink is still sending the other buffer 
+ *	the frame is dropped and counted in dropped.
+ *
+ *  \param  *stream	pointer to the stream
+ *	\param	*frame	pointer to the raw frame
+ *
+ *  \return 0 if succeeded, MPU6050_STREAM_FULL if the frame is dropped
+ */
+uint8_t stream_put_mpu6050(mpu6050_stream_t *stream, const mpu6050_motion_t *frame){
+	uint8_t *start, *pos;
+	
+	if(stream->pos + MPU6050_STREAM_FRAME > stream->size){
+		if(stream_poll_mpu6050(stream) == 0){
+			stream->dropped++;
+			return MPU6050_STREAM_FULL;
+		}
+	}
+	
+	start = stream->buff[stream->fill] + stream->pos;
+	pos = start;
+	
+	*pos++ = MPU6050_STREAM_SYNC0;
+	*pos++ = MPU6050_STREAM_SYNC1;
+	*pos++ = stream->seq++;
+	*pos++ = MPU6050_STREAM_MOTION;
+	pos = put16_stream_mpu6050(pos, frame->time_us & 0xFFFF);
+	pos = put16_stream_mpu6050(pos, frame->time_us >> 16);
+	for(uint8_t i = 0; i < 3; i++) pos = put16_stream_mpu6050(pos, frame->accel[i]);
+	pos = put16_stream_mpu6050(pos, frame->temp);
+	for(uint8_t i = 0; i < 3; i++) pos = put16_stream_mpu6050(pos, frame->gyro[i]);
+	put16_stream_mpu6050(pos, crc16_mpu6050(start + 2, MPU6050_STREAM_FRAME - 4));
+	
+	stream->pos += MPU6050_STREAM_FRAME;
+	
+	return 0;
+}
+
+/*! \brief  Reads a frame that was sent by a stream
+ *
+ *	Meant for the receiving side. When 0 is returned the receiver should skip one byte and try again,
+ *	so it finds the next frame after damaged or lost bytes.
+ *
+ *  \param  *buff	pointer to the received bytes
+ *	\param	len		amount of received bytes from buff
+ *	\param	*frame	pointer to store the frame
+ *	\param	*seq	pointer to store the sequence number of the frame
+ *
+ *  \return 1 if buff starts with a valid frame, 0 otherwise
+ */
+uint8_t stream_parse_mpu6050(const uint8_t *buff, uint16_t len, mpu6050_motion_t *frame, uint8_t *seq){
+	const uint8_t *pos = buff + 4;
+	
+	if(len < MPU6050_STREAM_FRAME) return 0;
+	if(buff[0] != MPU6050_STREAM_SYNC0 || buff[1] != MPU6050_STREAM_SYNC1 || buff[3] != MPU6050_STREAM_MOTION) return 0;
+	if((buff[MPU6050_STREAM_FRAME - 2] | ((uint16_t) buff[MPU6050_STREAM_FRAME - 1] << 8)) != crc16_mpu6050(buff + 2, MPU6050_STREAM_FRAME - 4)) return 0;
+	
+	*seq = buff[2];
+	frame->time_us = (uint32_t) pos[0] | ((uint32_t) pos[1] << 8) | ((uint32_t) pos[2] << 16) | ((uint32_t) pos[3] << 24);
+	pos += 4;
+	for(uint8_t i = 0; i < 3; i++, pos += 2) frame->accel[i] = (int16_t) (pos[0] | (pos[1] << 8));
+	frame->temp = (int16_t) (pos[0] | (pos[1] << 8));
+	pos += 2;
+	for(uint8_t i = 0; i < 3; i++, pos += 2) frame->gyro[i] = (int16_t) (pos[0] | (pos[1] << 8));
+	
+	return 1;
+}
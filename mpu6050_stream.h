@@ -0,0 +1,110 @@
+/*!
+ *  \file    mpu6050_stream.h
+ *  \author  Tycho Jobsis
+ *  \date    04-04-2021
+ *  \version 0.1.0
+ *
+ *  \brief   Binary streaming of raw MPU6050 frames through a DMA channel and a USART
+ *
+ *  \details Frames are packed in a fixed layout directly into one of two buffers. While the sink sends one
+ *			 buffer the other one is filled, the buffers are swapped when the sink is idle. On the Xmega the sink
+ *			 is a DMA channel that writes the buffer to the DATA register of a USART, so the CPU does not touch the
+ *			 bytes after they are packed. On other platforms the simulated USART of mpu6050_sim.h can be used as sink.
+ *
+ *			 Frame layout (little endian, MPU6050_STREAM_FRAME bytes): sync 0xA5 0x5A (2), sequence number (1),
+ *			 type (1), time stamp in us (4), accelerometer x, y, z, temperature, gyroscope x, y, z (14),
+ *			 CRC-16 of the sequence number up to the gyroscope (2).
+ *
+ *	\code{.c}
+ 	static uint8_t buff[2][240];
+ 	mpu6050_dma_sink_t dma;
+ 	mpu6050_sink_t sink;
+ 	mpu6050_stream_t stream;
+ 	
+ 	// USARTC0 is configured for the baud rate and has its transmitter enabled
+ 	stream_dma_sink_mpu6050(&dma, &sink, &DMA.CH0, &USARTC0, DMA_CH_TRIGSRC_USARTC0_DRE_gc);
+ 	stream_init_mpu6050(&stream, &sink, buff[0], buff[1], sizeof(buff[0]));
+ 	
+ 	while(1){
+ 		if(acq_pop_mpu6050(&mpu, &frame)) stream_put_mpu6050(&stream, &frame);
+ 		stream_poll_mpu6050(&stream);
+ 	}
+ 	\endcode
+ */
+
+/*!	\copyright
+ *
+ *	MIT License
+ *
+ *	Copyright (c) 2021 TychoJ <br>
+ *  
+ *	Permission is hereby granted, free of charge, to any person obtaining a copy <br>
+ *	of this software and associated documentation files (the "Software"), to deal <br>
+ *	in the Software without restriction, including without limitation the rights <br>
+ *	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell <br>
+ *	copies of the Software, and to permit persons to whom the Software is <br>
+ *	furnished to do so, subject to the following conditions: <br>
+ *  
+ *	The above copyright notice and this permission notice shall be included in all <br>
+ *	copies or substantial portions of the Software. <br>
+ *  
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR <br>
+ *	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, <br>
+ *	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE <br>
+ *	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER <br>
+ *	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, <br>
+ *	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE <br>
+ *	SOFTWARE.<br>
+ */
+
+#include "mpu6050.h"
+
+#ifndef MPU6050_STREAM_H_
+#define MPU6050_STREAM_H_
+
+#define MPU6050_STREAM_SYNC0	0xA5
+#define MPU6050_STREAM_SYNC1	0x5A
+#define MPU6050_STREAM_FRAME	24		//!< Bytes in one frame
+#define MPU6050_STREAM_MOTION	1		//!< Type of a frame with raw motion data
+
+/*! \brief  Output that sends a buffer without the CPU
+ *
+ *	start begins sending len bytes from data and returns 0, or returns 1 when the previous transfer is not finished.
+ *	The bytes are read while they are sent, so data may not change until busy returns 0.
+ */
+typedef struct {
+	uint8_t (*start)(void *ctx, const uint8_t *data, uint16_t len);	//!< Starts a transfer
+	uint8_t (*busy)(void *ctx);		//!< Returns 1 while a transfer is running
+	void *ctx;	//!< Passed to start and busy, the meaning depends on the sink
+} mpu6050_sink_t;
+
+/*! \brief  State of a double buffered stream
+ */
+typedef struct {
+	mpu6050_sink_t sink;	//!< Output of the buffers
+	uint8_t *buff[2];		//!< The two buffers
+	uint16_t size;			//!< Size of one buffer
+	uint16_t pos;			//!< Bytes in the buffer that is filled
+	uint8_t fill;			//!< Index of the buffer that is filled, the other one can be in the sink
+	uint8_t seq;			//!< Sequence number of the next frame
+	uint32_t sent;			//!< Amount of frames that were handed to the sink
+	uint32_t dropped;		//!< Amount of frames that did not fit in a buffer
+} mpu6050_stream_t;
+
+#ifdef __AVR__
+/*! \brief  DMA channel and USART of the DMA sink
+ */
+typedef struct {
+	DMA_CH_t *ch;		//!< DMA channel that is used
+	USART_t *usart;		//!< USART that sends the bytes
+} mpu6050_dma_sink_t;
+
+void stream_dma_sink_mpu6050(mpu6050_dma_sink_t *dma, mpu6050_sink_t *sink, DMA_CH_t *ch, USART_t *usart, uint8_t trigger);
+#endif
+
+void stream_init_mpu6050(mpu6050_stream_t *stream, const mpu6050_sink_t *sink, uint8_t *buff0, uint8_t *buff1, uint16_t size);
+uint8_t stream_put_mpu6050(mpu6050_stream_t *stream, const mpu6050_motion_t *frame);
+uint8_t stream_poll_mpu6050(mpu6050_stream_t *stream);
+uint8_t stream_parse_mpu6050(const uint8_t *buff, uint16_t len, mpu6050_motion_t *frame, uint8_t *seq);
+
+#endif /* MPU6050_STREAM_H_ */